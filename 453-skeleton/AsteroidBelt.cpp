@@ -0,0 +1,196 @@
+#include "AsteroidBelt.hpp"
+
+#include "Math.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+//======================================================================================================================
+
+AsteroidBelt::AsteroidBelt(double const gravitationalParameter)
+    : mGravitationalParameter(gravitationalParameter)
+{}
+
+//======================================================================================================================
+
+void AsteroidBelt::Generate(Region const region, size_t const count, uint32_t const seed)
+{
+    mRegion = region;
+    mBodies.Clear();
+    ResetInstances();
+    if (region == Region::NONE || count == 0)
+    {
+        return;
+    }
+
+    // Scene units: Mars orbits at 6, Jupiter at 8, Neptune at 14
+    struct Shape
+    {
+        float minRadius, maxRadius;
+        float eccentricitySigma, maxEccentricity;
+        float inclinationSigma; // degrees
+        float minScale, maxScale;
+    };
+    Shape const shape = region == Region::MAIN_BELT
+        ? Shape{6.6f, 7.4f, 0.07f, 0.3f, 8.0f, 0.004f, 0.015f}
+        : Shape{15.0f, 19.0f, 0.08f, 0.25f, 10.0f, 0.008f, 0.025f};
+
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> radius(shape.minRadius, shape.maxRadius);
+    std::normal_distribution<float> eccentricity(0.0f, shape.eccentricitySigma);
+    std::normal_distribution<float> inclination(0.0f, shape.inclinationSigma);
+    std::uniform_real_distribution<double> angle(0.0, glm::two_pi<double>());
+    std::uniform_real_distribution<float> scale(shape.minScale, shape.maxScale);
+
+    mBodies.Reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        double const a = radius(generator);
+        double const e = std::min(std::abs(eccentricity(generator)), shape.maxEccentricity);
+        auto const orbit = Kepler::FromMeanMotion(
+            a,
+            e,
+            std::sqrt(mGravitationalParameter / (a * a * a)),
+            glm::radians(static_cast<double>(std::abs(inclination(generator)))),
+            angle(generator),
+            angle(generator),
+            angle(generator),
+            0.0
+        );
+        mBodies.Add(orbit, BodyTable::Physical{scale(generator), 0.0f, 0.0f});
+    }
+}
+
+//======================================================================================================================
+
+void AsteroidBelt::Load(MinorPlanetCatalog const & catalog, size_t const count, SceneMapping const & mapping)
+{
+    mRegion = Region::CATALOG;
+    mBodies.Clear();
+    ResetInstances();
+
+    size_t const loadCount = std::min(count, catalog.Size());
+    mBodies.Reserve(loadCount);
+    for (size_t i = 0; i < loadCount; ++i)
+    {
+        MinorPlanetCatalog::Orbit const orbit = catalog.Get(i);
+
+        // Real phase at simulation time 0, but the period the scene's Sun gives the mapped distance
+        double const a = mapping.distance(orbit.semiMajorAxis);
+        double const meanAnomaly = orbit.meanAnomaly + orbit.meanMotion * (mapping.epoch - orbit.epoch);
+
+        // Bright (low H) means big, every 5 magnitudes is 10x in diameter. The range is squeezed so the
+        // faint majority stays visible.
+        float const magnitude = std::isnan(orbit.absoluteMagnitude) ? 18.0f : orbit.absoluteMagnitude;
+        float const size = Math::Lerp(0.025f, 0.004f, std::clamp((magnitude - 3.0f) / 15.0f, 0.0f, 1.0f));
+
+        mBodies.Add(
+            Kepler::FromMeanMotion(
+                a,
+                orbit.eccentricity,
+                std::sqrt(mGravitationalParameter / (a * a * a)),
+                orbit.inclination,
+                orbit.longitudeOfAscendingNode,
+                orbit.argumentOfPeriapsis,
+                std::fmod(meanAnomaly, glm::two_pi<double>()),
+                0.0
+            ),
+            BodyTable::Physical{size, 0.0f, 0.0f}
+        );
+    }
+}
+
+//======================================================================================================================
+
+void AsteroidBelt::Update(double const simulationTime)
+{
+    if (mBodies.Size() == 0)
+    {
+        mUpdateTimeMs = 0.0f;
+        return;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+
+    mBodies.Propagate(simulationTime);
+    PackInstances(mBodies.X(), mBodies.Y(), mBodies.Z());
+
+    float const elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    mUpdateTimeMs = Math::Lerp(mUpdateTimeMs, elapsedMs, 0.1f); // smoothed so the readout is legible
+}
+
+//======================================================================================================================
+
+size_t AsteroidBelt::SeedNBody(NBodySystem & system, double const simulationTime, double const mass) const
+{
+    size_t const firstIndex = system.Size();
+    system.Reserve(firstIndex + mBodies.Size());
+    for (size_t i = 0; i < mBodies.Size(); ++i)
+    {
+        // Ids are handed out in order and the belt never removes bodies, so id == index here
+        auto const state = Kepler::Propagate(mBodies.Orbit(static_cast<BodyTable::BodyId>(i)), simulationTime);
+        system.Add(state.position, state.velocity, mass);
+    }
+    return firstIndex;
+}
+
+//======================================================================================================================
+
+void AsteroidBelt::Update(NBodySystem const & system, size_t const firstIndex)
+{
+    if (mBodies.Size() == 0)
+    {
+        mUpdateTimeMs = 0.0f;
+        return;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+
+    PackInstances(system.X() + firstIndex, system.Y() + firstIndex, system.Z() + firstIndex);
+
+    float const elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    mUpdateTimeMs = Math::Lerp(mUpdateTimeMs, elapsedMs, 0.1f);
+}
+
+//======================================================================================================================
+
+void AsteroidBelt::PackInstances(double const * x, double const * y, double const * z)
+{
+    std::swap(mPreviousInstances, mInstances);
+    mInstances.resize(mBodies.Size());
+
+    BodyTable::Physical const * physical = mBodies.Physicals();
+    for (size_t i = 0; i < mInstances.size(); ++i)
+    {
+        mInstances[i] = glm::vec4{Math::ToRenderSpace(x[i], y[i], z[i]), physical[i].radius};
+    }
+
+    // First update of a new belt, there is nothing to blend from
+    if (mPreviousInstances.size() != mInstances.size())
+    {
+        mPreviousInstances = mInstances;
+    }
+}
+
+//======================================================================================================================
+
+void AsteroidBelt::SnapInstances()
+{
+    mPreviousInstances = mInstances;
+    ++mGeneration;
+}
+
+//======================================================================================================================
+
+void AsteroidBelt::ResetInstances()
+{
+    mInstances.clear();
+    mPreviousInstances.clear();
+    ++mGeneration;
+}
+
+//======================================================================================================================
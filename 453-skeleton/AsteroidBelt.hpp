@@ -0,0 +1,97 @@
+#pragma once
+
+#include "BodyTable.hpp"
+#include "MinorPlanetCatalog.hpp"
+#include "NBodySystem.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// A swarm of small bodies on their own orbits.
+//
+// Orbits live in a BodyTable of their own and are propagated every step, then packed into
+// per-instance records (position + scale) for AsteroidRenderer. The record of the step before is
+// kept too, so the renderer can blend between them. Nothing here touches GL, the belt lives on the
+// simulation thread.
+class AsteroidBelt
+{
+public:
+
+    enum class Region
+    {
+        NONE,
+        MAIN_BELT,   // between Mars and Jupiter
+        KUIPER_BELT, // beyond Neptune
+        CATALOG      // real orbits from the MPC catalog
+    };
+
+    // How real orbits are fitted into the scene, which isn't to scale
+    struct SceneMapping
+    {
+        std::function<double(double)> distance{}; // AU to scene units
+        double epoch = 0.0;                       // Julian date at simulation time 0
+    };
+
+    // gravitationalParameter is the Sun's, the one every planet orbit is built with, so the belt keeps
+    // pace with the planets and its N-body seed matches the Sun's mass
+    explicit AsteroidBelt(double gravitationalParameter);
+
+    // Replaces every body, the same seed always gives the same belt
+    void Generate(Region region, size_t count, uint32_t seed = 453);
+
+    // Replaces every body with the first count orbits of the catalog
+    void Load(MinorPlanetCatalog const & catalog, size_t count, SceneMapping const & mapping);
+
+    void Update(double simulationTime);
+
+    // Adds every body to an N-body system with its state at the given time, returns the index of the first one
+    size_t SeedNBody(NBodySystem & system, double simulationTime, double mass) const;
+
+    // Takes positions from an N-body system seeded by SeedNBody instead of following the orbits
+    void Update(NBodySystem const & system, size_t firstIndex);
+
+    // Makes the previous state equal to the latest, so a jump isn't blended
+    void SnapInstances();
+
+    [[nodiscard]]
+    Region GetRegion() const { return mRegion; }
+
+    [[nodiscard]]
+    size_t Count() const { return mBodies.Size(); }
+
+    // CPU time of the last Update (propagation + packing), smoothed over a few frames
+    [[nodiscard]]
+    float UpdateTimeMs() const { return mUpdateTimeMs; }
+
+    // xyz = position (render space), w = scale
+    [[nodiscard]]
+    std::vector<glm::vec4> const & Instances() const { return mInstances; }
+
+    // Same, one update earlier
+    [[nodiscard]]
+    std::vector<glm::vec4> const & PreviousInstances() const { return mPreviousInstances; }
+
+    // Changes whenever the previous state doesn't come from the update before (new belt, snap)
+    [[nodiscard]]
+    uint64_t Generation() const { return mGeneration; }
+
+private:
+
+    // Fills the instance buffer from heliocentric positions in the orbit frame, the old contents become the previous state
+    void PackInstances(double const * x, double const * y, double const * z);
+
+    // Drops both states, the next update starts over without a previous one
+    void ResetInstances();
+
+    double mGravitationalParameter = 0.0;
+    Region mRegion = Region::NONE;
+
+    BodyTable mBodies{};
+    std::vector<glm::vec4> mInstances{};
+    std::vector<glm::vec4> mPreviousInstances{};
+    uint64_t mGeneration = 0;
+    float mUpdateTimeMs = 0.0f;
+};
@@ -0,0 +1,103 @@
+#include "AsteroidRenderer.hpp"
+
+#include "AssetPath.h"
+#include "GLState.hpp"
+#include "ShapeGenerator.hpp"
+
+// Per-instance attribute slots, right after the ones GPU_Geometry uses
+static constexpr GLuint InstanceAttribute = 4;
+static constexpr GLuint PreviousInstanceAttribute = 5;
+
+//======================================================================================================================
+
+AsteroidRenderer::AsteroidRenderer()
+{
+    // Compiles while the rest of startup goes on, the belt shows up once it's done
+    mShader = std::make_unique<ShaderProgram>(
+        deferredLink,
+        AssetPath::Instance()->Get("shaders/asteroid.vert"),
+        AssetPath::Instance()->Get("shaders/asteroid.frag")
+    );
+
+    // Rocks are a few pixels wide at most, a coarse sphere is plenty
+    auto const sphere = ShapeGenerator::Sphere(1.0f, 8, 6);
+    mGeometry = std::make_unique<GPU_Geometry>();
+    mGeometry->Update(sphere);
+    mIndexCount = static_cast<int>(sphere.indices.size());
+
+    // The instance streams hang off the sphere's VAO and advance once per instance. Which buffer feeds
+    // which attribute is decided at upload time.
+    mGeometry->bind();
+    for (GLuint const attribute : {InstanceAttribute, PreviousInstanceAttribute})
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    GLState::Instance()->BindVertexArray(0);
+
+    for (GpuMemory::Allocation & memory : mInstanceMemory)
+    {
+        memory = GpuMemory::Allocation(GpuMemory::Category::VERTEX_BUFFER, "Asteroid instances");
+    }
+}
+
+//======================================================================================================================
+
+void AsteroidRenderer::Render(
+    std::vector<glm::vec4> const & instances,
+    std::vector<glm::vec4> const & previousInstances,
+    uint64_t const step,
+    uint64_t const generation
+)
+{
+    if (instances.empty() || mShader->poll() == false)
+    {
+        return;
+    }
+
+    bool const uploaded = mUploadedOnce && step == mUploadedStep && generation == mUploadedGeneration;
+    if (uploaded == false)
+    {
+        // The buffer holding the older state takes the latest one. The previous state is already on the
+        // GPU if it is the step uploaded last time, otherwise it has to go too.
+        bool const nextStep = mUploadedOnce && step == mUploadedStep + 1 && generation == mUploadedGeneration;
+        mLatestBuffer ^= 1;
+        GLuint const latest = mInstanceBuffers[mLatestBuffer];
+        GLuint const previous = mInstanceBuffers[mLatestBuffer ^ 1];
+        Upload(mLatestBuffer, instances);
+        if (nextStep == false)
+        {
+            Upload(mLatestBuffer ^ 1, previousInstances.size() == instances.size() ? previousInstances : instances);
+        }
+        mUploadedOnce = true;
+        mUploadedStep = step;
+        mUploadedGeneration = generation;
+
+        mGeometry->bind();
+        glBindBuffer(GL_ARRAY_BUFFER, latest);
+        glVertexAttribPointer(InstanceAttribute, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), nullptr);
+        glBindBuffer(GL_ARRAY_BUFFER, previous);
+        glVertexAttribPointer(PreviousInstanceAttribute, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), nullptr);
+        GLState::Instance()->BindVertexArray(0);
+    }
+
+    mShader->use();
+
+    mGeometry->bind();
+    glDrawElementsInstanced(GL_TRIANGLES, mIndexCount, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(instances.size()));
+    GLState::Instance()->BindVertexArray(0);
+}
+
+//======================================================================================================================
+
+void AsteroidRenderer::Upload(size_t const buffer, std::vector<glm::vec4> const & instances)
+{
+    // Orphan the old storage so the driver doesn't stall on draws still reading it
+    auto const size = static_cast<GLsizeiptr>(instances.size() * sizeof(glm::vec4));
+    glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffers[buffer]);
+    glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, instances.data());
+    mInstanceMemory[buffer].Resize(static_cast<size_t>(size));
+}
+
+//======================================================================================================================
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "GLHandles.h"
+#include "Geometry.h"
+#include "GpuMemory.hpp"
+#include "ShaderProgram.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Draws the instance records AsteroidBelt packs, one instanced call of a low-poly sphere.
+//
+// The latest and previous records live in two GPU buffers that trade places whenever a new step
+// arrives, so when steps come one at a time only the latest record is sent.
+class AsteroidRenderer
+{
+public:
+
+    explicit AsteroidRenderer();
+
+    // step is the simulation update the instances were packed at, generation is AsteroidBelt::Generation
+    // at that step. Together they tell whether the buffers already hold some of this. Camera and the blend between the two
+    // records come from the frame uniform block.
+    void Render(
+        std::vector<glm::vec4> const & instances,
+        std::vector<glm::vec4> const & previousInstances,
+        uint64_t step,
+        uint64_t generation
+    );
+
+private:
+
+    void Upload(size_t buffer, std::vector<glm::vec4> const & instances);
+
+    std::unique_ptr<ShaderProgram> mShader{};
+    std::unique_ptr<GPU_Geometry> mGeometry{};
+    int mIndexCount = 0;
+
+    std::array<VertexBufferHandle, 2> mInstanceBuffers{};
+    std::array<GpuMemory::Allocation, 2> mInstanceMemory{};
+    size_t mLatestBuffer = 0;
+    bool mUploadedOnce = false;
+    uint64_t mUploadedStep = 0;
+    uint64_t mUploadedGeneration = 0;
+};
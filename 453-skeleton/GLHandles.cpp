@@ -1,5 +1,7 @@
 #include "GLHandles.h"
 
+#include "GLState.hpp"
+
 #include <algorithm> // For std::swap
 
 ShaderHandle::ShaderHandle(GLenum type)
@@ -59,6 +61,7 @@ ShaderProgramHandle& ShaderProgramHandle::operator=(ShaderProgramHandle&& other)
 
 ShaderProgramHandle::~ShaderProgramHandle() {
 	glDeleteProgram(programID);
+	if (programID != 0) GLState::ObjectDeleted(); // the name can come back for a new object
 }
 
 
@@ -96,6 +99,7 @@ VertexArrayHandle& VertexArrayHandle::operator=(VertexArrayHandle&& other) noexc
 
 VertexArrayHandle::~VertexArrayHandle() {
 	glDeleteVertexArrays(1, &vaoID);
+	if (vaoID != 0) GLState::ObjectDeleted();
 }
 
 
@@ -144,39 +148,3 @@ VertexBufferHandle::operator GLuint() const {
 GLuint VertexBufferHandle::value() const {
 	return vboID;
 }
-
-
-//------------------------------------------------------------------------------
-
-TextureHandle::TextureHandle()
-	: textureID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
-{
-	glGenTextures(1, &textureID);
-}
-
-
-TextureHandle::TextureHandle(TextureHandle&& other) noexcept
-	: textureID(std::move(other.textureID))
-{
-	other.textureID = 0;
-}
-
-TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept {
-	std::swap(textureID, other.textureID);
-	return *this;
-}
-
-
-TextureHandle::~TextureHandle() {
-	glDeleteTextures(1, &textureID);
-}
-
-
-TextureHandle::operator GLuint() const {
-	return textureID;
-}
-
-
-GLuint TextureHandle::value() const {
-	return textureID;
-}
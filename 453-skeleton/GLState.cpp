@@ -0,0 +1,156 @@
+#include "GLState.hpp"
+
+#include <stdexcept>
+
+//======================================================================================================================
+
+std::shared_ptr<GLState> GLState::Instance()
+{
+    std::shared_ptr<GLState> shared_ptr = _instance.lock();
+    if (shared_ptr == nullptr)
+    {
+        shared_ptr = std::make_shared<GLState>();
+        _instance = shared_ptr;
+    }
+    return shared_ptr;
+}
+
+//======================================================================================================================
+
+GLState::GLState()
+{
+    Invalidate();
+}
+
+//======================================================================================================================
+
+void GLState::UseProgram(GLuint const program)
+{
+    if (program == mProgram)
+    {
+        ++mFrame.skipped;
+        return;
+    }
+    glUseProgram(program);
+    mProgram = program;
+    ++mFrame.programs;
+}
+
+//======================================================================================================================
+
+void GLState::BindVertexArray(GLuint const vertexArray)
+{
+    if (vertexArray == mVertexArray)
+    {
+        ++mFrame.skipped;
+        return;
+    }
+    glBindVertexArray(vertexArray);
+    mVertexArray = vertexArray;
+    ++mFrame.vertexArrays;
+}
+
+//======================================================================================================================
+
+void GLState::BindTexture(GLuint const unit, GLuint const texture)
+{
+    BindTarget(GL_TEXTURE_2D, mTextures, unit, texture);
+}
+
+//======================================================================================================================
+
+void GLState::BindTextureArray(GLuint const unit, GLuint const texture)
+{
+    BindTarget(GL_TEXTURE_2D_ARRAY, mTextureArrays, unit, texture);
+}
+
+//======================================================================================================================
+
+void GLState::BindTarget(
+    GLenum const target,
+    std::array<GLuint, MaxTextureUnits> & bound,
+    GLuint const unit,
+    GLuint const texture
+)
+{
+    if (unit >= MaxTextureUnits)
+    {
+        throw std::out_of_range("GLState: texture unit out of range");
+    }
+    if (bound[unit] == texture)
+    {
+        ++mFrame.skipped;
+        return;
+    }
+    if (mActiveUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        mActiveUnit = unit;
+    }
+    glBindTexture(target, texture);
+    bound[unit] = texture;
+    ++mFrame.textures;
+}
+
+//======================================================================================================================
+
+void GLState::SetEnabled(GLenum const capability, bool const enabled)
+{
+    Toggle * cached = capability == GL_BLEND ? &mBlend : capability == GL_DEPTH_TEST ? &mDepthTest : nullptr;
+    Toggle const wanted = enabled ? Toggle::ON : Toggle::OFF;
+    if (cached != nullptr && *cached == wanted)
+    {
+        ++mFrame.skipped;
+        return;
+    }
+
+    if (enabled)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+    if (cached != nullptr)
+    {
+        *cached = wanted;
+    }
+    if (capability == GL_BLEND)
+    {
+        ++mFrame.blendToggles;
+    }
+}
+
+//======================================================================================================================
+
+void GLState::Invalidate()
+{
+    mProgram = Unknown;
+    mVertexArray = Unknown;
+    mActiveUnit = Unknown;
+    mTextures.fill(Unknown);
+    mTextureArrays.fill(Unknown);
+    mBlend = Toggle::UNKNOWN;
+    mDepthTest = Toggle::UNKNOWN;
+}
+
+//======================================================================================================================
+
+void GLState::ObjectDeleted()
+{
+    if (std::shared_ptr<GLState> const state = _instance.lock())
+    {
+        state->Invalidate();
+    }
+}
+
+//======================================================================================================================
+
+void GLState::EndFrame()
+{
+    mLastFrame = mFrame;
+    mFrame = Counters{};
+}
+
+//======================================================================================================================
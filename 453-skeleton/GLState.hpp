@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+// Shadow copy of the GL bindings the renderer changes most, so binding what is already bound costs
+// nothing. Textures, VertexArray and ShaderProgram bind through here, and so do the blend and depth
+// toggles in Render.
+//
+// Anything that changes these bindings behind its back has to call Invalidate. ImGui's backend
+// restores what it touches, so it doesn't. Deleting a GL object invalidates too, since the next
+// object made can get the same name.
+//
+// GL thread only.
+class GLState
+{
+public:
+
+    // Calls that reached GL in one frame
+    struct Counters
+    {
+        size_t programs = 0;
+        size_t vertexArrays = 0;
+        size_t textures = 0;
+        size_t blendToggles = 0;
+        size_t skipped = 0; // calls dropped because nothing would change
+    };
+
+    static std::shared_ptr<GLState> Instance();
+
+    explicit GLState();
+
+    GLState(GLState const &) = delete;
+    GLState & operator=(GLState const &) = delete;
+    GLState(GLState &&) = delete;
+    GLState & operator=(GLState &&) = delete;
+
+    void UseProgram(GLuint program);
+
+    void BindVertexArray(GLuint vertexArray);
+
+    // GL_TEXTURE_2D on the given unit
+    void BindTexture(GLuint unit, GLuint texture);
+
+    // GL_TEXTURE_2D_ARRAY on the given unit, tracked apart from the 2D binding GL keeps next to it
+    void BindTextureArray(GLuint unit, GLuint texture);
+
+    // GL_BLEND and GL_DEPTH_TEST are tracked, anything else goes straight through
+    void SetEnabled(GLenum capability, bool enabled);
+
+    // Forgets everything, the next call of each kind reaches GL
+    void Invalidate();
+
+    // For the destructors of GL objects, does nothing when there is no GLState
+    static void ObjectDeleted();
+
+    // Finishes the frame's counters and starts new ones
+    void EndFrame();
+
+    [[nodiscard]]
+    Counters const & LastFrame() const { return mLastFrame; }
+
+private:
+
+    inline static std::weak_ptr<GLState> _instance{};
+
+    static constexpr GLuint Unknown = std::numeric_limits<GLuint>::max();
+    static constexpr size_t MaxTextureUnits = 16; // the minimum GL 3.3 guarantees for fragment shaders
+
+    enum class Toggle : int8_t
+    {
+        UNKNOWN = -1,
+        OFF = 0,
+        ON = 1
+    };
+
+    GLuint mProgram = Unknown;
+    GLuint mVertexArray = Unknown;
+    GLuint mActiveUnit = Unknown;
+    std::array<GLuint, MaxTextureUnits> mTextures{};
+    std::array<GLuint, MaxTextureUnits> mTextureArrays{};
+    Toggle mBlend = Toggle::UNKNOWN;
+    Toggle mDepthTest = Toggle::UNKNOWN;
+
+    Counters mFrame{};
+    Counters mLastFrame{};
+
+    void BindTarget(GLenum target, std::array<GLuint, MaxTextureUnits> & bound, GLuint unit, GLuint texture);
+};
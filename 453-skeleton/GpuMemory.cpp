@@ -0,0 +1,167 @@
+#include "GpuMemory.hpp"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+//======================================================================================================================
+
+GpuMemory::Allocation::Allocation(Category const category, std::string name)
+    : mMemory(GpuMemory::Instance())
+{
+    mId = mMemory->Add(category, std::move(name));
+}
+
+//======================================================================================================================
+
+GpuMemory::Allocation::~Allocation()
+{
+    Release();
+}
+
+//======================================================================================================================
+
+GpuMemory::Allocation::Allocation(Allocation && other) noexcept
+    : mMemory(std::move(other.mMemory))
+    , mId(std::exchange(other.mId, 0))
+{}
+
+//======================================================================================================================
+
+GpuMemory::Allocation & GpuMemory::Allocation::operator=(Allocation && other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        mMemory = std::move(other.mMemory);
+        mId = std::exchange(other.mId, 0);
+    }
+    return *this;
+}
+
+//======================================================================================================================
+
+void GpuMemory::Allocation::Resize(size_t const bytes)
+{
+    if (mMemory != nullptr)
+    {
+        mMemory->Resize(mId, bytes);
+    }
+}
+
+//======================================================================================================================
+
+void GpuMemory::Allocation::Release()
+{
+    if (mMemory != nullptr)
+    {
+        mMemory->Remove(mId);
+        mMemory.reset();
+        mId = 0;
+    }
+}
+
+//======================================================================================================================
+
+std::shared_ptr<GpuMemory> GpuMemory::Instance()
+{
+    std::shared_ptr<GpuMemory> shared_ptr = _instance.lock();
+    if (shared_ptr == nullptr)
+    {
+        shared_ptr = std::make_shared<GpuMemory>();
+        _instance = shared_ptr;
+    }
+    return shared_ptr;
+}
+
+//======================================================================================================================
+
+GpuMemory::GpuMemory()
+{
+    if (char const * const budget = std::getenv("GPU_MEMORY_BUDGET_MB"))
+    {
+        mBudget = static_cast<size_t>(std::strtoull(budget, nullptr, 10)) << 20;
+        Log::info("GPU memory budget: {0} MB", mBudget >> 20);
+    }
+}
+
+//======================================================================================================================
+
+bool GpuMemory::Fits(size_t const bytes) const
+{
+    return mBudget == 0 || mResident + bytes <= mBudget;
+}
+
+//======================================================================================================================
+
+char const * GpuMemory::Name(Category const category)
+{
+    switch (category)
+    {
+    case Category::TEXTURE:
+        return "Texture";
+    case Category::VERTEX_BUFFER:
+        return "Vertex buffer";
+    case Category::INDEX_BUFFER:
+        return "Index buffer";
+    case Category::UNIFORM_BUFFER:
+        return "Uniform buffer";
+    case Category::RENDER_TARGET:
+        return "Render target";
+    case Category::COUNT:
+        break;
+    }
+    return "?";
+}
+
+//======================================================================================================================
+
+size_t GpuMemory::TextureBytes(int width, int height, int const layers, size_t const bytesPerTexel)
+{
+    size_t texels = 0;
+    while (true)
+    {
+        texels += static_cast<size_t>(width) * static_cast<size_t>(height);
+        if (width == 1 && height == 1)
+        {
+            break;
+        }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return texels * static_cast<size_t>(layers) * bytesPerTexel;
+}
+
+//======================================================================================================================
+
+uint64_t GpuMemory::Add(Category const category, std::string name)
+{
+    uint64_t const id = mNextId++;
+    Entry & entry = mEntries[id];
+    entry.category = category;
+    entry.name = std::move(name);
+    return id;
+}
+
+//======================================================================================================================
+
+void GpuMemory::Resize(uint64_t const id, size_t const bytes)
+{
+    Entry & entry = mEntries.at(id);
+    size_t & category = mResidentByCategory[static_cast<size_t>(entry.category)];
+    mResident = mResident - entry.bytes + bytes;
+    category = category - entry.bytes + bytes;
+    entry.bytes = bytes;
+}
+
+//======================================================================================================================
+
+void GpuMemory::Remove(uint64_t const id)
+{
+    Resize(id, 0);
+    mEntries.erase(id);
+}
+
+//======================================================================================================================
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+// Video memory the renderer has asked GL for, by category and asset, held against a budget.
+//
+// GL can't tell how much an object really takes, drivers pad and compress as they like, so these are
+// the sizes of the data as given: texels times bytes per texel over every mip level, buffers as
+// uploaded. Close enough to choose texture sizes by.
+//
+// The budget is GPU_MEMORY_BUDGET_MB from the environment, without it there is none. Whoever is about
+// to allocate something large asks Fits first and goes smaller if it says no, see the texture setup
+// in SolarSystem.
+//
+// Objects register through an Allocation member, which gives the bytes back when it goes away.
+// GL thread only.
+class GpuMemory
+{
+public:
+
+    enum class Category : uint8_t
+    {
+        TEXTURE,
+        VERTEX_BUFFER,
+        INDEX_BUFFER,
+        UNIFORM_BUFFER,
+        RENDER_TARGET, // framebuffers and their readback
+        COUNT
+    };
+
+    struct Entry
+    {
+        Category category = Category::TEXTURE;
+        std::string name{};
+        size_t bytes = 0;
+    };
+
+    // One tracked object, 0 bytes until Resize. Move only.
+    class Allocation
+    {
+    public:
+
+        Allocation() = default;
+
+        explicit Allocation(Category category, std::string name);
+
+        ~Allocation();
+
+        Allocation(Allocation && other) noexcept;
+        Allocation & operator=(Allocation && other) noexcept;
+
+        Allocation(Allocation const &) = delete;
+        Allocation & operator=(Allocation const &) = delete;
+
+        void Resize(size_t bytes);
+
+    private:
+
+        void Release();
+
+        std::shared_ptr<GpuMemory> mMemory{};
+        uint64_t mId = 0;
+    };
+
+    static std::shared_ptr<GpuMemory> Instance();
+
+    explicit GpuMemory();
+
+    GpuMemory(GpuMemory const &) = delete;
+    GpuMemory & operator=(GpuMemory const &) = delete;
+
+    // 0 = no budget
+    [[nodiscard]]
+    size_t Budget() const { return mBudget; }
+
+    [[nodiscard]]
+    size_t Resident() const { return mResident; }
+
+    [[nodiscard]]
+    size_t Resident(Category category) const { return mResidentByCategory[static_cast<size_t>(category)]; }
+
+    // Whether bytes more stay within the budget
+    [[nodiscard]]
+    bool Fits(size_t bytes) const;
+
+    // Every allocation, in the order they were made
+    [[nodiscard]]
+    std::map<uint64_t, Entry> const & Entries() const { return mEntries; }
+
+    [[nodiscard]]
+    static char const * Name(Category category);
+
+    // Full mip chain of RGBA8, or of bytesPerTexel, levels down to 1x1
+    [[nodiscard]]
+    static size_t TextureBytes(int width, int height, int layers = 1, size_t bytesPerTexel = 4);
+
+private:
+
+    inline static std::weak_ptr<GpuMemory> _instance{};
+
+    uint64_t Add(Category category, std::string name);
+
+    void Resize(uint64_t id, size_t bytes);
+
+    void Remove(uint64_t id);
+
+    size_t mBudget = 0;
+    size_t mResident = 0;
+    std::array<size_t, static_cast<size_t>(Category::COUNT)> mResidentByCategory{};
+    std::map<uint64_t, Entry> mEntries{};
+    uint64_t mNextId = 1;
+};
@@ -0,0 +1,67 @@
+#include "GpuTimer.hpp"
+
+// Weight of the newest measurement, steadies the number enough to read in the UI
+static constexpr double Smoothing = 0.1;
+
+//======================================================================================================================
+
+GpuTimer::GpuTimer()
+{
+    glGenQueries(static_cast<GLsizei>(mQueries.size()), mQueries.data());
+}
+
+//======================================================================================================================
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(static_cast<GLsizei>(mQueries.size()), mQueries.data());
+}
+
+//======================================================================================================================
+
+void GpuTimer::Begin()
+{
+    Collect();
+    // With every query still in flight the oldest is reused, its result dropped rather than waited for
+    glBeginQuery(GL_TIME_ELAPSED, mQueries[mNext]);
+}
+
+//======================================================================================================================
+
+void GpuTimer::End()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    mPending[mNext] = true;
+    mNext = (mNext + 1) % QueryCount;
+}
+
+//======================================================================================================================
+
+void GpuTimer::Collect()
+{
+    // Oldest first, so the average follows the order the frames were drawn in
+    for (size_t i = 0; i < QueryCount; ++i)
+    {
+        size_t const index = (mNext + i) % QueryCount;
+        if (mPending[index] == false)
+        {
+            continue;
+        }
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(mQueries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+        {
+            continue;
+        }
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(mQueries[index], GL_QUERY_RESULT, &nanoseconds);
+        mPending[index] = false;
+
+        double const milliseconds = static_cast<double>(nanoseconds) * 1e-6;
+        mMilliseconds = mMilliseconds == 0.0 ? milliseconds : mMilliseconds + (milliseconds - mMilliseconds) * Smoothing;
+    }
+}
+
+//======================================================================================================================
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+
+// Measures how long the GPU spends on the commands between Begin and End, with GL_TIME_ELAPSED
+// queries (core since 3.3).
+//
+// Results arrive a few frames late, so the timer cycles through several queries and only reads back
+// the ones the GPU reports as finished. Reading never waits, a frame whose result isn't in yet just
+// keeps showing the previous average.
+class GpuTimer
+{
+public:
+
+    explicit GpuTimer();
+
+    ~GpuTimer();
+
+    GpuTimer(GpuTimer const &) = delete;
+    GpuTimer & operator=(GpuTimer const &) = delete;
+
+    // At most one timer can be running at a time, GL doesn't nest GL_TIME_ELAPSED queries
+    void Begin();
+
+    void End();
+
+    // Average over the last few finished measurements
+    [[nodiscard]]
+    double Milliseconds() const { return mMilliseconds; }
+
+private:
+
+    void Collect();
+
+    static constexpr size_t QueryCount = 4; // frames a result can be in flight
+
+    std::array<GLuint, QueryCount> mQueries{};
+    std::array<bool, QueryCount> mPending{};
+    size_t mNext = 0;
+
+    double mMilliseconds = 0.0;
+};
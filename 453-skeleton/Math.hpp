@@ -42,6 +42,20 @@ namespace Math
         return duration - std::abs(std::fmod(time, (duration * 2.0f)) - duration);
     }
 
+    // Orbits are propagated in a z-up frame, the scene is y-up with orbits running toward -z like a
+    // rotation about +y
+    [[nodiscard]]
+    inline glm::vec3 ToRenderSpace(double const x, double const y, double const z)
+    {
+        return glm::vec3{static_cast<float>(x), static_cast<float>(z), static_cast<float>(-y)};
+    }
+
+    [[nodiscard]]
+    inline glm::vec3 ToRenderSpace(glm::dvec3 const & position)
+    {
+        return ToRenderSpace(position.x, position.y, position.z);
+    }
+
     glm::mat4 TranslationToMatrix(glm::vec3 const & translation);
     glm::mat4 RotationToMatrix(glm::vec3 const & eulerAngles);
     glm::mat4 ScaleToMatrix(glm::vec3 const & scale);
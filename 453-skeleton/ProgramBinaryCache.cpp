@@ -0,0 +1,250 @@
+#include "ProgramBinaryCache.hpp"
+
+#include "AssetPath.h"
+#include "Log.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+// Not in the 3.3 loader, values from the GL_ARB_get_program_binary spec
+static constexpr GLenum ProgramBinaryRetrievableHint = 0x8257;
+static constexpr GLenum ProgramBinaryLength = 0x8741;
+static constexpr GLenum NumProgramBinaryFormats = 0x87FE;
+
+// Start of every entry, the binary itself follows
+struct EntryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+static constexpr char EntryMagic[4] = {'S', 'P', 'B', 'C'};
+static constexpr uint32_t EntryVersion = 1;
+
+//======================================================================================================================
+
+// FNV-1a over 64 bits, each string followed by a zero so "ab" + "c" and "a" + "bc" differ
+static uint64_t Hash(uint64_t hash, std::string const & text)
+{
+    for (char const c : text)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash * 1099511628211ull; // the terminating zero
+}
+
+//======================================================================================================================
+
+std::shared_ptr<ProgramBinaryCache> ProgramBinaryCache::Instance()
+{
+    std::shared_ptr<ProgramBinaryCache> instance = _instance.lock();
+    if (instance == nullptr)
+    {
+        instance = std::make_shared<ProgramBinaryCache>();
+        _instance = instance;
+    }
+    return instance;
+}
+
+//======================================================================================================================
+
+ProgramBinaryCache::ProgramBinaryCache()
+{
+    for (GLenum const name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        char const * value = reinterpret_cast<char const *>(glGetString(name));
+        mDriver += value != nullptr ? value : "";
+        mDriver += '\n';
+    }
+
+    // Shared with whatever else lives next to the assets, outside of them so it's never mistaken for one
+    mDirectory = std::filesystem::path(AssetPath::Instance()->Get("shaders")).parent_path().parent_path() / "shader_cache";
+
+    if (std::getenv("NO_SHADER_CACHE") != nullptr)
+    {
+        Log::info("Shader cache: disabled by NO_SHADER_CACHE");
+        return;
+    }
+
+    GLint majorVersion = 0;
+    GLint minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+    bool const core = majorVersion > 4 || (majorVersion == 4 && minorVersion >= 1);
+    if (core == false && glfwExtensionSupported("GL_ARB_get_program_binary") == GLFW_FALSE)
+    {
+        Log::info("Shader cache: GL_ARB_get_program_binary not supported");
+        return;
+    }
+
+    mGetProgramBinary = reinterpret_cast<GetProgramBinary>(glfwGetProcAddress("glGetProgramBinary"));
+    mProgramBinary = reinterpret_cast<ProgramBinary>(glfwGetProcAddress("glProgramBinary"));
+    mProgramParameteri = reinterpret_cast<ProgramParameteri>(glfwGetProcAddress("glProgramParameteri"));
+
+    // Drivers are allowed to support the extension with zero formats, which means it can't be used
+    GLint formats = 0;
+    glGetIntegerv(NumProgramBinaryFormats, &formats);
+    if (mGetProgramBinary == nullptr || mProgramBinary == nullptr || mProgramParameteri == nullptr || formats == 0)
+    {
+        Log::info("Shader cache: driver has no program binary formats");
+        return;
+    }
+
+    std::error_code error{};
+    std::filesystem::create_directories(mDirectory, error);
+    if (error)
+    {
+        Log::warn("Shader cache: can't create {0} ({1})", mDirectory.string(), error.message());
+        return;
+    }
+
+    mEnabled = true;
+    Log::info("Shader cache: {0}", mDirectory.string());
+}
+
+//======================================================================================================================
+
+uint64_t ProgramBinaryCache::Key(std::string const & vertexSource, std::string const & fragmentSource) const
+{
+    uint64_t hash = 14695981039346656037ull;
+    hash = Hash(hash, mDriver);
+    hash = Hash(hash, vertexSource);
+    hash = Hash(hash, fragmentSource);
+    return hash;
+}
+
+//======================================================================================================================
+
+bool ProgramBinaryCache::Load(uint64_t const key, GLuint const program)
+{
+    if (mEnabled == false)
+    {
+        return false;
+    }
+
+    std::filesystem::path const path = EntryPath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (file.is_open() == false)
+    {
+        return false;
+    }
+
+    EntryHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    std::vector<char> binary{};
+    bool valid = file.good() &&
+        std::equal(std::begin(EntryMagic), std::end(EntryMagic), header.magic) &&
+        header.version == EntryVersion &&
+        header.key == key;
+    if (valid)
+    {
+        binary.resize(header.length);
+        file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+        valid = file.good();
+    }
+    file.close();
+
+    if (valid)
+    {
+        mProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        valid = linked == GL_TRUE;
+    }
+
+    if (valid == false)
+    {
+        // Truncated, or written by a driver that no longer accepts it. Compiling writes a fresh one.
+        Log::warn("Shader cache: dropping unusable entry {0}", path.filename().string());
+        std::error_code error{};
+        std::filesystem::remove(path, error);
+    }
+    return valid;
+}
+
+//======================================================================================================================
+
+void ProgramBinaryCache::PrepareForStore(GLuint const program) const
+{
+    if (mEnabled)
+    {
+        mProgramParameteri(program, ProgramBinaryRetrievableHint, GL_TRUE);
+    }
+}
+
+//======================================================================================================================
+
+void ProgramBinaryCache::Store(uint64_t const key, GLuint const program) const
+{
+    if (mEnabled == false)
+    {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, ProgramBinaryLength, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    EntryHeader header{};
+    std::copy(std::begin(EntryMagic), std::end(EntryMagic), header.magic);
+    header.version = EntryVersion;
+    header.key = key;
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLsizei written = 0;
+    GLenum format = 0;
+    mGetProgramBinary(program, length, &written, &format, binary.data());
+    header.format = format;
+    header.length = static_cast<uint32_t>(written);
+
+    // Written aside and renamed, so a crash or a second instance never leaves half an entry behind
+    std::filesystem::path const path = EntryPath(key);
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (file.good() == false)
+        {
+            Log::warn("Shader cache: can't write {0}", temporary.string());
+            return;
+        }
+    }
+    std::error_code error{};
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+//======================================================================================================================
+
+void ProgramBinaryCache::Record(bool const fromCache, double const milliseconds)
+{
+    ++(fromCache ? mHits : mMisses);
+    mMilliseconds += milliseconds;
+}
+
+//======================================================================================================================
+
+std::filesystem::path ProgramBinaryCache::EntryPath(uint64_t const key) const
+{
+    char name[32]{};
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return mDirectory / name;
+}
+
+//======================================================================================================================
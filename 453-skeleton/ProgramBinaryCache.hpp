@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+// Linked shader programs kept on disk between runs (GL_ARB_get_program_binary, core since 4.1).
+//
+// An entry is keyed by a hash of both stages' final source, defines included, and of the driver's
+// vendor, renderer and version strings. Editing a shader or updating the driver changes the key, so
+// stale entries are never even looked at. The driver may still refuse a binary it wrote itself, then
+// the entry is deleted and the program is compiled from source like without a cache.
+//
+// Without the extension, or with NO_SHADER_CACHE set in the environment, every lookup misses and
+// nothing is written.
+class ProgramBinaryCache
+{
+public:
+
+    // Needs a current GL context the first time
+    static std::shared_ptr<ProgramBinaryCache> Instance();
+
+    explicit ProgramBinaryCache();
+
+    ProgramBinaryCache(ProgramBinaryCache const &) = delete;
+    ProgramBinaryCache & operator=(ProgramBinaryCache const &) = delete;
+
+    [[nodiscard]]
+    uint64_t Key(std::string const & vertexSource, std::string const & fragmentSource) const;
+
+    // Loads the entry into the program, true if it is now linked and ready
+    bool Load(uint64_t key, GLuint program);
+
+    // Has to be called before linking a program that is going to be stored
+    void PrepareForStore(GLuint program) const;
+
+    void Store(uint64_t key, GLuint program) const;
+
+    // Every program build goes through here, cached or not, so startup cost can be compared
+    void Record(bool fromCache, double milliseconds);
+
+    [[nodiscard]]
+    bool Enabled() const { return mEnabled; }
+
+    [[nodiscard]]
+    size_t Hits() const { return mHits; }
+
+    [[nodiscard]]
+    size_t Misses() const { return mMisses; }
+
+    // Spent creating programs so far, with and without the cache's help
+    [[nodiscard]]
+    double Milliseconds() const { return mMilliseconds; }
+
+private:
+
+    [[nodiscard]]
+    std::filesystem::path EntryPath(uint64_t key) const;
+
+    inline static std::weak_ptr<ProgramBinaryCache> _instance{};
+
+    using GetProgramBinary = void (APIENTRYP)(GLuint, GLsizei, GLsizei *, GLenum *, void *);
+    using ProgramBinary = void (APIENTRYP)(GLuint, GLenum, void const *, GLsizei);
+    using ProgramParameteri = void (APIENTRYP)(GLuint, GLenum, GLint);
+
+    GetProgramBinary mGetProgramBinary = nullptr;
+    ProgramBinary mProgramBinary = nullptr;
+    ProgramParameteri mProgramParameteri = nullptr;
+
+    bool mEnabled = false;
+    std::string mDriver{};
+    std::filesystem::path mDirectory{};
+
+    size_t mHits = 0;
+    size_t mMisses = 0;
+    double mMilliseconds = 0.0;
+};
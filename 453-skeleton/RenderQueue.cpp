@@ -0,0 +1,99 @@
+#include "RenderQueue.hpp"
+
+#include "GLState.hpp"
+
+#include <algorithm>
+
+static constexpr uint64_t PassBits = 2;
+static constexpr uint64_t ShaderBits = 6;
+static constexpr uint64_t DepthBits = 24;
+static constexpr uint64_t TextureSetBits = 16;
+static constexpr uint64_t MeshBits = 16;
+static_assert(PassBits + ShaderBits + DepthBits + TextureSetBits + MeshBits == 64, "every key bit is used once");
+
+//======================================================================================================================
+
+static constexpr uint64_t Field(uint64_t const value, uint64_t const bits)
+{
+    return value & ((uint64_t{1} << bits) - 1);
+}
+
+//======================================================================================================================
+
+uint64_t RenderQueue::MakeKey(
+    Pass const pass,
+    uint32_t const shader,
+    uint32_t const textureSet,
+    uint32_t const mesh,
+    float const depth,
+    float const farPlane
+)
+{
+    static constexpr uint64_t MaxDepth = (uint64_t{1} << DepthBits) - 1;
+    float const normalized = std::clamp(depth / farPlane, 0.0f, 1.0f);
+    uint64_t const nearToFar = static_cast<uint64_t>(normalized * static_cast<float>(MaxDepth));
+
+    uint64_t key = Field(static_cast<uint64_t>(pass), PassBits);
+    if (pass == Pass::TRANSPARENT)
+    {
+        key = (key << DepthBits) | (MaxDepth - nearToFar);
+        key = (key << ShaderBits) | Field(shader, ShaderBits);
+    }
+    else
+    {
+        key = (key << ShaderBits) | Field(shader, ShaderBits);
+        key = (key << DepthBits) | nearToFar;
+    }
+    key = (key << TextureSetBits) | Field(textureSet, TextureSetBits);
+    key = (key << MeshBits) | Field(mesh, MeshBits);
+    return key;
+}
+
+//======================================================================================================================
+
+void RenderQueue::Execute(UniformBuffer const & objectUniforms)
+{
+    std::sort(
+        mPackets.begin(),
+        mPackets.end(),
+        [](DrawPacket const & a, DrawPacket const & b) -> bool { return a.key < b.key; }
+    );
+
+    // GLState drops whatever the previous packet already set up
+    auto const state = GLState::Instance();
+    for (DrawPacket const & packet : mPackets)
+    {
+        auto const pass = static_cast<Pass>(packet.key >> (64 - PassBits));
+        state->SetEnabled(GL_BLEND, pass == Pass::TRANSPARENT);
+        if (pass == Pass::TRANSPARENT)
+        {
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Standard alpha blending
+        }
+
+        packet.shader->use();
+        objectUniforms.Bind(packet.objectSlot);
+        for (size_t unit = 0; unit < packet.textures.size(); ++unit)
+        {
+            TextureBinding const & binding = packet.textures[unit];
+            if (binding.texture == 0)
+            {
+                continue;
+            }
+            if (binding.target == GL_TEXTURE_2D_ARRAY)
+            {
+                state->BindTextureArray(static_cast<GLuint>(unit), binding.texture);
+            }
+            else
+            {
+                state->BindTexture(static_cast<GLuint>(unit), binding.texture);
+            }
+        }
+        packet.geometry->bind();
+        glDrawElements(GL_TRIANGLES, packet.indexCount, GL_UNSIGNED_INT, nullptr);
+    }
+    state->SetEnabled(GL_BLEND, false);
+
+    mPackets.clear();
+}
+
+//======================================================================================================================
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Geometry.h"
+#include "ShaderProgram.h"
+#include "UniformBuffer.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Draws collected for a frame and issued in the order of their 64-bit sort keys.
+//
+// Key layout, most significant first:
+//   opaque, sky:  pass (2) | shader (6) | near-to-far depth (24) | texture set (16) | mesh (16)
+//   transparent:  pass (2) | far-to-near depth (24) | shader (6) | texture set (16) | mesh (16)
+// Opaque draws are grouped by shader, the most expensive switch, then go front to back so early-Z
+// rejects what is hidden. The sky comes after them for the same reason. Transparent layers have to be
+// blended back to front, so for them depth outranks state. Ties fall to the texture set and mesh,
+// which keeps identical state next to each other.
+class RenderQueue
+{
+public:
+
+    enum class Pass : uint64_t
+    {
+        OPAQUE = 0,
+        SKY = 1,
+        TRANSPARENT = 2
+    };
+
+    struct TextureBinding
+    {
+        GLenum target = GL_TEXTURE_2D; // or GL_TEXTURE_2D_ARRAY
+        GLuint texture = 0;            // 0 leaves the unit alone
+    };
+
+    struct DrawPacket
+    {
+        uint64_t key = 0;
+        ShaderProgram const * shader = nullptr;
+        GPU_Geometry * geometry = nullptr;
+        GLsizei indexCount = 0;
+        std::array<TextureBinding, 6> textures{}; // by texture unit
+        uint32_t objectSlot = 0;                  // block of the per-object uniform buffer
+    };
+
+    // shader, textureSet and mesh are small ids the caller picks, equal ids mean equal state. depth is
+    // the view space distance, clamped to [0, farPlane].
+    [[nodiscard]]
+    static uint64_t MakeKey(Pass pass, uint32_t shader, uint32_t textureSet, uint32_t mesh, float depth, float farPlane);
+
+    void Submit(DrawPacket const & packet) { mPackets.emplace_back(packet); }
+
+    // Sorts and issues every packet, then empties the queue (keeping its storage)
+    void Execute(UniformBuffer const & objectUniforms);
+
+    [[nodiscard]]
+    size_t Size() const { return mPackets.size(); }
+
+private:
+
+    std::vector<DrawPacket> mPackets{};
+};
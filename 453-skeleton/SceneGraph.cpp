@@ -0,0 +1,81 @@
+#include "SceneGraph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+//======================================================================================================================
+
+SceneGraph::NodeId SceneGraph::Add(NodeId const parent)
+{
+    if (parent != InvalidId && parent >= mLocal.size())
+    {
+        throw std::invalid_argument("SceneGraph: parent must be added before its children");
+    }
+    mParent.emplace_back(parent);
+    mLocal.emplace_back(1.0f);
+    mWorld.emplace_back(1.0f);
+    mNormal.emplace_back(1.0f);
+    mDirty.emplace_back(1);
+    return static_cast<NodeId>(mLocal.size() - 1);
+}
+
+//======================================================================================================================
+
+void SceneGraph::SetLocal(NodeId const id, glm::mat4 const & local)
+{
+    if (mLocal[id] != local)
+    {
+        mLocal[id] = local;
+        mDirty[id] = 1;
+    }
+}
+
+//======================================================================================================================
+
+size_t SceneGraph::Update()
+{
+    // Parents come first, so by the time a node is reached its parent's world matrix is final and its
+    // dirty flag says whether that matrix changed this time
+    size_t updated = 0;
+    for (size_t i = 0; i < mLocal.size(); ++i)
+    {
+        NodeId const parent = mParent[i];
+        if (parent != InvalidId)
+        {
+            mDirty[i] |= mDirty[parent];
+        }
+        if (mDirty[i] != 0)
+        {
+            mWorld[i] = parent == InvalidId ? mLocal[i] : mWorld[parent] * mLocal[i];
+            mNormal[i] = NormalMatrix(mWorld[i]);
+            ++updated;
+        }
+    }
+
+    // Only cleared once every child has seen its parent's flag
+    std::fill(mDirty.begin(), mDirty.end(), uint8_t{0});
+    return updated;
+}
+
+//======================================================================================================================
+
+glm::mat4 SceneGraph::NormalMatrix(glm::mat4 const & world)
+{
+    // The inverse transpose of a 3x3 is its cofactor matrix over the determinant, and the cofactor
+    // columns are cross products of the other two columns. Three crosses and a dot, no branches,
+    // instead of a general inverse and a transpose.
+    glm::vec3 const x{world[0]};
+    glm::vec3 const y{world[1]};
+    glm::vec3 const z{world[2]};
+    glm::vec3 const yz = glm::cross(y, z);
+    float const determinant = glm::dot(x, yz);
+    float const inverseDeterminant = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+
+    glm::mat4 normal{1.0f};
+    normal[0] = glm::vec4{yz * inverseDeterminant, 0.0f};
+    normal[1] = glm::vec4{glm::cross(z, x) * inverseDeterminant, 0.0f};
+    normal[2] = glm::vec4{glm::cross(x, y) * inverseDeterminant, 0.0f};
+    return normal;
+}
+
+//======================================================================================================================
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Transform hierarchy for everything Render draws.
+//
+// Each node has a local matrix relative to its parent and a cached world matrix. Setting a local
+// matrix only marks the node dirty when it actually changed, and Update recomputes the world matrix
+// of dirty nodes and their descendants only, so bodies that didn't move cost a comparison. Nodes are
+// kept parents first, like BodyTable, which lets Update resolve the hierarchy in one forward pass.
+//
+// The normal matrix of a node is refreshed together with its world matrix, so shaders get it ready
+// made instead of inverting the model matrix for every vertex.
+class SceneGraph
+{
+public:
+
+    using NodeId = uint32_t;
+
+    static constexpr NodeId InvalidId = std::numeric_limits<NodeId>::max();
+
+    // The parent must already be in the graph
+    NodeId Add(NodeId parent = InvalidId);
+
+    void SetLocal(NodeId id, glm::mat4 const & local);
+
+    // Brings every world matrix up to date, returns how many had to be recomputed
+    size_t Update();
+
+    // Valid after Update
+    [[nodiscard]]
+    glm::mat4 const & World(NodeId id) const { return mWorld[id]; }
+
+    // Inverse transpose of the world matrix's upper 3x3, in a mat4 so it drops straight into a std140
+    // block. Valid after Update.
+    [[nodiscard]]
+    glm::mat4 const & Normal(NodeId id) const { return mNormal[id]; }
+
+    [[nodiscard]]
+    glm::vec3 WorldPosition(NodeId id) const { return glm::vec3{mWorld[id][3]}; }
+
+    [[nodiscard]]
+    size_t Size() const { return mLocal.size(); }
+
+    [[nodiscard]]
+    static glm::mat4 NormalMatrix(glm::mat4 const & world);
+
+private:
+
+    std::vector<NodeId> mParent{};
+    std::vector<glm::mat4> mLocal{};
+    std::vector<glm::mat4> mWorld{};
+    std::vector<glm::mat4> mNormal{};
+    std::vector<uint8_t> mDirty{}; // not vector<bool>, Update reads and writes it in a tight loop
+};
@@ -10,20 +10,34 @@
 #include <vector>
 
 
-Shader::Shader(const std::string& path, GLenum type)
+Shader::Shader(const std::string& path, GLenum type, const std::string& defines)
 	: shaderID(type)
 	, type(type)
 	, path(path)
+	, defines(defines)
 {
-	if (!compile()) {
+	std::string source;
+	if (!readSource(path, defines, source)) {
 		throw std::runtime_error("Shader did not compile");
 	}
+	submit(source);
+	if (!checkCompileStatus()) {
+		throw std::runtime_error("Shader did not compile");
+	}
+}
+
+Shader::Shader(const std::string& path, GLenum type, const std::string& defines, const std::string& source)
+	: shaderID(type)
+	, type(type)
+	, path(path)
+	, defines(defines)
+{
+	submit(source);
 }
 
-bool Shader::compile() {
+bool Shader::readSource(const std::string& path, const std::string& defines, std::string& sourceString) {
 
 	// read shader source
-	std::string sourceString;
 	std::ifstream file;
 
 	// ensure ifstream objects can throw exceptions:
@@ -46,12 +60,30 @@ bool Shader::compile() {
 		Log::error("SHADER reading {}:\n{}", path, strerror(errno));
 		return false;
 	}
-	const GLchar* sourceCode = sourceString.c_str();
 
+	// #version has to stay first, the defines go right after it. #line keeps
+	// the line numbers in compile errors matching the file.
+	if (!defines.empty()) {
+		size_t versionEnd = 0;
+		if (sourceString.compare(0, 8, "#version") == 0) {
+			versionEnd = sourceString.find('\n');
+			versionEnd = versionEnd == std::string::npos ? sourceString.size() : versionEnd + 1;
+		}
+		sourceString = sourceString.substr(0, versionEnd) + defines + "#line 2\n" + sourceString.substr(versionEnd);
+	}
+	return true;
+}
+
+void Shader::submit(const std::string& sourceString) {
 
-	// compile shader
+	const GLchar* sourceCode = sourceString.c_str();
+
+	// compile shader, drivers may do the work on another thread until the status is asked for
 	glShaderSource(shaderID, 1, &sourceCode, NULL);
 	glCompileShader(shaderID);
+}
+
+bool Shader::checkCompileStatus() const {
 
 	// check for errors
 	GLint success;
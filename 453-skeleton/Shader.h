@@ -11,7 +11,15 @@ class ShaderProgram;
 class Shader {
 
 public:
-	Shader(const std::string& path, GLenum type);
+	// defines is inserted right after the #version line, e.g. "#define CLOUDS\n"
+	Shader(const std::string& path, GLenum type, const std::string& defines = "");
+	// Starts compiling source as it is, e.g. from readSource, without waiting
+	// for the result. checkCompileStatus tells how it went.
+	Shader(const std::string& path, GLenum type, const std::string& defines, const std::string& source);
+
+	// The text that gets compiled: the file with the defines inserted.
+	// False (and logged) if the file can't be read.
+	static bool readSource(const std::string& path, const std::string& defines, std::string& source);
 
 	// Because we're using the ShaderHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
@@ -23,15 +31,21 @@ public:
 	// Public interface
 	std::string getPath() const { return path; }
 	GLenum getType() const { return type; }
+	std::string getDefines() const { return defines; }
+
+	// Waits for the compile if it is still running, logs the errors if it failed
+	bool checkCompileStatus() const;
 
 	void friend attach(ShaderProgram& sp, Shader& s);
+	void friend detach(ShaderProgram& sp, Shader& s);
 
 private:
 	ShaderHandle shaderID;
 	GLenum type;
 
 	std::string path;
+	std::string defines;
 
-	bool compile();
+	void submit(const std::string& source);
 };
 
@@ -0,0 +1,125 @@
+#include "ShaderPermutations.hpp"
+
+#include "Log.h"
+
+#include <stdexcept>
+
+//======================================================================================================================
+
+ShaderPermutations::ShaderPermutations(
+    std::string vertexPath,
+    std::string fragmentPath,
+    std::vector<std::string> features,
+    Setup setup
+)
+    : mVertexPath(std::move(vertexPath))
+    , mFragmentPath(std::move(fragmentPath))
+    , mFeatures(std::move(features))
+    , mSetup(std::move(setup))
+{
+    if (mFeatures.size() > 32)
+    {
+        throw std::invalid_argument("ShaderPermutations: at most 32 features fit in a key");
+    }
+}
+
+//======================================================================================================================
+
+void ShaderPermutations::Request(uint32_t const features)
+{
+    (void)Find(features);
+}
+
+//======================================================================================================================
+
+ShaderProgram * ShaderPermutations::TryGet(uint32_t const features)
+{
+    Variant & variant = Find(features);
+    if (variant.ready == false)
+    {
+        if (Complete(features, variant, false) == false)
+        {
+            return nullptr;
+        }
+    }
+    return variant.program.get();
+}
+
+//======================================================================================================================
+
+ShaderProgram & ShaderPermutations::Get(uint32_t const features)
+{
+    Variant & variant = Find(features);
+    if (variant.ready == false)
+    {
+        Complete(features, variant, true);
+    }
+    return *variant.program;
+}
+
+//======================================================================================================================
+
+ShaderPermutations::Variant & ShaderPermutations::Find(uint32_t const features)
+{
+    auto const found = mVariants.find(features);
+    if (found != mVariants.end())
+    {
+        return found->second;
+    }
+
+    Variant variant{};
+    variant.program = std::make_unique<ShaderProgram>(deferredLink, mVertexPath, mFragmentPath, Defines(features));
+    ++mPendingCount;
+    return mVariants.emplace(features, std::move(variant)).first->second;
+}
+
+//======================================================================================================================
+
+bool ShaderPermutations::Complete(uint32_t const features, Variant & variant, bool const wait)
+{
+    try
+    {
+        if (wait)
+        {
+            variant.program->wait();
+        }
+        else if (variant.program->poll() == false)
+        {
+            return false;
+        }
+    }
+    catch (std::runtime_error const &)
+    {
+        // Not kept, so the next request tries again from source
+        mVariants.erase(features);
+        --mPendingCount;
+        throw;
+    }
+
+    if (mSetup)
+    {
+        variant.program->use();
+        mSetup(*variant.program);
+    }
+    variant.ready = true;
+    --mPendingCount;
+    Log::info("Shader variant {:#x} of {} ready ({} compiled, {} pending)", features, mFragmentPath, VariantCount(), mPendingCount);
+    return true;
+}
+
+//======================================================================================================================
+
+std::string ShaderPermutations::Defines(uint32_t const features) const
+{
+    std::string defines{};
+    for (size_t i = 0; i < mFeatures.size(); ++i)
+    {
+        if ((features >> i) & 1u)
+        {
+            defines += "#define " + mFeatures[i] + "\n";
+        }
+    }
+    return defines;
+}
+
+//======================================================================================================================
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ShaderProgram.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Variants of one vertex/fragment pair, one per combination of features.
+//
+// Feature i is a preprocessor symbol, defined in both stages when bit i of the key is set, so the
+// shader source uses #ifdef instead of branching on uniforms per pixel. A variant is compiled the
+// first time its key is asked for and kept from then on. Compiling runs alongside everything else
+// until a variant is actually needed: Request starts it, TryGet checks on it without waiting.
+class ShaderPermutations
+{
+public:
+
+    // Runs once on every new variant, bound, e.g. to set sampler units
+    using Setup = std::function<void(ShaderProgram &)>;
+
+    ShaderPermutations(std::string vertexPath, std::string fragmentPath, std::vector<std::string> features, Setup setup = {});
+
+    // Starts compiling the variant unless it already exists
+    void Request(uint32_t features);
+
+    // The variant if it's done compiling, else null and the caller draws with something else.
+    // Throws std::runtime_error like ShaderProgram when the variant doesn't build, as does Get.
+    [[nodiscard]]
+    ShaderProgram * TryGet(uint32_t features);
+
+    // Waits for the variant if it isn't done yet
+    [[nodiscard]]
+    ShaderProgram & Get(uint32_t features);
+
+    // Variants that are ready to draw with
+    [[nodiscard]]
+    size_t VariantCount() const { return mVariants.size() - mPendingCount; }
+
+    // Variants still compiling
+    [[nodiscard]]
+    size_t PendingCount() const { return mPendingCount; }
+
+private:
+
+    struct Variant
+    {
+        std::unique_ptr<ShaderProgram> program{};
+        bool ready = false; // done compiling and set up
+    };
+
+    Variant & Find(uint32_t features);
+
+    // Polls or waits for a pending variant and sets it up once it's done
+    bool Complete(uint32_t features, Variant & variant, bool wait);
+
+    [[nodiscard]]
+    std::string Defines(uint32_t features) const;
+
+    std::string mVertexPath{};
+    std::string mFragmentPath{};
+    std::vector<std::string> mFeatures{};
+    Setup mSetup{};
+    std::unordered_map<uint32_t, Variant> mVariants{};
+    size_t mPendingCount = 0;
+};
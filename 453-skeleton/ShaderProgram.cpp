@@ -1,32 +1,155 @@
 #include "ShaderProgram.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
 
+#include <GLFW/glfw3.h>
+
 #include "AssetPath.h"
 #include "Log.h"
+#include "ProgramBinaryCache.hpp"
+#include "UniformBlocks.hpp"
+
+// Not in the 3.3 loader, values from the KHR_parallel_shader_compile spec
+static constexpr GLenum COMPLETION_STATUS = 0x91B1;
+
+bool ShaderProgram::parallelCompileSupported() {
+  static bool const supported = [] {
+    // The ARB and KHR versions share their enums, only the function name differs
+    for (const char *name : {"KHR", "ARB"}) {
+      std::string const extension = std::string("GL_") + name + "_parallel_shader_compile";
+      if (glfwExtensionSupported(extension.c_str()) == GLFW_FALSE) {
+        continue;
+      }
+      using MaxShaderCompilerThreads = void (APIENTRYP)(GLuint);
+      std::string const function = std::string("glMaxShaderCompilerThreads") + name;
+      auto const maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(glfwGetProcAddress(function.c_str()));
+      if (maxThreads != nullptr) {
+        maxThreads(0xFFFFFFFFu); // as many as the driver likes
+      }
+      Log::info("SHADER_PROGRAM compiling in parallel ({})", extension);
+      return true;
+    }
+    return false;
+  }();
+  return supported;
+}
 
 ShaderProgram::ShaderProgram(const std::string &vertexPath,
-                             const std::string &fragmentPath)
+                             const std::string &fragmentPath,
+                             const std::string &defines)
+    : ShaderProgram(deferredLink, vertexPath, fragmentPath, defines) {
+  wait();
+}
+
+ShaderProgram::ShaderProgram(DeferredLink,
+                             const std::string &vertexPath,
+                             const std::string &fragmentPath,
+                             const std::string &defines)
     : programID(),
-      vertex(AssetPath::Instance()->Get(vertexPath), GL_VERTEX_SHADER),
-      fragment(AssetPath::Instance()->Get(fragmentPath), GL_FRAGMENT_SHADER) {
-  attach(*this, vertex);
-  attach(*this, fragment);
+      vertexPath(AssetPath::Instance()->Get(vertexPath)),
+      fragmentPath(AssetPath::Instance()->Get(fragmentPath)),
+      defines(defines) {
+  auto const start = std::chrono::steady_clock::now();
+
+  std::string vertexSource;
+  std::string fragmentSource;
+  if (!Shader::readSource(this->vertexPath, defines, vertexSource) ||
+      !Shader::readSource(this->fragmentPath, defines, fragmentSource)) {
+    throw std::runtime_error("Shader did not compile");
+  }
+
+  std::shared_ptr<ProgramBinaryCache> const cache = ProgramBinaryCache::Instance();
+  uint64_t const key = cache->Key(vertexSource, fragmentSource);
+  if (cache->Load(key, programID)) {
+    finishSetup(true, start);
+    return;
+  }
+
+  // Nothing here waits on the driver, the statuses are checked in finishLink
+  parallelCompileSupported();
+  pending = std::make_unique<PendingLink>();
+  pending->vertex = std::make_unique<Shader>(this->vertexPath, GL_VERTEX_SHADER, defines, vertexSource);
+  pending->fragment = std::make_unique<Shader>(this->fragmentPath, GL_FRAGMENT_SHADER, defines, fragmentSource);
+  pending->cacheKey = key;
+  pending->start = start;
+  attach(*this, *pending->vertex);
+  attach(*this, *pending->fragment);
+  cache->PrepareForStore(programID);
   glLinkProgram(programID);
+}
+
+bool ShaderProgram::poll() {
+  if (!pending) {
+    return true;
+  }
+  if (parallelCompileSupported()) {
+    GLint complete = GL_FALSE;
+    glGetProgramiv(programID, COMPLETION_STATUS, &complete);
+    if (complete == GL_FALSE) {
+      return false;
+    }
+  }
+  finishLink();
+  return true;
+}
+
+void ShaderProgram::wait() {
+  if (pending) {
+    finishLink();
+  }
+}
+
+void ShaderProgram::finishLink() {
+  std::unique_ptr<PendingLink> const link = std::move(pending);
+
+  // Both are checked so both logs get printed
+  bool const vertexCompiled = link->vertex->checkCompileStatus();
+  bool const fragmentCompiled = link->fragment->checkCompileStatus();
+  detach(*this, *link->vertex);
+  detach(*this, *link->fragment);
+  if (!vertexCompiled || !fragmentCompiled) {
+    throw std::runtime_error("Shader did not compile");
+  }
 
   if (!checkAndLogLinkSuccess()) {
     glDeleteProgram(programID);
     throw std::runtime_error("Shaders did not link.");
   }
+  ProgramBinaryCache::Instance()->Store(link->cacheKey, programID);
+
+  finishSetup(false, link->start);
+}
+
+void ShaderProgram::finishSetup(bool fromCache, std::chrono::steady_clock::time_point start) {
+  // Shared uniform blocks always sit at the same binding points, whichever
+  // of them this program declares
+  for (GLuint binding = 0; binding < UniformBlocks::BINDING_COUNT; ++binding) {
+    GLuint const index = glGetUniformBlockIndex(programID, UniformBlocks::Names[binding]);
+    if (index != GL_INVALID_INDEX) {
+      glUniformBlockBinding(programID, index, binding);
+    }
+  }
+
+  introspectUniforms();
+
+  // From the constructor on, so for deferred programs this includes whatever
+  // the caller did in the meantime
+  double const milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  ProgramBinaryCache::Instance()->Record(fromCache, milliseconds);
+  if (fromCache) {
+    Log::info("SHADER_PROGRAM loaded {} + {} from the cache in {:.2f} ms", vertexPath, fragmentPath, milliseconds);
+  }
 }
 
 bool ShaderProgram::recompile() {
 
   try {
     // Try to create a new program
-    ShaderProgram newProgram(vertex.getPath(), fragment.getPath());
+    ShaderProgram newProgram(vertexPath, fragmentPath, defines);
     *this = std::move(newProgram);
     return true;
   } catch (std::runtime_error &e) {
@@ -39,6 +162,10 @@ void attach(ShaderProgram &sp, Shader &s) {
   glAttachShader(sp.programID, s.shaderID);
 }
 
+void detach(ShaderProgram &sp, Shader &s) {
+  glDetachShader(sp.programID, s.shaderID);
+}
+
 bool ShaderProgram::checkAndLogLinkSuccess() const {
 
   GLint success;
@@ -50,12 +177,64 @@ bool ShaderProgram::checkAndLogLinkSuccess() const {
     std::vector<char> log(logLength);
     glGetProgramInfoLog(programID, logLength, NULL, log.data());
 
-    Log::error("SHADER_PROGRAM linking {} + {}:\n{}", vertex.getPath(),
-               fragment.getPath(), log.data());
+    Log::error("SHADER_PROGRAM linking {} + {}:\n{}", vertexPath,
+               fragmentPath, log.data());
     return false;
   } else {
     Log::info("SHADER_PROGRAM successfully compiled and linked {} + {}",
-              vertex.getPath(), fragment.getPath());
+              vertexPath, fragmentPath);
     return true;
   }
 }
+
+void ShaderProgram::introspectUniforms() {
+  uniforms.clear();
+
+  GLint count = 0;
+  GLint maxLength = 0;
+  glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  std::vector<char> buffer(std::max(maxLength, 1));
+
+  auto const add = [this](std::string const &name) {
+    GLint const location = glGetUniformLocation(programID, name.c_str());
+    if (location >= 0) { // block members have no location
+      uniforms.push_back({uniformNameHash(name), location});
+    }
+  };
+
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(programID, static_cast<GLuint>(i), maxLength, &length, &size, &type, buffer.data());
+    std::string name(buffer.data(), length);
+
+    // Arrays are reported as name[0], register the plain name and every element
+    if (size > 1 || (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)) {
+      std::string const base = name.substr(0, name.find('['));
+      add(base);
+      for (GLint element = 0; element < size; ++element) {
+        add(base + "[" + std::to_string(element) + "]");
+      }
+    } else {
+      add(name);
+    }
+  }
+
+  std::sort(uniforms.begin(), uniforms.end(),
+            [](UniformLocation const &a, UniformLocation const &b) { return a.hash < b.hash; });
+  auto const duplicate = std::adjacent_find(
+      uniforms.begin(), uniforms.end(),
+      [](UniformLocation const &a, UniformLocation const &b) { return a.hash == b.hash; });
+  if (duplicate != uniforms.end()) {
+    Log::error("SHADER_PROGRAM {} + {}: two uniform names share a hash", vertexPath, fragmentPath);
+  }
+}
+
+GLint ShaderProgram::locationOf(uint32_t hash) const {
+  auto const it = std::lower_bound(
+      uniforms.begin(), uniforms.end(), hash,
+      [](UniformLocation const &entry, uint32_t value) { return entry.hash < value; });
+  return it != uniforms.end() && it->hash == hash ? it->location : -1;
+}
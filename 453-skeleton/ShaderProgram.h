@@ -3,17 +3,53 @@
 #include "Shader.h"
 
 #include "GLHandles.h"
+#include "GLState.hpp"
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <vector>
+
+// FNV-1a, usable in constant expressions so uniform names are hashed by the compiler
+constexpr uint32_t uniformNameHash(std::string_view name) {
+	uint32_t hash = 2166136261u;
+	for (char c : name) {
+		hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+	}
+	return hash;
+}
+
+// A uniform name resolved to its hash at compile time, typed by what it holds so a
+// handle can only be set with a matching value. Make them constexpr at the call
+// site: constexpr auto shininess = UniformHandle<float>("material.shininess");
+template <typename T>
+struct UniformHandle {
+	constexpr explicit UniformHandle(std::string_view name) : hash(uniformNameHash(name)) {}
+	uint32_t hash;
+};
 
 
+// Tag for the constructor that doesn't wait for the driver
+struct DeferredLink {};
+inline constexpr DeferredLink deferredLink{};
+
 class ShaderProgram {
 
 public:
-	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+	// defines go into both stages, see Shader. Comes from ProgramBinaryCache when
+	// the same sources were linked by the same driver before.
+	ShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines = "");
+
+	// Only starts compiling and linking, so several programs (and whatever else
+	// the CPU has to do) can overlap with the driver's work. Nothing else may be
+	// called before poll or wait said the program is done.
+	ShaderProgram(DeferredLink, const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines = "");
 	// Because we're using the ShaderProgramHandle to do RAII for the shader for us
 	// and our other types are trivial or provide their own RAII
 	// we don't have to provide any specialized functions here. Rule of zero
@@ -23,9 +59,33 @@ public:
 
 	// Public interface
 	bool recompile();
-	void use() const { glUseProgram(programID); }
+
+	// True once the program can be used. Never blocks with KHR_parallel_shader_compile,
+	// without it this is wait. Throws like the constructor if compiling failed.
+	bool poll();
+	void wait();
+	bool isReady() const { return !pending; }
+
+	void use() const { GLState::Instance()->UseProgram(programID); }
+
+	// Location of an active uniform, -1 if the program has none by that name
+	// (setting -1 is a no-op in GL, so optional uniforms need no special case)
+	template <typename T>
+	GLint location(UniformHandle<T> handle) const { return locationOf(handle.hash); }
+
+	// Writes go to this program, which has to be the one in use
+	void set(UniformHandle<int> handle, int value) const { glUniform1i(location(handle), value); }
+	void set(UniformHandle<bool> handle, bool value) const { glUniform1i(location(handle), value ? GL_TRUE : GL_FALSE); }
+	void set(UniformHandle<float> handle, float value) const { glUniform1f(location(handle), value); }
+	void set(UniformHandle<glm::vec3> handle, const glm::vec3& value) const { glUniform3fv(location(handle), 1, &value[0]); }
+	void set(UniformHandle<glm::vec4> handle, const glm::vec4& value) const { glUniform4fv(location(handle), 1, &value[0]); }
+	void set(UniformHandle<glm::mat4> handle, const glm::mat4& value) const { glUniformMatrix4fv(location(handle), 1, GL_FALSE, &value[0][0]); }
 
 	void friend attach(ShaderProgram& sp, Shader& s);
+	void friend detach(ShaderProgram& sp, Shader& s);
+
+	// Whether the driver compiles in the background and can say when it's done
+	static bool parallelCompileSupported();
 
 	operator GLuint() const {
 		return programID;
@@ -34,8 +94,33 @@ public:
 private:
 	ShaderProgramHandle programID;
 
-	Shader vertex;
-	Shader fragment;
+	// Shaders only exist while linking, a program loaded from the cache never has any
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::string defines;
 
 	bool checkAndLogLinkSuccess() const;
+
+	// What a deferred program needs until its link is checked
+	struct PendingLink {
+		std::unique_ptr<Shader> vertex;
+		std::unique_ptr<Shader> fragment;
+		uint64_t cacheKey;
+		std::chrono::steady_clock::time_point start;
+	};
+	std::unique_ptr<PendingLink> pending;
+
+	void finishLink();
+	void finishSetup(bool fromCache, std::chrono::steady_clock::time_point start);
+
+	// Every active uniform outside of a block, sorted by name hash. Built right after
+	// linking, so a recompiled program brings its own table along when it is moved in.
+	struct UniformLocation {
+		uint32_t hash;
+		GLint location;
+	};
+	std::vector<UniformLocation> uniforms;
+
+	void introspectUniforms();
+	GLint locationOf(uint32_t hash) const;
 };
@@ -1,6 +1,10 @@
 ﻿#include "SolarSystem.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
+#include <map>
 
 #include "GLDebug.h"
 #include "Log.h"
@@ -8,6 +12,8 @@
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 #include <imgui.h>
+#include <glm/gtc/constants.hpp>
+#include <stb/stb_image.h>
 
 #include "ShapeGenerator.hpp"
 
@@ -15,15 +21,55 @@
 // Step 2: Create the solar system with sun, earth and moon
 // Step 3: Add cube map texture for background and
 
+// Model and normal matrix of one draw, the rest of the block is left at its defaults
+static UniformBlocks::Object MakeObjectUniforms(SceneGraph const & sceneGraph, SceneGraph::NodeId const node)
+{
+    UniformBlocks::Object object{};
+    object.model = sceneGraph.World(node);
+    object.normalMatrix = sceneGraph.Normal(node);
+    return object;
+}
+
+// Below this many texels a map isn't made smaller to fit the memory budget
+static constexpr int MinBudgetTextureArea = 512 * 256;
+
+// The same map at another resolution sits next to it with another prefix, 2k_moon.jpg and 8k_moon.jpg.
+// The prefixes don't always match the size, so the header decides. Without one the path stays.
+static std::string SiblingOfSize(std::string const & path, glm::ivec2 const size)
+{
+    std::filesystem::path const file{path};
+    std::string const name = file.filename().string();
+    size_t const underscore = name.find('_');
+    if (underscore == std::string::npos)
+    {
+        return path;
+    }
+    for (char const * const prefix : {"1k", "2k", "4k", "8k", "16k"})
+    {
+        std::string const sibling = (file.parent_path() / (prefix + name.substr(underscore))).string();
+        glm::ivec2 siblingSize{0};
+        int components = 0;
+        if (stbi_info(sibling.c_str(), &siblingSize.x, &siblingSize.y, &components) != 0 && siblingSize == size)
+        {
+            return sibling;
+        }
+    }
+    return path;
+}
+
 //======================================================================================================================
 
 SolarSystem::SolarSystem()
 {
+    mStartTime = std::chrono::steady_clock::now();
     mPath = AssetPath::Instance();
     mTime = Time::Instance();
+    mGLState = GLState::Instance();
+    mGpuMemory = GpuMemory::Instance();
 
     glfwWindowHint(GLFW_SAMPLES, 32);
     mWindow = std::make_unique<Window>(800, 800, "Solar system");
+    mShaderCache = ProgramBinaryCache::Instance(); // needs the context, kept so its counts last the whole run
 
     // Standard ImGui/GLFW middleware
     IMGUI_CHECKVERSION();
@@ -45,82 +91,299 @@ SolarSystem::SolarSystem()
 
     mWindow->setCallbacks(mInputManager);
 
+    // Texture units never change, everything else comes from the uniform blocks. Variants compile
+    // when first drawn, so only the combinations the toggles actually reach are ever built.
+    // Created before anything else is loaded, so the driver compiles while textures decode.
+    mBasicShader = std::make_unique<ShaderPermutations>(
+        mPath->Get("shaders/test.vert"),
+        mPath->Get("shaders/test.frag"),
+        std::vector<std::string>{"UNLIT", "EARTH", "NIGHT_LIGHTS", "CLOUDS", "VIRTUAL_TEXTURE"},
+        [](ShaderProgram & program) -> void
+        {
+            static constexpr UniformHandle<int> DiffuseSampler("material.diffuse");
+            static constexpr UniformHandle<int> NightSampler("material.night");
+            static constexpr UniformHandle<int> CloudSampler("material.clouds");
+            static constexpr UniformHandle<int> IndirectionSampler("virtualIndirection");
+            static constexpr UniformHandle<int> AtlasSampler("virtualAtlas");
+            static constexpr UniformHandle<int> SpecularSampler("material.specular");
+            program.set(DiffuseSampler, 0);
+            program.set(NightSampler, 1);
+            program.set(CloudSampler, 2);
+            program.set(IndirectionSampler, 3);
+            program.set(AtlasSampler, 4);
+            program.set(SpecularSampler, 5);
+        }
+    );
+
+    // What the first frame draws with every toggle off, started here and checked on much later
+    for (uint32_t const features : {
+        uint32_t{UNLIT_FEATURE}, uint32_t{EARTH_FEATURE | VIRTUAL_TEXTURE_FEATURE}, uint32_t{VIRTUAL_TEXTURE_FEATURE}
+    })
+    {
+        mBasicShader->Request(features);
+    }
+
     // Setup sphere geometries
     mUnitSphereGeometry.resize(NUM_GEOMETRIES);
     mUnitSphereIndexCount.resize(NUM_GEOMETRIES);
 
     PrepareUnitSphereGeometry(); // make the spheres
+    BuildSceneGraph();
 
 
-    // Initialize textures vector
-    mTextures.resize(NUM_TEXTURES);
-    mTextures[SUN_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/2k_sun.jpg"), GL_LINEAR);
-    mTextures[EARTH_DAY_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/2k_earth_daymap.jpg"), GL_LINEAR);
-    mTextures[EARTH_NIGHT_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/2k_earth_nightmap.jpg"), GL_LINEAR);
-    mTextures[EARTH_CLOUDS_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/2k_earth_clouds.jpg"), GL_LINEAR);
-    mTextures[MOON_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/2k_moon.jpg"), GL_LINEAR);
-    mTextures[SKY_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/2k_stars_milky_way.jpg"), GL_LINEAR);
-    mTextures[MERCURY_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/8k_mercury.jpg"), GL_LINEAR);
-    mTextures[VENUS_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/8k_venus_surface.jpg"), GL_LINEAR);
-    mTextures[MARS_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/8k_mars.jpg"), GL_LINEAR);
-    mTextures[JUPITER_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/8k_jupiter.jpg"), GL_LINEAR);
-    mTextures[SATURN_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures82k_saturn.jpg"), GL_LINEAR);
-    mTextures[SATURN_RING_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/2k_saturn_ring_alpha.png"), GL_LINEAR);
-    mTextures[URANUS_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/2k_uranus.jpg"), GL_LINEAR);
-    mTextures[NEPTUNE_TEXTURE] = std::make_unique<Texture>(mPath->Get("textures/2k_neptune.jpg"), GL_LINEAR);
-
-    // Initialize planet data (relative sizes and distances scaled for visibility)
-    mPlanets.resize(8); // Mercury (0) to Neptune (7)
+    // Every texture starts out as roughly its average color and is decoded in the background, so the
+    // first frame doesn't wait for any of them. Clouds start out invisible.
+    struct TextureFile
+    {
+        char const * path;
+        glm::u8vec4 placeholder;
+    };
+    std::array<TextureFile, NUM_TEXTURES> textureFiles{};
+    textureFiles[SUN_TEXTURE] = {"textures/2k_sun.jpg", {240, 150, 40, 255}};
+    textureFiles[EARTH_DAY_TEXTURE] = {"textures/2k_earth_daymap.jpg", {50, 70, 100, 255}};
+    textureFiles[EARTH_NIGHT_TEXTURE] = {"textures/2k_earth_nightmap.jpg", {10, 10, 20, 255}};
+    textureFiles[EARTH_CLOUDS_TEXTURE] = {"textures/2k_earth_clouds.jpg", {0, 0, 0, 0}};
+    textureFiles[EARTH_SPECULAR_TEXTURE] = {"textures/EarthSpec.png", {180, 180, 180, 255}};
+    textureFiles[MOON_TEXTURE] = {"textures/2k_moon.jpg", {128, 128, 128, 255}};
+    textureFiles[SKY_TEXTURE] = {"textures/2k_stars_milky_way.jpg", {10, 10, 15, 255}};
+    textureFiles[MERCURY_TEXTURE] = {"textures/8k_mercury.jpg", {120, 115, 110, 255}};
+    textureFiles[VENUS_TEXTURE] = {"textures/4k_venus_atmosphere.jpg", {200, 170, 120, 255}};
+    textureFiles[MARS_TEXTURE] = {"textures/8k_mars.jpg", {180, 100, 60, 255}};
+    textureFiles[JUPITER_TEXTURE] = {"textures/8k_jupiter.jpg", {190, 170, 140, 255}};
+    textureFiles[SATURN_TEXTURE] = {"textures/8k_saturn.jpg", {200, 180, 140, 255}};
+    textureFiles[SATURN_RING_TEXTURE] = {"textures/2k_saturn_ring_alpha.png", {180, 160, 130, 128}};
+    textureFiles[URANUS_TEXTURE] = {"textures/2k_uranus.jpg", {160, 210, 220, 255}};
+    textureFiles[NEPTUNE_TEXTURE] = {"textures/2k_neptune.jpg", {60, 90, 200, 255}};
+
+    // Decoded copies live next to assets/, like the shader cache
+    std::filesystem::path const textureCache =
+        std::filesystem::path(mPath->Get("textures")).parent_path().parent_path() / "texture_cache";
+    mTextureLoader = std::make_unique<TextureLoader>(textureCache);
+    mVirtualTextures = std::make_unique<VirtualTextures>(
+        textureCache, mPath->Get("shaders/test.vert"), mPath->Get("shaders/vt_feedback.frag")
+    );
+    mEarthVirtualTexture = mVirtualTextures->Add(mPath->Get(textureFiles[EARTH_DAY_TEXTURE].path));
+    mMoonVirtualTexture = mVirtualTextures->Add(mPath->Get(textureFiles[MOON_TEXTURE].path));
+
+    // stb reads sizes from the headers without decoding. The paged maps only need their placeholder
+    // here, files that can't be read keep theirs too.
+    std::array<std::string, NUM_TEXTURES> texturePaths{};
+    std::array<glm::ivec2, NUM_TEXTURES> textureSizes{};
+    for (size_t i = 0; i < NUM_TEXTURES; ++i)
+    {
+        texturePaths[i] = mPath->Get(textureFiles[i].path);
+        bool const paged = i == EARTH_DAY_TEXTURE || i == MOON_TEXTURE;
+        int components = 0;
+        if (paged || stbi_info(texturePaths[i].c_str(), &textureSizes[i].x, &textureSizes[i].y, &components) == 0)
+        {
+            textureSizes[i] = glm::ivec2{1};
+        }
+    }
 
-    // Mercury
-    mPlanets[0] = {0.0f, 0.0f, 3.0f, 0.4f, 0.5f, 0.1f, 2.0f, 7.0f, 0.2f};
+    // One array per size, so bodies with maps of the same size draw without binding anything between them
+    auto const sizeClasses = [&textureSizes]() -> std::map<std::pair<int, int>, std::vector<size_t>>
+    {
+        std::map<std::pair<int, int>, std::vector<size_t>> classes{};
+        for (size_t i = 0; i < NUM_TEXTURES; ++i)
+        {
+            classes[{textureSizes[i].x, textureSizes[i].y}].emplace_back(i);
+        }
+        return classes;
+    };
 
-    // Venus
-    mPlanets[1] = {0.0f, 0.0f, 4.0f, 0.6f, 0.4f, 0.01f, 177.4f, 3.4f, 0.01f};
+    // Over the memory budget the largest maps step down a size at a time until everything fits. They
+    // switch to a sibling file of that size (8k_, 4k_, 2k_) if there is one, otherwise the loader
+    // takes their mip level of that size from the texture cache.
+    auto const arrayBytes = [&sizeClasses]() -> size_t
+    {
+        size_t bytes = 0;
+        for (auto const & [size, textures] : sizeClasses())
+        {
+            bytes += GpuMemory::TextureBytes(size.first, size.second, static_cast<int>(textures.size()));
+        }
+        return bytes;
+    };
+    while (mGpuMemory->Fits(arrayBytes()) == false)
+    {
+        auto const largest = std::max_element(textureSizes.begin(), textureSizes.end(), [](glm::ivec2 const & a, glm::ivec2 const & b) -> bool
+        {
+            return a.x * a.y < b.x * b.y;
+        });
+        glm::ivec2 const from = *largest;
+        if (from.x * from.y <= MinBudgetTextureArea)
+        {
+            Log::error("GPU memory budget: still {0} MB over with every map at its smallest", (mGpuMemory->Resident() + arrayBytes() - mGpuMemory->Budget()) >> 20);
+            break;
+        }
+        glm::ivec2 const to = glm::max(from / 2, glm::ivec2{1});
+        for (size_t i = 0; i < NUM_TEXTURES; ++i)
+        {
+            if (textureSizes[i] == from)
+            {
+                textureSizes[i] = to;
+                texturePaths[i] = SiblingOfSize(texturePaths[i], to);
+            }
+        }
+        Log::info("GPU memory budget: {0}x{1} maps down to {2}x{3}", from.x, from.y, to.x, to.y);
+    }
 
-    // Earth (already exists, but we'll add it here for completeness)
-    mPlanets[2] = {mEarthOrbitAngle, mEarthRotationAngle,    mEarthOrbitRadius,      0.5f, 0.2f, 2.0f,
-                   mEarthAxialTilt,  mEarthOrbitInclination, mEarthOrbitEccentricity};
+    for (auto const & [size, textures] : sizeClasses())
+    {
+        std::vector<glm::u8vec4> placeholders{};
+        for (size_t const i : textures)
+        {
+            mTextureLayers[i].array = static_cast<uint32_t>(mTextureArrays.size());
+            mTextureLayers[i].layer = static_cast<int>(placeholders.size());
+            placeholders.emplace_back(textureFiles[i].placeholder);
+        }
+        std::string const name = fmt::format("Maps {0}x{1} ({2} layers)", size.first, size.second, placeholders.size());
+        mTextureArrays.emplace_back(std::make_unique<TextureArray>(name, size.first, size.second, placeholders));
+        Log::info("Texture array {0}: {1}", mTextureArrays.size() - 1, name);
+    }
+    for (size_t i = 0; i < NUM_TEXTURES; ++i)
+    {
+        if (i != EARTH_DAY_TEXTURE && i != MOON_TEXTURE)
+        {
+            TextureLayer const & location = mTextureLayers[i];
+            mTextureLoader->Load(*mTextureArrays[location.array], location.layer, texturePaths[i]);
+        }
+    }
 
-    // Mars
-    mPlanets[3] = {0.0f, 0.0f, 6.0f, 0.4f, 0.15f, 1.0f, 25.2f, 1.9f, 0.09f};
+    // Initialize planet data (relative sizes and distances scaled for visibility)
+    // Values per body: orbit radius, size, orbit speed, rotation speed, axial tilt, orbit inclination, eccentricity
+    auto const addBody = [this](
+        BodyTable::BodyId const parent,
+        float const orbitRadius,
+        float const size,
+        float const orbitSpeed,
+        float const rotationSpeed,
+        float const axialTilt,
+        float const orbitInclination,
+        float const eccentricity
+    ) -> BodyTable::BodyId
+    {
+        return mBodies.Add(
+            MakeOrbit(orbitRadius, orbitSpeed, orbitInclination, eccentricity),
+            BodyTable::Physical{size, rotationSpeed, axialTilt},
+            parent
+        );
+    };
+
+    // Planets take their orbit speed from the Sun's gravitational parameter (Kepler's third law), so
+    // no value needs to be given for it
+    auto const addPlanet = [this](
+        float const orbitRadius,
+        float const size,
+        float const rotationSpeed,
+        float const axialTilt,
+        float const orbitInclination,
+        float const eccentricity
+    ) -> BodyTable::BodyId
+    {
+        double const cube = static_cast<double>(orbitRadius) * orbitRadius * orbitRadius;
+        return mBodies.Add(
+            MakeOrbit(orbitRadius, std::sqrt(mSunGravitationalParameter / cube), orbitInclination, eccentricity),
+            BodyTable::Physical{size, rotationSpeed, axialTilt},
+            mSunId
+        );
+    };
+
+    mSunId = mBodies.AddStatic(BodyTable::Physical{1.5f, 0.5f, 0.0f});
+
+    // Values per planet: orbit radius, size, rotation speed, axial tilt, orbit inclination, eccentricity
+    mPlanetIds.resize(8); // Mercury (0) to Neptune (7)
+    mPlanetIds[0] = addPlanet(3.0f, 0.4f, 0.1f, 2.0f, 7.0f, 0.2f); // Mercury
+    mPlanetIds[1] = addPlanet(4.0f, 0.6f, 0.01f, 177.4f, 3.4f, 0.01f); // Venus
+    mPlanetIds[2] = addPlanet(mEarthOrbitRadius, 0.5f, 2.0f, mEarthAxialTilt, mEarthOrbitInclination, mEarthOrbitEccentricity); // Earth
+    mPlanetIds[3] = addPlanet(6.0f, 0.4f, 1.0f, 25.2f, 1.9f, 0.09f); // Mars
+    mPlanetIds[4] = addPlanet(8.0f, 1.2f, 1.5f, 3.1f, 1.3f, 0.05f); // Jupiter
+    mPlanetIds[5] = addPlanet(10.0f, 1.0f, 1.2f, 26.7f, 2.5f, 0.06f); // Saturn
+    mPlanetIds[6] = addPlanet(12.0f, 0.8f, 0.8f, 97.8f, 0.8f, 0.05f); // Uranus
+    mPlanetIds[7] = addPlanet(14.0f, 0.7f, 0.7f, 28.3f, 1.8f, 0.01f); // Neptune
+    mEarthId = mPlanetIds[2];
+
+    // Moons (just doing Earth's moon and Jupiter's 4 largest as example)
+    // Earth's moon shares Earth's orbit plane
+    mMoonId = addBody(mEarthId, mMoonOrbitRadius, 0.2f, mMoonOrbitSpeed, 0.1f, mMoonAxialTilt, mEarthOrbitInclination, mMoonOrbitEccentricity);
 
-    // Jupiter
-    mPlanets[4] = {0.0f, 0.0f, 8.0f, 1.2f, 0.05f, 1.5f, 3.1f, 1.3f, 0.05f};
+    // Jupiter's moons (Galilean moons)
+    addBody(mPlanetIds[4], 1.5f, 0.15f, 0.8f, 0.05f, 0.0f, 0.0f, 0.0f); // Io
+    addBody(mPlanetIds[4], 2.0f, 0.2f, 0.6f, 0.05f, 0.0f, 0.0f, 0.0f); // Europa
+    addBody(mPlanetIds[4], 2.5f, 0.25f, 0.4f, 0.05f, 0.0f, 0.0f, 0.0f); // Ganymede
+    addBody(mPlanetIds[4], 3.0f, 0.2f, 0.3f, 0.05f, 0.0f, 0.0f, 0.0f); // Callisto
 
-    // Saturn
-    mPlanets[5] = {0.0f, 0.0f, 10.0f, 1.0f, 0.03f, 1.2f, 26.7f, 2.5f, 0.06f};
+    // The SIMD kernels are checked against the scalar one by orbital-tests
+    Log::info("Kepler solver: {0}", CpuFeatures::Name(KeplerBatch::Selected()));
 
-    // Uranus
-    mPlanets[6] = {0.0f, 0.0f, 12.0f, 0.8f, 0.02f, 0.8f, 97.8f, 0.8f, 0.05f};
+    // Belt bodies orbit the same Sun as the planets
+    mAsteroidBelt = std::make_unique<AsteroidBelt>(mSunGravitationalParameter);
+    mAsteroidRenderer = std::make_unique<AsteroidRenderer>();
 
-    // Neptune
-    mPlanets[7] = {0.0f, 0.0f, 14.0f, 0.7f, 0.01f, 0.7f, 28.3f, 1.8f, 0.01f};
+    // Real planet positions are optional, the file is large and not part of the repo
+    try
+    {
+        mEphemeris = std::make_unique<Ephemeris>(mPath->Get(EphemerisFile));
+        mEphemerisEpoch = std::clamp(Ephemeris::J2000, mEphemeris->StartDate(), mEphemeris->EndDate());
+        Log::info(
+            "Ephemeris: DE{0}, JD {1:.1f} to {2:.1f}",
+            mEphemeris->Version(), mEphemeris->StartDate(), mEphemeris->EndDate()
+        );
+    }
+    catch (std::exception const & exception)
+    {
+        Log::info("Ephemeris: not available ({0}), only model orbits", exception.what());
+    }
 
-    // Initialize moons (just doing Earth's moon and Jupiter's 4 largest as example)
-    mMoons.resize(8); // Moons for each planet
+    // Same for the minor planets, parsed on every core while the rest of the startup is cheap anyway
+    try
+    {
+        mMinorPlanets = std::make_unique<MinorPlanetCatalog>(
+            MinorPlanetCatalog::Load(mPath->Get(MinorPlanetFile), *ThreadPool::Instance())
+        );
+        Log::info(
+            "MPCORB: {0} orbits in {1:.3f} s ({2} lines skipped)",
+            mMinorPlanets->Size(), mMinorPlanets->LoadSeconds(), mMinorPlanets->RejectedLines()
+        );
+    }
+    catch (std::exception const & exception)
+    {
+        Log::info("MPCORB: not available ({0}), only generated belts", exception.what());
+    }
 
-    // Earth's moon (already exists)
-    mMoons[2].push_back({mMoonOrbitAngle, mMoonRotationAngle, mMoonOrbitRadius, 0.2f, 0.5f, 0.1f, mMoonAxialTilt, 0.0f,
-                         mMoonOrbitEccentricity});
+    FixedUpdate(0.0);
+    SnapRenderState();
 
-    // Jupiter's moons (Galilean moons)
-    mMoons[4].push_back({0.0f, 0.0f, 1.5f, 0.15f, 0.8f, 0.05f, 0.0f, 0.0f, 0.0f}); // Io
-    mMoons[4].push_back({0.0f, 0.0f, 2.0f, 0.2f, 0.6f, 0.05f, 0.0f, 0.0f, 0.0f}); // Europa
-    mMoons[4].push_back({0.0f, 0.0f, 2.5f, 0.25f, 0.4f, 0.05f, 0.0f, 0.0f, 0.0f}); // Ganymede
-    mMoons[4].push_back({0.0f, 0.0f, 3.0f, 0.2f, 0.3f, 0.05f, 0.0f, 0.0f, 0.0f}); // Callisto
+    mFrameUniforms = std::make_unique<UniformBuffer>(UniformBlocks::FRAME_BINDING, sizeof(UniformBlocks::Frame));
+    mObjectUniforms = std::make_unique<UniformBuffer>(UniformBlocks::OBJECT_BINDING, sizeof(UniformBlocks::Object), NUM_OBJECTS);
+    mBodiesTimer = std::make_unique<GpuTimer>();
 
-    mBasicShader = std::make_unique<ShaderProgram>(mPath->Get("shaders/test.vert"), mPath->Get("shaders/test.frag"));
+    // The unlit variant stands in for any other that is still compiling, so it's the only one waited for
+    (void)mBasicShader->Get(UNLIT_FEATURE);
+    Log::info(
+        "Shader programs: {0} from cache, {1} compiled, {2} still compiling, {3:.1f} ms",
+        mShaderCache->Hits(), mShaderCache->Misses(), mBasicShader->PendingCount(), mShaderCache->Milliseconds()
+    );
 
     // Set camera
     mTurnTableCamera = std::make_unique<TurnTableCamera>();
     mTurnTableCamera->SetTargetBody(TurnTableCamera::TargetBody::SUN); // Starts at the sun
+
+    // The first frame has something to draw before the simulation thread gets going
+    Publish(std::chrono::steady_clock::now(), 1.0 / static_cast<double>(mSimulationRate));
+    mSimulationThread = std::thread([this]() -> void { SimulationLoop(); });
 }
 
 //======================================================================================================================
 
 SolarSystem::~SolarSystem()
 {
+    // Before anything the simulation uses goes away
+    mStopSimulation = true;
+    if (mSimulationThread.joinable())
+    {
+        mSimulationThread.join();
+    }
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -135,14 +398,21 @@ void SolarSystem::Run()
         glfwPollEvents(); // Propagate events to the callback class
 
         mTime->Update();
-        Update(mTime->DeltaTimeSec());
+        HandleInput(mTime->DeltaTimeSec());
+
+        // One finished image per frame at most, an 8k upload alone takes a while
+        mTextureLoader->Update();
+
+        // Newest state the simulation thread has finished, or the one from last frame if there is none yet
+        mSnapshots.Acquire();
+        Snapshot const & snapshot = mSnapshots.ReadBuffer();
 
         glClearColor(0.2f, 0.6f, 0.8f, 1.0f);
         // https://www.viewsonic.com/library/creative-work/srgb-vs-adobe-rgb-which-one-to-use/
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear render screen (all zero) and depth (all max depth)
         glViewport(0, 0, mWindow->getWidth(), mWindow->getHeight());
 
-        Render();
+        Render(snapshot);
 
         // glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui (if used)
 
@@ -151,18 +421,26 @@ void SolarSystem::Run()
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
-        UI();
+        UI(snapshot);
 
         ImGui::Render(); 
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); 
 
         mWindow->swapBuffers(); 
+        mGLState->EndFrame();
+
+        if (mFirstFrameShown == false)
+        {
+            mFirstFrameShown = true;
+            double const milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStartTime).count();
+            Log::info("First frame after {0:.1f} ms, {1} textures still loading", milliseconds, mTextureLoader->PendingCount());
+        }
     }
 }
 
 //======================================================================================================================
 
-void SolarSystem::Update(float const deltaTime)
+void SolarSystem::HandleInput(float const deltaTime)
 {
     auto const cursorPosition = mInputManager->CursorPosition();
 
@@ -176,311 +454,648 @@ void SolarSystem::Update(float const deltaTime)
         }
     }
 
-    if (mIsAnimating) // if animation is playing
-    {
-        // Clouds are moving
-        mCloudRotationAngle += deltaTime * mCloudRotationSpeed * mAnimationSpeed;
-
-        // Update animation angles using kepler's laws for the orbits 
-        float timeDelta = deltaTime * mAnimationSpeed;
-
-        // Earth moves faster when closer to sun
-        float earthAngularVelocity = 0.2f * pow(1.0f + mEarthOrbitEccentricity * cos(mEarthOrbitAngle), 2) / pow(1.0f - mEarthOrbitEccentricity * mEarthOrbitEccentricity, 1.5f);
-        mEarthOrbitAngle += timeDelta * earthAngularVelocity;
-        mEarthRotationAngle += timeDelta * 2.0f;
+    mCursorPositionIsSetOnce = true;
+    mPreviousCursorPosition = cursorPosition;
+}
 
-        // Moon does the same thing around earth
-        float moonAngularVelocity = 0.5f * pow(1.0f + mMoonOrbitEccentricity * cos(mMoonOrbitAngle), 2) / pow(1.0f - mMoonOrbitEccentricity * mMoonOrbitEccentricity, 1.5f);
-        mMoonOrbitAngle += timeDelta * moonAngularVelocity;
+//======================================================================================================================
 
-        // Sun rotation
-        mSunRotationAngle += timeDelta * 0.5f;
-    }
+void SolarSystem::SimulationLoop()
+{
+    using Clock = std::chrono::steady_clock;
 
+    // Steps are due at fixed points in real time, independent of when frames happen
+    Clock::time_point nextStep = Clock::now();
+    while (mStopSimulation == false)
+    {
+        bool const edited = RunCommands();
 
-    mCursorPositionIsSetOnce = true;
-    mPreviousCursorPosition = cursorPosition;
+        double const stepSeconds = 1.0 / static_cast<double>(mSimulationRate);
+        auto const stepDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(stepSeconds));
+        Clock::time_point const now = Clock::now();
 
-    if (mIsAnimating)
-    {
-        float timeDelta = deltaTime * mAnimationSpeed;
+        if (mIsAnimating == false)
+        {
+            // Nothing moves, so there is nothing to publish unless an edit from the UI has to show up. The
+            // snapshot is dated a whole step back so it shows as is instead of blending in.
+            if (edited)
+            {
+                FixedUpdate(0.0);
+                mPreviousRenderState = mRenderState;
+                Publish(now - stepDuration, stepSeconds);
+            }
+            nextStep = now + stepDuration;
+            std::this_thread::sleep_until(nextStep);
+            continue;
+        }
 
-        // Update all planets
-        for (auto &planet : mPlanets)
+        if (now < nextStep)
         {
-            // Update orbit angle based on Kepler's laws
-            float angularVelocity = planet.orbitSpeed * pow(1.0f + planet.eccentricity * cos(planet.orbitAngle), 2) /
-                pow(1.0f - planet.eccentricity * planet.eccentricity, 1.5f);
-            planet.orbitAngle += timeDelta * angularVelocity;
+            std::this_thread::sleep_until(nextStep);
+            continue;
+        }
 
-            // Update rotation
-            planet.rotationAngle += timeDelta * planet.rotationSpeed;
+        // Animation speed scales how much simulation time a step covers, not how many steps there are
+        int steps = 0;
+        while (nextStep <= now && steps < MaxStepsPerBatch)
+        {
+            FixedUpdate(stepSeconds * static_cast<double>(mAnimationSpeed));
+            nextStep += stepDuration;
+            ++steps;
         }
+        Publish(nextStep - stepDuration, stepSeconds);
 
-        // Update all moons
-        for (auto &moons : mMoons)
+        if (nextStep <= now)
         {
-            for (auto &moon : moons)
-            {
-                float angularVelocity = moon.orbitSpeed * pow(1.0f + moon.eccentricity * cos(moon.orbitAngle), 2) /
-                    pow(1.0f - moon.eccentricity * moon.eccentricity, 1.5f);
-                moon.orbitAngle += timeDelta * angularVelocity;
-                moon.rotationAngle += timeDelta * moon.rotationSpeed;
-            }
+            // Steps cost more than real time allows, fall behind instead of spiraling
+            nextStep = now + stepDuration;
         }
+    }
+}
+
+//======================================================================================================================
 
-        // Update clouds (existing)
-        mCloudRotationAngle += deltaTime * mCloudRotationSpeed * mAnimationSpeed;
+void SolarSystem::Post(std::function<void()> command)
+{
+    std::lock_guard<std::mutex> const lock(mCommandMutex);
+    mCommands.emplace_back(std::move(command));
+}
+
+//======================================================================================================================
+
+bool SolarSystem::RunCommands()
+{
+    std::vector<std::function<void()>> commands{};
+    {
+        std::lock_guard<std::mutex> const lock(mCommandMutex);
+        commands.swap(mCommands);
+    }
+    for (auto const & command : commands)
+    {
+        command();
     }
+    return commands.empty() == false;
 }
 
 //======================================================================================================================
 
-void SolarSystem::Render()
+void SolarSystem::Publish(std::chrono::steady_clock::time_point const stepTime, double const stepSeconds)
 {
-    glEnable(GL_DEPTH_TEST); 
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Slots are reused, so the instance copies normally don't allocate
+    Snapshot & snapshot = mSnapshots.WriteBuffer();
+    snapshot.stepTime = stepTime;
+    snapshot.stepSeconds = stepSeconds;
+    snapshot.previous = mPreviousRenderState;
+    snapshot.latest = mRenderState;
+
+    // The slot may already hold these instances from an earlier publish, a million of them are 32 MB to copy
+    if (snapshot.asteroidStep != mAsteroidStep || snapshot.asteroidGeneration != mAsteroidBelt->Generation())
+    {
+        snapshot.previousInstances.assign(mAsteroidBelt->PreviousInstances().begin(), mAsteroidBelt->PreviousInstances().end());
+        snapshot.instances.assign(mAsteroidBelt->Instances().begin(), mAsteroidBelt->Instances().end());
+        snapshot.asteroidStep = mAsteroidStep;
+        snapshot.asteroidGeneration = mAsteroidBelt->Generation();
+    }
+
+    snapshot.gravityMode = mGravityMode;
+    snapshot.asteroidRegion = mAsteroidBelt->GetRegion();
+    snapshot.asteroidUpdateMs = mAsteroidBelt->UpdateTimeMs();
+    snapshot.nBodySettings = mNBody.GetSettings();
+    snapshot.nBodyCount = mNBody.Size();
+    snapshot.treeNodeCount = mNBody.TreeNodeCount();
+    snapshot.nBodyStepMs = mNBodyStepMs;
+    snapshot.energyDrift = mGravityMode == GravityMode::N_BODY ? mNBody.EnergyDrift() : 0.0;
+    snapshot.ephemerisDate = mGravityMode == GravityMode::EPHEMERIS ? EphemerisDate() : 0.0;
+    snapshot.ephemerisQueryUs = mEphemerisQueryUs;
+
+    mSnapshots.Publish();
+}
 
-    // Calculate current animation time=
-    float currentTime = static_cast<float>(glfwGetTime());
-    float deltaTime = 0.0f;
+//======================================================================================================================
 
-    // Only update animation if it's playing and we have a previous time
-    if (mIsAnimating && mLastAnimationTime > 0.0f)
+void SolarSystem::FixedUpdate(double const simulationDelta)
+{
+    mPreviousRenderState = mRenderState;
+
+    // Orbits are evaluated from the simulation clock in UpdateOrbits
+    auto const delta = static_cast<float>(simulationDelta);
+    mSimulationTime += simulationDelta;
+    mNBodyAccumulator += simulationDelta;
+    mSunRotationAngle += delta * 0.5f;
+    mEarthRotationAngle += delta * 2.0f;
+    mMoonRotationAngle += delta * 0.1f;
+    mCloudRotationAngle += delta * mCloudRotationSpeed.load();
+
+    UpdateOrbits();
+    if (mGravityMode == GravityMode::N_BODY)
     {
-        deltaTime = (currentTime - mLastAnimationTime) * mAnimationSpeed;
+        UpdateNBody();
+    }
+    else if (mGravityMode == GravityMode::EPHEMERIS)
+    {
+        UpdateEphemeris();
+    }
+
+    mRenderState = CaptureRenderState();
+    ++mStepCount;
 
-        // Update animation angles
-        mSunRotationAngle += deltaTime * 0.5f; // Sun rotates 
-        mEarthOrbitAngle += deltaTime * 0.2f; // Earth orbits sun
-        mEarthRotationAngle += deltaTime * 2.0f; // Earth rotates
-        mMoonOrbitAngle += deltaTime * 0.5f; // Moon orbits earth
-        mMoonRotationAngle += deltaTime * 0.1f; // Moon rotates
+    // A zero step only re-evaluates for edits, the asteroids haven't moved unless the belt was replaced or snapped
+    if (simulationDelta != 0.0 || mAsteroidBelt->Generation() != mAsteroidGeneration)
+    {
+        if (mGravityMode == GravityMode::N_BODY && mAsteroidsInNBody)
+        {
+            mAsteroidBelt->Update(mNBody, mAsteroidNBodyOffset);
+        }
+        else
+        {
+            mAsteroidBelt->Update(mSimulationTime);
+        }
+        mAsteroidStep = mStepCount;
+        mAsteroidGeneration = mAsteroidBelt->Generation();
     }
-    mLastAnimationTime = currentTime; // remember this time for next frame
+}
 
-    mBasicShader->use();
+//======================================================================================================================
 
-    // Calculate aspect ratio: width/height
-    float aspectRatio = static_cast<float>(mWindow->getWidth()) / static_cast<float>(mWindow->getHeight());
+SolarSystem::RenderState SolarSystem::CaptureRenderState() const
+{
+    RenderState state{};
+    state.sunPosition = Math::ToRenderSpace(BodyPosition(mSunId));
+    state.earthPosition = Math::ToRenderSpace(BodyPosition(mEarthId));
+    state.moonPosition = Math::ToRenderSpace(BodyPosition(mMoonId));
+    state.sunRotationAngle = mSunRotationAngle;
+    state.earthRotationAngle = mEarthRotationAngle;
+    state.moonRotationAngle = mMoonRotationAngle;
+    state.cloudRotationAngle = mCloudRotationAngle;
+    return state;
+}
 
-    // Create perspective projection matrix
-    auto projection = glm::perspective(glm::radians(mFovY), aspectRatio, mZNear, mZFar);
-    glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "projection"), 1, GL_FALSE, &projection[0][0]);
+//======================================================================================================================
 
-    // Get camera view matrix from turntable camera
-    auto view = mTurnTableCamera->ViewMatrix();
-    glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "view"), 1, GL_FALSE, &view[0][0]);
+SolarSystem::RenderState SolarSystem::InterpolatedRenderState(Snapshot const & snapshot, float const interpolation)
+{
+    // Angles are never wrapped, so a plain lerp never takes the long way around
+    RenderState const & from = snapshot.previous;
+    RenderState const & to = snapshot.latest;
+    float const t = interpolation;
+
+    RenderState state{};
+    state.sunPosition = glm::mix(from.sunPosition, to.sunPosition, t);
+    state.earthPosition = glm::mix(from.earthPosition, to.earthPosition, t);
+    state.moonPosition = glm::mix(from.moonPosition, to.moonPosition, t);
+    state.sunRotationAngle = Math::Lerp(from.sunRotationAngle, to.sunRotationAngle, t);
+    state.earthRotationAngle = Math::Lerp(from.earthRotationAngle, to.earthRotationAngle, t);
+    state.moonRotationAngle = Math::Lerp(from.moonRotationAngle, to.moonRotationAngle, t);
+    state.cloudRotationAngle = Math::Lerp(from.cloudRotationAngle, to.cloudRotationAngle, t);
+    return state;
+}
 
-    // Get camera position for specular lighting calculations
-    glm::vec3 cameraPos = mTurnTableCamera->GetPosition();
-    glUniform3fv(glGetUniformLocation(*mBasicShader, "viewPos"), 1, &cameraPos[0]);
+//======================================================================================================================
 
-    // light position is at the origin, which is center of the sun
-    glm::vec3 lightPos(0.0f, 0.0f, 0.0f);
+float SolarSystem::Interpolation(Snapshot const & snapshot)
+{
+    // The latest step stands for the state at stepTime, one step later the next one will be in. Until
+    // then this frame is somewhere between the two steps the snapshot holds.
+    double const sinceStep = std::chrono::duration<double>(std::chrono::steady_clock::now() - snapshot.stepTime).count();
+    return static_cast<float>(std::clamp(sinceStep / snapshot.stepSeconds, 0.0, 1.0));
+}
 
-    // Light properties:
-    // - Ambient: base lighting level
-    // - Diffuse: directional lighting, depends on surface angle to light
-    // - Specular: shiny highlights
-    glm::vec3 lightAmbient(0.3f, 0.3f, 0.3f); // Low ambient light
-    glm::vec3 lightDiffuse(0.8f, 0.8f, 0.8f); // Bright directional light
-    glm::vec3 lightSpecular(1.0f, 1.0f, 1.0f); // Strong highlights
+//======================================================================================================================
 
-    // Send light properties to shader
-    glUniform3fv(glGetUniformLocation(*mBasicShader, "light.position"), 1, &lightPos[0]);
-    glUniform3fv(glGetUniformLocation(*mBasicShader, "light.ambient"), 1, &lightAmbient[0]);
-    glUniform3fv(glGetUniformLocation(*mBasicShader, "light.diffuse"), 1, &lightDiffuse[0]);
-    glUniform3fv(glGetUniformLocation(*mBasicShader, "light.specular"), 1, &lightSpecular[0]);
+void SolarSystem::SnapRenderState()
+{
+    mRenderState = CaptureRenderState();
+    mPreviousRenderState = mRenderState;
+    mAsteroidBelt->SnapInstances();
+}
 
-    // Draw the sky sphere
-    {
-        // no transformation as it's the sky sphere
-        auto model = glm::mat4(1.0f);
-        glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, &model[0][0]);
+//======================================================================================================================
+
+void SolarSystem::UpdateOrbits()
+{
+    // Positions come straight from the elements at the current time, so nothing drifts with frame rate
+    mBodies.Propagate(mSimulationTime);
+}
+
+//======================================================================================================================
+
+void SolarSystem::StartNBody()
+{
+    // Mass relative to the Sun, Mercury (0) to Neptune (7)
+    static constexpr double PlanetMassRatios[8] = {1.66e-7, 2.45e-6, 3.00e-6, 3.23e-7, 9.55e-4, 2.86e-4, 4.37e-5, 5.15e-5};
+    static constexpr double AsteroidMassRatio = 1e-12;
+
+    // Every planet orbit was built with the Sun's gravitational parameter, which is G * M, so the Sun's
+    // mass is that divided by G
+    double const sunMass = mSunGravitationalParameter / mNBody.GetSettings().gravitationalConstant;
 
-        // Tell shader this is the sun, so no lighting calculations)
-        glUniform1i(glGetUniformLocation(*mBasicShader, "isSun"), GL_TRUE);
+    mNBody.Clear();
+    mNBodyIndexOfBody.assign(*std::max_element(mPlanetIds.begin(), mPlanetIds.end()) + 1, NotSimulated);
+    mNBodyAccumulator = 0.0;
 
-        // Bind sky texture to texture unit 0
-        glActiveTexture(GL_TEXTURE0);
-        mTextures[SKY_TEXTURE]->bind();
-        glUniform1i(glGetUniformLocation(*mBasicShader, "material.diffuse"), 0);
+    std::vector<Kepler::OrbitalElements> planetOrbits(mPlanetIds.size());
+    std::vector<double> planetMasses(mPlanetIds.size());
+    for (size_t i = 0; i < mPlanetIds.size(); ++i)
+    {
+        planetOrbits[i] = mBodies.Orbit(mPlanetIds[i]);
+        planetMasses[i] = sunMass * PlanetMassRatios[i];
+    }
 
-        // draw the sky sphere
-        mUnitSphereGeometry[SKY_GEOMETRY]->bind();
-        glDrawElements(GL_TRIANGLES, mUnitSphereIndexCount[SKY_GEOMETRY], GL_UNSIGNED_INT, nullptr);
+    // The Sun recoils against the planets so the system as a whole doesn't wander off
+    size_t const sunIndex = mNBody.AddCentralSystem(sunMass, planetOrbits, planetMasses, mSimulationTime);
+    mNBodyIndexOfBody[mSunId] = sunIndex;
+    for (size_t i = 0; i < mPlanetIds.size(); ++i)
+    {
+        mNBodyIndexOfBody[mPlanetIds[i]] = sunIndex + 1 + i;
     }
 
-    // Draw the sun
+    mAsteroidsInNBody = mAsteroidBelt->Count() <= NBodyMaxAsteroids;
+    if (mAsteroidsInNBody)
     {
-        // Sun only rotates on its axis
-        auto model = glm::rotate(glm::mat4(1.0f), mSunRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-        glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, &model[0][0]);
+        mAsteroidNBodyOffset = mAsteroidBelt->SeedNBody(mNBody, mSimulationTime, sunMass * AsteroidMassRatio);
+    }
+    else
+    {
+        Log::warn("N-body: {0} asteroids is too many to simulate, they keep their fixed orbits", mAsteroidBelt->Count());
+    }
 
-        // Tell shader this is the sun, it emits light, doesn't need lighting
-        glUniform1i(glGetUniformLocation(*mBasicShader, "isSun"), GL_TRUE);
+    auto & settings = mNBody.GetSettings();
+    if (settings.solver == NBodySystem::ForceSolver::DIRECT && mNBody.Size() > DirectSummation::MaxBodies)
+    {
+        Log::warn("N-body: {0} bodies is too many for direct summation, using Barnes-Hut", mNBody.Size());
+        settings.solver = NBodySystem::ForceSolver::BARNES_HUT;
+    }
+}
 
-        // bind sun texture
-        glActiveTexture(GL_TEXTURE0);
-        mTextures[SUN_TEXTURE]->bind();
-        glUniform1i(glGetUniformLocation(*mBasicShader, "material.diffuse"), 0);
+//======================================================================================================================
 
-        // draw the sun sphere
-        mUnitSphereGeometry[SUN_GEOMETRY]->bind();
-        glDrawElements(GL_TRIANGLES, mUnitSphereIndexCount[SUN_GEOMETRY], GL_UNSIGNED_INT, nullptr);
+void SolarSystem::UpdateNBody()
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    // Fixed steps out of an accumulator, if we fall behind the leftover time is dropped rather than piling up
+    int steps = 0;
+    while (mNBodyAccumulator >= NBodyTimeStep && steps < NBodyMaxStepsPerFrame)
+    {
+        mNBody.Step(NBodyTimeStep);
+        mNBodyAccumulator -= NBodyTimeStep;
+        ++steps;
+    }
+    if (steps == NBodyMaxStepsPerFrame)
+    {
+        mNBodyAccumulator = std::min(mNBodyAccumulator, NBodyTimeStep);
+    }
+
+    if (steps > 0)
+    {
+        float const elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        mNBodyStepMs = Math::Lerp(mNBodyStepMs, elapsedMs / static_cast<float>(steps), 0.1f);
     }
+}
+
+//======================================================================================================================
 
-    // Draw Earth
+void SolarSystem::UpdateEphemeris()
+{
+    static constexpr double RealMoonSemiMajorAxis = 384'400.0; // km
+
+    auto const start = std::chrono::steady_clock::now();
+    double const julianDate = EphemerisDate();
+
+    mEphemerisPositions.assign(mBodies.Size(), std::nullopt);
+    for (size_t i = 0; i < mPlanetIds.size(); ++i)
     {
-        // is5 units from sun along x axis
-        // Earth orbits sun and rotates on axis
-        // Orbital transformation hierarchy
-        auto earthOrbitModel = glm::rotate(glm::mat4(1.0f), glm::radians(mEarthOrbitInclination), glm::vec3(0.0f, 0.0f, 1.0f)); // tilt of orbit plane
-        float earthDistance = mEarthOrbitSemiMajorAxis * (1.0f - mEarthOrbitEccentricity * mEarthOrbitEccentricity) / (1.0f + mEarthOrbitEccentricity * cos(mEarthOrbitAngle)); // calculate current distance in elliptical orbit
-        earthOrbitModel = glm::rotate(earthOrbitModel, mEarthOrbitAngle, glm::vec3(0.0f, 1.0f, 0.0f)); // rotate around the sun based on orbit angle
-        earthOrbitModel = glm::translate(earthOrbitModel, glm::vec3(earthDistance, 0.0f, 0.0f)); // move to the current orbital position
+        auto const body = static_cast<Ephemeris::Body>(i); // Mercury to Neptune are in the same order
+        glm::dvec3 const heliocentric = Ephemeris::EquatorialToEcliptic(
+            mEphemeris->Relative(body, Ephemeris::Body::SUN, julianDate).position
+        ) / mEphemeris->AstronomicalUnit();
+        double const scale = Kepler::SemiMajorAxis(mBodies.Orbit(mPlanetIds[i])) / RealSemiMajorAxes[i];
+        mEphemerisPositions[mPlanetIds[i]] = heliocentric * scale;
+    }
 
-        // Earth's own rotation, axial tilt + spin
-        auto earthRotation = glm::rotate(glm::mat4(1.0f), glm::radians(mEarthAxialTilt), glm::vec3(0.0f, 0.0f, 1.0f));
-        earthRotation = glm::rotate(earthRotation, mEarthRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f)); 
+    glm::dvec3 const geocentricMoon = Ephemeris::EquatorialToEcliptic(
+        mEphemeris->Relative(Ephemeris::Body::MOON, Ephemeris::Body::EARTH, julianDate).position
+    );
+    double const moonScale = Kepler::SemiMajorAxis(mBodies.Orbit(mMoonId)) / RealMoonSemiMajorAxis;
+    mEphemerisPositions[mMoonId] = *mEphemerisPositions[mEarthId] + geocentricMoon * moonScale;
 
-        // Combine orbit and rotation transformations
-        auto earthModel = earthOrbitModel * earthRotation;
+    float const elapsedUs = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+    mEphemerisQueryUs = Math::Lerp(mEphemerisQueryUs, elapsedUs / static_cast<float>(mPlanetIds.size() + 1), 0.1f);
+}
 
-        // earth's model matrix to shader
-        glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, &earthModel[0][0]);
-        glUniform1i(glGetUniformLocation(*mBasicShader, "isSun"), GL_FALSE);
-        glUniform1i(glGetUniformLocation(*mBasicShader, "isEarth"), GL_TRUE); 
-        glUniform1i(glGetUniformLocation(*mBasicShader, "showNightTexture"), mShowNightTexture);
-        glUniform1i(glGetUniformLocation(*mBasicShader, "showClouds"), mShowClouds);
+//======================================================================================================================
 
-        // bind earth texture
-        glActiveTexture(GL_TEXTURE0);
-        mTextures[EARTH_DAY_TEXTURE]->bind();
-        glUniform1i(glGetUniformLocation(*mBasicShader, "material.diffuse"), 0);
+double SolarSystem::EphemerisDate() const
+{
+    return std::clamp(
+        mEphemerisEpoch + mSimulationTime * DaysPerTimeUnit(),
+        mEphemeris->StartDate(),
+        mEphemeris->EndDate()
+    );
+}
 
-        // bind night texture even when not showing night lights
-        glActiveTexture(GL_TEXTURE1);
-        mTextures[EARTH_NIGHT_TEXTURE]->bind();
-        glUniform1i(glGetUniformLocation(*mBasicShader, "material.night"), 1);
+//======================================================================================================================
 
-        // Set earth material properties
-        glm::vec3 earthSpecular(1.0f, 1.0f, 1.0f); // Shiny like oceans
-        float earthShininess = 64.0f; // how sharp the highlights are
-        glUniform3fv(glGetUniformLocation(*mBasicShader, "material.specular"), 1, &earthSpecular[0]);
-        glUniform1f(glGetUniformLocation(*mBasicShader, "material.shininess"), earthShininess);
+double SolarSystem::DaysPerTimeUnit() const
+{
+    return 365.25 * Kepler::MeanMotion(mBodies.Orbit(mEarthId)) / glm::two_pi<double>();
+}
 
-        // Draw the earth sphere
-        mUnitSphereGeometry[EARTH_GEOMETRY]->bind();
-        glDrawElements(GL_TRIANGLES, mUnitSphereIndexCount[EARTH_GEOMETRY], GL_UNSIGNED_INT, nullptr);
+//======================================================================================================================
 
-        // Render clouds if enabled
-        if (mShowClouds)
+double SolarSystem::SceneDistance(double const astronomicalUnits) const
+{
+    // Starts at the Sun, past Neptune the last segment is carried on
+    double realStart = 0.0;
+    double sceneStart = 0.0;
+    for (size_t i = 0; i < RealSemiMajorAxes.size(); ++i)
+    {
+        double const realEnd = RealSemiMajorAxes[i];
+        double const sceneEnd = Kepler::SemiMajorAxis(mBodies.Orbit(mPlanetIds[i]));
+        if (astronomicalUnits <= realEnd || i + 1 == RealSemiMajorAxes.size())
         {
-            glEnable(GL_BLEND); // Enable transparency
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Standard alpha blending
+            return sceneStart + (astronomicalUnits - realStart) * (sceneEnd - sceneStart) / (realEnd - realStart);
+        }
+        realStart = realEnd;
+        sceneStart = sceneEnd;
+    }
+    return astronomicalUnits;
+}
 
-            // Cloud model uses earth's position but adds independent rotation
-            auto cloudModel = earthOrbitModel * earthRotation; // Start with earth's transform
-            cloudModel = glm::rotate(cloudModel, mCloudRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-            cloudModel = glm::scale(cloudModel, glm::vec3(1.005f)); // Slightly larger than earth
+//======================================================================================================================
 
-            // send cloud's model to shader
-            glUniform1f(glGetUniformLocation(*mBasicShader, "cloudRotationAngle"), mCloudRotationAngle);
-            glUniform1i(glGetUniformLocation(*mBasicShader, "showClouds"), GL_TRUE);
+void SolarSystem::GenerateAsteroids(AsteroidBelt::Region const region, size_t const count)
+{
+    if (region == AsteroidBelt::Region::CATALOG && mMinorPlanets != nullptr)
+    {
+        AsteroidBelt::SceneMapping mapping{};
+        mapping.distance = [this](double const astronomicalUnits) -> double { return SceneDistance(astronomicalUnits); };
+        mapping.epoch = mEphemerisEpoch; // so the belt lines up with the ephemeris planets
+        mAsteroidBelt->Load(*mMinorPlanets, count, mapping);
+    }
+    else
+    {
+        mAsteroidBelt->Generate(region, count);
+    }
 
-            // bind cloud texture
-            glActiveTexture(GL_TEXTURE2);
-            mTextures[EARTH_CLOUDS_TEXTURE]->bind();
-            glUniform1i(glGetUniformLocation(*mBasicShader, "material.clouds"), 2);
+    if (mGravityMode == GravityMode::N_BODY)
+    {
+        StartNBody();
+    }
+}
 
-            // Draw clouds sphere using same geometry as earth
-            glDrawElements(GL_TRIANGLES, mUnitSphereIndexCount[EARTH_GEOMETRY], GL_UNSIGNED_INT, nullptr);
+//======================================================================================================================
 
-            glDisable(GL_BLEND); // Turn off blending
+glm::dvec3 SolarSystem::BodyPosition(BodyTable::BodyId const id) const
+{
+    if (mGravityMode == GravityMode::N_BODY)
+    {
+        if (id < mNBodyIndexOfBody.size() && mNBodyIndexOfBody[id] != NotSimulated)
+        {
+            return mNBody.Position(mNBodyIndexOfBody[id]);
+        }
+    }
+    else if (mGravityMode == GravityMode::EPHEMERIS)
+    {
+        if (id < mEphemerisPositions.size() && mEphemerisPositions[id].has_value())
+        {
+            return *mEphemerisPositions[id];
         }
     }
 
-    // Draw Moon
+    if (mGravityMode != GravityMode::KEPLER)
     {
-        // Start with Earth's orbital transform
-        auto model = glm::rotate(glm::mat4(1.0f), glm::radians(mEarthOrbitInclination), glm::vec3(0.0f, 0.0f, 1.0f));
-        float earthDistance = mEarthOrbitSemiMajorAxis * (1.0f - mEarthOrbitEccentricity * mEarthOrbitEccentricity) / (1.0f + mEarthOrbitEccentricity * cos(mEarthOrbitAngle)); // calculate Earth's current position
-        model = glm::rotate(model, mEarthOrbitAngle, glm::vec3(0.0f, 1.0f, 0.0f)); // apply earth's orbital rotation and position
-        model = glm::translate(model, glm::vec3(earthDistance, 0.0f, 0.0f));
+        // Moons follow their Kepler orbit around wherever the parent actually is
+        BodyTable::BodyId const parent = mBodies.Parent(id);
+        if (parent != BodyTable::InvalidId)
+        {
+            return BodyPosition(parent) + (mBodies.Position(id) - mBodies.Position(parent));
+        }
+    }
+    return mBodies.Position(id);
+}
+
+//======================================================================================================================
+
+Kepler::OrbitalElements SolarSystem::MakeOrbit(
+    float const orbitRadius,
+    double const orbitSpeed,
+    float const orbitInclination,
+    float const eccentricity
+)
+{
+    // Node and periapsis are picked so the inclination tilts the orbit about the scene's z axis with
+    // periapsis on +x, matching how the orbits were laid out before the propagator existed
+    return Kepler::FromMeanMotion(
+        orbitRadius,
+        eccentricity,
+        orbitSpeed,
+        glm::radians(static_cast<double>(orbitInclination)),
+        glm::radians(270.0),
+        glm::radians(90.0),
+        0.0,
+        0.0
+    );
+}
 
-        // Moon's orbit around Earth
-        float moonDistance = mMoonOrbitSemiMajorAxis * (1.0f - mMoonOrbitEccentricity * mMoonOrbitEccentricity) / (1.0f + mMoonOrbitEccentricity * cos(mMoonOrbitAngle));
-        model = glm::rotate(model, mMoonOrbitAngle, glm::vec3(0.0f, 1.0f, 0.0f)); // apply moon's orbital rotation and position
-        model = glm::translate(model, glm::vec3(moonDistance, 0.0f, 0.0f));
+//======================================================================================================================
+
+void SolarSystem::Render(Snapshot const & snapshot)
+{
+    mGLState->SetEnabled(GL_DEPTH_TEST, true);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Moon's axial tilt and rotation
-        model = glm::rotate(model, glm::radians(mMoonAxialTilt), glm::vec3(0.0f, 0.0f, 1.0f));
-        model = glm::rotate(model, mMoonRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
+    // Everything that moves is blended between the last two simulation steps
+    float const interpolation = Interpolation(snapshot);
+    RenderState const state = InterpolatedRenderState(snapshot, interpolation);
+    UpdateSceneGraph(state);
 
-        glUniformMatrix4fv(glGetUniformLocation(*mBasicShader, "model"), 1, GL_FALSE, &model[0][0]);
-        glUniform1i(glGetUniformLocation(*mBasicShader, "isSun"), GL_FALSE);
-        glUniform1i(glGetUniformLocation(*mBasicShader, "isEarth"), GL_FALSE);
-        glUniform1i(glGetUniformLocation(*mBasicShader, "showNightTexture"), GL_FALSE);
-        glUniform1i(glGetUniformLocation(*mBasicShader, "showClouds"), GL_FALSE);
+    // Calculate aspect ratio: width/height
+    float aspectRatio = static_cast<float>(mWindow->getWidth()) / static_cast<float>(mWindow->getHeight());
 
-        // bind moon texture, bind moon texture
-        glActiveTexture(GL_TEXTURE0);
-        mTextures[MOON_TEXTURE]->bind();
-        glUniform1i(glGetUniformLocation(*mBasicShader, "material.diffuse"), 0);
+    // Camera, light and time for every shader, one upload for the whole frame
+    UniformBlocks::Frame frame{};
+    frame.projection = glm::perspective(glm::radians(mFovY), aspectRatio, mZNear, mZFar);
+    frame.view = mTurnTableCamera->ViewMatrix();
+    frame.viewPosition = glm::vec4{mTurnTableCamera->GetPosition(), 1.0f}; // for specular lighting
+
+    // light position is at the center of the sun
+    // - Ambient: base lighting level
+    // - Diffuse: directional lighting, depends on surface angle to light
+    // - Specular: shiny highlights
+    frame.lightPosition = glm::vec4{mSceneGraph.WorldPosition(mSunNode), 1.0f};
+    frame.lightAmbient = glm::vec4{0.3f, 0.3f, 0.3f, 1.0f}; // Low ambient light
+    frame.lightDiffuse = glm::vec4{0.8f, 0.8f, 0.8f, 1.0f}; // Bright directional light
+    frame.lightSpecular = glm::vec4{1.0f, 1.0f, 1.0f, 1.0f}; // Strong highlights
+    frame.time = glm::vec4{static_cast<float>(glfwGetTime()), interpolation, 0.0f, 0.0f};
+    mFrameUniforms->Set(0, frame);
+    mFrameUniforms->Upload(1);
+
+    // Sky and sun are unlit and only sample their diffuse map, repeating it in the other slots keeps
+    // them to a single array. The moon has no night side or clouds of its own.
+    Material const skyMaterial{SKY_TEXTURE, SKY_TEXTURE, SKY_TEXTURE, SKY_TEXTURE};
+    Material const sunMaterial{SUN_TEXTURE, SUN_TEXTURE, SUN_TEXTURE, SUN_TEXTURE};
+    Material const earthMaterial{EARTH_DAY_TEXTURE, EARTH_NIGHT_TEXTURE, EARTH_CLOUDS_TEXTURE, EARTH_SPECULAR_TEXTURE};
+    Material const moonMaterial{MOON_TEXTURE, MOON_TEXTURE, MOON_TEXTURE, MOON_TEXTURE};
+    auto const materialLayers = [this](Material const & material) -> glm::vec4
+    {
+        glm::vec4 layers{0.0f};
+        for (glm::length_t slot = 0; slot < 4; ++slot)
+        {
+            layers[slot] = static_cast<float>(mTextureLayers[material[slot]].layer);
+        }
+        return layers;
+    };
 
-        glActiveTexture(GL_TEXTURE1);
-        mTextures[MOON_TEXTURE]->bind(); // Use same texture for night since moon has no night texture
-        glUniform1i(glGetUniformLocation(*mBasicShader, "material.night"), 1);
-
-        // Moon material properties, less shiny than earth
-        glm::vec3 moonSpecular(0.3f, 0.3f, 0.3f);
-        float moonShininess = 8.0f;
-        glUniform3fv(glGetUniformLocation(*mBasicShader, "material.specular"), 1, &moonSpecular[0]);
-        glUniform1f(glGetUniformLocation(*mBasicShader, "material.shininess"), moonShininess);
+    // Every object's matrices and material go up together, each draw then only binds its slot
+    {
+        // no transformation as it's the sky sphere, lit like the sun (no lighting calculations)
+        UniformBlocks::Object sky{};
+        sky.layers = materialLayers(skyMaterial);
+        mObjectUniforms->Set(SKY_OBJECT, sky);
+
+        // Sun only rotates on its axis, it emits light, doesn't need lighting
+        UniformBlocks::Object sun = MakeObjectUniforms(mSceneGraph, mSunSpinNode);
+        sun.layers = materialLayers(sunMaterial);
+        mObjectUniforms->Set(SUN_OBJECT, sun);
+
+        // Earth orbits sun and rotates on axis, shiny like oceans with sharp highlights
+        UniformBlocks::Object earth = MakeObjectUniforms(mSceneGraph, mEarthSpinNode);
+        earth.specular = glm::vec4{1.0f, 1.0f, 1.0f, 64.0f};
+        earth.virtualTexture = mVirtualTextures->ObjectParameters(mEarthVirtualTexture);
+        earth.layers = materialLayers(earthMaterial);
+        mObjectUniforms->Set(EARTH_OBJECT, earth);
+
+        // Cloud shell, same maps as earth so it draws without binding anything else
+        UniformBlocks::Object clouds = MakeObjectUniforms(mSceneGraph, mCloudNode);
+        clouds.clouds.x = mCloudOpacity;
+        clouds.layers = materialLayers(earthMaterial);
+        mObjectUniforms->Set(CLOUDS_OBJECT, clouds);
+
+        // Moon's orbit around earth, axial tilt and rotation. Less shiny than earth.
+        UniformBlocks::Object moon = MakeObjectUniforms(mSceneGraph, mMoonSpinNode);
+        moon.specular = glm::vec4{0.3f, 0.3f, 0.3f, 8.0f};
+        moon.virtualTexture = mVirtualTextures->ObjectParameters(mMoonVirtualTexture);
+        moon.layers = materialLayers(moonMaterial);
+        mObjectUniforms->Set(MOON_OBJECT, moon);
+
+        mObjectUniforms->Upload(NUM_OBJECTS);
+    }
 
-        // Draw the moon sphere
-        mUnitSphereGeometry[MOON_GEOMETRY]->bind();
-        glDrawElements(GL_TRIANGLES, mUnitSphereIndexCount[MOON_GEOMETRY], GL_UNSIGNED_INT, nullptr);
+    // Which pages earth and moon need, read back a frame or two later
+    if (mVirtualTextures->BeginFeedback(mWindow->getWidth(), mWindow->getHeight()))
+    {
+        for (auto const & [object, mesh] : {std::pair{EARTH_OBJECT, EARTH_GEOMETRY}, std::pair{MOON_OBJECT, MOON_GEOMETRY}})
+        {
+            mObjectUniforms->Bind(object);
+            mUnitSphereGeometry[mesh]->bind();
+            glDrawElements(GL_TRIANGLES, mUnitSphereIndexCount[mesh], GL_UNSIGNED_INT, nullptr);
+        }
+        mVirtualTextures->EndFeedback();
     }
+    mVirtualTextures->Update();
+
+    // Bodies only describe their draws, the queue picks the order
+    auto const viewDepth = [&frame](glm::vec3 const & position) -> float
+    {
+        return -(frame.view * glm::vec4{position, 1.0f}).z;
+    };
+    auto const submit = [this](
+        RenderQueue::Pass const pass,
+        uint32_t const features,
+        float const depth,
+        Material const & material,
+        SphereIndex const mesh,
+        ObjectIndex const object,
+        VirtualTextures::TextureId const virtualTexture = VirtualTextures::NoTexture
+    ) -> void
+    {
+        // Layers come from the object block, only the arrays are state
+        auto const arrayCount = static_cast<uint32_t>(mTextureArrays.size());
+        uint32_t textureSet = 0;
+        for (TextureIndex const texture : material)
+        {
+            textureSet = textureSet * arrayCount + mTextureLayers[texture].array;
+        }
+
+        // Unlit until the real variant is compiled, layers on top just wait for it
+        uint32_t shaderFeatures = features;
+        ShaderProgram * shader = mBasicShader->TryGet(features);
+        if (shader == nullptr)
+        {
+            if (pass == RenderQueue::Pass::TRANSPARENT)
+            {
+                return;
+            }
+            shaderFeatures = UNLIT_FEATURE;
+            shader = &mBasicShader->Get(UNLIT_FEATURE);
+        }
+
+        RenderQueue::DrawPacket packet{};
+        packet.key = RenderQueue::MakeKey(pass, shaderFeatures, textureSet, mesh, depth, mZFar);
+        packet.shader = shader;
+        packet.geometry = mUnitSphereGeometry[mesh].get();
+        packet.indexCount = mUnitSphereIndexCount[mesh];
+        static constexpr std::array<size_t, 4> MaterialUnits{0, 1, 2, 5}; // as set up for mBasicShader
+        for (size_t slot = 0; slot < material.size(); ++slot)
+        {
+            packet.textures[MaterialUnits[slot]] = {GL_TEXTURE_2D_ARRAY, mTextureArrays[mTextureLayers[material[slot]].array]->Id()};
+        }
+        if (virtualTexture != VirtualTextures::NoTexture)
+        {
+            packet.textures[3] = {GL_TEXTURE_2D, mVirtualTextures->Indirection(virtualTexture)};
+            packet.textures[4] = {GL_TEXTURE_2D, mVirtualTextures->Atlas()};
+        }
+        packet.objectSlot = object;
+        mRenderQueue.Submit(packet);
+    };
+
+    // The toggles pick shader variants, so no fragment branches on them
+    uint32_t const earthFeatures = EARTH_FEATURE | VIRTUAL_TEXTURE_FEATURE |
+        (mShowNightTexture ? NIGHT_LIGHTS_FEATURE : 0u);
+    float const earthDepth = viewDepth(mSceneGraph.WorldPosition(mEarthNode));
+    submit(RenderQueue::Pass::SKY, UNLIT_FEATURE, 0.0f, skyMaterial, SKY_GEOMETRY, SKY_OBJECT);
+    submit(RenderQueue::Pass::OPAQUE, UNLIT_FEATURE, viewDepth(mSceneGraph.WorldPosition(mSunNode)), sunMaterial, SUN_GEOMETRY, SUN_OBJECT);
+    submit(RenderQueue::Pass::OPAQUE, earthFeatures, earthDepth, earthMaterial, EARTH_GEOMETRY, EARTH_OBJECT, mEarthVirtualTexture);
+    submit(RenderQueue::Pass::OPAQUE, VIRTUAL_TEXTURE_FEATURE, viewDepth(mSceneGraph.WorldPosition(mMoonNode)), moonMaterial, MOON_GEOMETRY, MOON_OBJECT, mMoonVirtualTexture);
+    if (mShowClouds)
+    {
+        // Own slightly larger node and sphere pass, blended on top of earth
+        submit(RenderQueue::Pass::TRANSPARENT, CLOUDS_FEATURE, earthDepth, earthMaterial, EARTH_GEOMETRY, CLOUDS_OBJECT);
+    }
+    mBodiesTimer->Begin();
+    mRenderQueue.Execute(*mObjectUniforms);
+    mBodiesTimer->End();
+
+    // Every asteroid in one draw
+    mAsteroidRenderer->Render(
+        snapshot.instances,
+        snapshot.previousInstances,
+        snapshot.asteroidStep,
+        snapshot.asteroidGeneration
+    );
 
     // Update camera target if following a sphere
-    if (mTurnTableCamera->GetTargetBody() != TurnTableCamera::TargetBody::NONE && mIsAnimating)
+    if (mTurnTableCamera->GetTargetBody() != TurnTableCamera::TargetBody::NONE && mIsAnimating.load())
     {
         glm::vec3 targetPos;
 
         switch (mTurnTableCamera->GetTargetBody())
         {
         case TurnTableCamera::TargetBody::SUN:
-            targetPos = glm::vec3(0.0f); // Sun is always at origin
+            targetPos = mSceneGraph.WorldPosition(mSunNode); // origin unless N-body gravity moves it
             break;
 
         case TurnTableCamera::TargetBody::EARTH:
-            {
-                // Calculate Earth's current position
-                auto earthOrbit = glm::rotate(glm::mat4(1.0f), glm::radians(mEarthOrbitInclination), glm::vec3(0.0f, 0.0f, 1.0f));
-                float earthDistance = mEarthOrbitSemiMajorAxis * (1.0f - mEarthOrbitEccentricity * mEarthOrbitEccentricity) / (1.0f + mEarthOrbitEccentricity * cos(mEarthOrbitAngle));
-                earthOrbit = glm::rotate(earthOrbit, mEarthOrbitAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-                earthOrbit = glm::translate(earthOrbit, glm::vec3(earthDistance, 0.0f, 0.0f));
-                targetPos = glm::vec3(earthOrbit * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-                break;
-            }
+            targetPos = mSceneGraph.WorldPosition(mEarthNode);
+            break;
 
         case TurnTableCamera::TargetBody::MOON:
-            {
-                // Calculate Moon's current position 
-                auto earthOrbit = glm::rotate(glm::mat4(1.0f), glm::radians(mEarthOrbitInclination), glm::vec3(0.0f, 0.0f, 1.0f));
-                float earthDistance = mEarthOrbitSemiMajorAxis * (1.0f - mEarthOrbitEccentricity * mEarthOrbitEccentricity) / (1.0f + mEarthOrbitEccentricity * cos(mEarthOrbitAngle));
-                earthOrbit = glm::rotate(earthOrbit, mEarthOrbitAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-                earthOrbit = glm::translate(earthOrbit, glm::vec3(earthDistance, 0.0f, 0.0f));
-
-                float moonDistance = mMoonOrbitSemiMajorAxis * (1.0f - mMoonOrbitEccentricity * mMoonOrbitEccentricity) / (1.0f + mMoonOrbitEccentricity * cos(mMoonOrbitAngle));
-                auto moonOrbit = glm::rotate(earthOrbit, mMoonOrbitAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-                moonOrbit = glm::translate(moonOrbit, glm::vec3(moonDistance, 0.0f, 0.0f));
-                targetPos = glm::vec3(moonOrbit * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-                break;
-            }
+            targetPos = mSceneGraph.WorldPosition(mMoonNode);
+            break;
+
+        case TurnTableCamera::TargetBody::NONE:
+            break;
         }
         // Update camera to follow the target
         mTurnTableCamera->UpdateTargetPosition(targetPos);
@@ -489,7 +1104,54 @@ void SolarSystem::Render()
 
 //======================================================================================================================
 
-void SolarSystem::UI()
+void SolarSystem::BuildSceneGraph()
+{
+    mSunNode = mSceneGraph.Add();
+    mSunSpinNode = mSceneGraph.Add(mSunNode);
+    mEarthNode = mSceneGraph.Add();
+    mEarthSpinNode = mSceneGraph.Add(mEarthNode);
+    mCloudNode = mSceneGraph.Add(mEarthSpinNode);
+    mMoonNode = mSceneGraph.Add(mEarthNode);
+    mMoonSpinNode = mSceneGraph.Add(mMoonNode);
+}
+
+//======================================================================================================================
+
+void SolarSystem::UpdateSceneGraph(RenderState const & state)
+{
+    static constexpr glm::vec3 SpinAxis{0.0f, 1.0f, 0.0f};
+    static constexpr glm::vec3 TiltAxis{0.0f, 0.0f, 1.0f};
+
+    // Sun only rotates on its axis
+    mSceneGraph.SetLocal(mSunNode, glm::translate(glm::mat4(1.0f), state.sunPosition));
+    mSceneGraph.SetLocal(mSunSpinNode, glm::rotate(glm::mat4(1.0f), state.sunRotationAngle, SpinAxis));
+
+    // Earth's own rotation, axial tilt + spin
+    mSceneGraph.SetLocal(mEarthNode, glm::translate(glm::mat4(1.0f), state.earthPosition));
+    mSceneGraph.SetLocal(
+        mEarthSpinNode,
+        glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(mEarthAxialTilt), TiltAxis), state.earthRotationAngle, SpinAxis)
+    );
+
+    // Clouds drift on top of Earth's spin, just above the surface
+    mSceneGraph.SetLocal(
+        mCloudNode,
+        glm::scale(glm::rotate(glm::mat4(1.0f), state.cloudRotationAngle, SpinAxis), glm::vec3{1.005f})
+    );
+
+    // Moon's position includes Earth's, the node only keeps the offset
+    mSceneGraph.SetLocal(mMoonNode, glm::translate(glm::mat4(1.0f), state.moonPosition - state.earthPosition));
+    mSceneGraph.SetLocal(
+        mMoonSpinNode,
+        glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(mMoonAxialTilt), TiltAxis), state.moonRotationAngle, SpinAxis)
+    );
+
+    mSceneNodesUpdated = mSceneGraph.Update();
+}
+
+//======================================================================================================================
+
+void SolarSystem::UI(Snapshot const & snapshot)
 {
     ImGui::Begin("Solar System Controls");
 
@@ -501,23 +1163,66 @@ void SolarSystem::UI()
 
     ImGui::SameLine();
     if (ImGui::Button("Reset")) // Reset button
-    {   // Reset all rotation angles to zero
-        mSunRotationAngle = 0.0f;
-        mEarthOrbitAngle = 0.0f;
-        mEarthRotationAngle = 0.0f;
-        mMoonOrbitAngle = 0.0f;
-        mMoonRotationAngle = 0.0f;
+    {   // Reset all rotation angles and the simulation clock to zero
+        Post([this]() -> void
+        {
+            mSunRotationAngle = 0.0f;
+            mEarthRotationAngle = 0.0f;
+            mMoonRotationAngle = 0.0f;
+            mSimulationTime = 0.0;
+            UpdateOrbits();
+            if (mGravityMode == GravityMode::N_BODY)
+            {
+                StartNBody();
+            }
+            FixedUpdate(0.0);
+            SnapRenderState();
+        });
     }
 
-    ImGui::SliderFloat("Animation Speed", &mAnimationSpeed, 0.1f, 5.0f);
+    float animationSpeed = mAnimationSpeed;
+    if (ImGui::SliderFloat("Animation Speed", &animationSpeed, 0.1f, 5.0f))
+    {
+        mAnimationSpeed = animationSpeed;
+    }
+    int simulationRate = mSimulationRate;
+    if (ImGui::SliderInt("Simulation Rate (Hz)", &simulationRate, 10, 240)) // Steps per second, frames blend between them
+    {
+        mSimulationRate = simulationRate;
+    }
     ImGui::Text("FPS: %.1f", 1.0f / mTime->DeltaTimeSec());
+    ImGui::Text("Transforms Updated: %zu / %zu", mSceneNodesUpdated, mSceneGraph.Size()); // 0 while nothing moves
+    ImGui::Text("Shader Variants: %zu (%zu compiling)", mBasicShader->VariantCount(), mBasicShader->PendingCount()); // Grows as toggles reach new combinations
+    ImGui::Text(
+        "Shader Programs: %zu cached, %zu compiled, %.1f ms", // Every program so far, NO_SHADER_CACHE=1 to compare
+        mShaderCache->Hits(), mShaderCache->Misses(), mShaderCache->Milliseconds()
+    );
+    ImGui::Text("GPU Bodies: %.3f ms", mBodiesTimer->Milliseconds()); // Sun, planets, moon and sky, a few frames behind
+    ImGui::Text("Textures Loading: %zu", mTextureLoader->PendingCount()); // Placeholders until this reaches 0
+    ImGui::Text(
+        "Virtual Pages: %zu / %zu resident, %zu pending, %zu evicted", // Earth and moon, grows as the camera closes in
+        mVirtualTextures->ResidentPages(), VirtualTextures::SlotCount(), mVirtualTextures->PendingPages(), mVirtualTextures->Evictions()
+    );
+    GLState::Counters const & glCalls = mGLState->LastFrame(); // Binds that reached GL last frame
+    ImGui::Text(
+        "GL Binds: %zu programs, %zu VAOs, %zu textures, %zu blend (%zu skipped)",
+        glCalls.programs, glCalls.vertexArrays, glCalls.textures, glCalls.blendToggles, glCalls.skipped
+    );
+    if (ImGui::CollapsingHeader("GPU Memory"))
+    {
+        DrawGpuMemoryTable();
+    }
     ImGui::Separator();
 
     ImGui::Checkbox("Show Night Lights", &mShowNightTexture); // Toggle for showing city lights on Earth's night side
     ImGui::Checkbox("Show Clouds", &mShowClouds); // Toggle for showing cloud layer
     if (mShowClouds)
     {
-        ImGui::SliderFloat("Cloud Speed", &mCloudRotationSpeed, 0.0f, 1.0f); // Only show cloud speed control if clouds are visible
+        float cloudRotationSpeed = mCloudRotationSpeed;
+        if (ImGui::SliderFloat("Cloud Speed", &cloudRotationSpeed, 0.0f, 1.0f)) // Only show cloud speed control if clouds are visible
+        {
+            mCloudRotationSpeed = cloudRotationSpeed;
+        }
     }
 
     ImGui::Separator();
@@ -538,13 +1243,173 @@ void SolarSystem::UI()
     }
     ImGui::Separator();
     ImGui::Text("Orbit Settings:"); // Sliders to control how elliptical the orbits are
-    ImGui::SliderFloat("Earth Orbit Eccentricity", &mEarthOrbitEccentricity, 0.0f, 0.5f);  // Earth's orbit eccentricity (0 = perfect circle, 0.5 = noticeably oval)
-    ImGui::SliderFloat("Moon Orbit Eccentricity", &mMoonOrbitEccentricity, 0.0f, 0.5f); // Moon's orbit eccentricity
+    if (ImGui::SliderFloat("Earth Orbit Eccentricity", &mEarthOrbitEccentricity, 0.0f, 0.5f))  // Earth's orbit eccentricity (0 = perfect circle, 0.5 = noticeably oval)
+    {
+        Post([this, eccentricity = mEarthOrbitEccentricity]() -> void
+        {
+            mBodies.SetOrbit(mEarthId, MakeOrbit(mEarthOrbitRadius, mEarthOrbitSpeed, mEarthOrbitInclination, eccentricity));
+        });
+    }
+    if (ImGui::SliderFloat("Moon Orbit Eccentricity", &mMoonOrbitEccentricity, 0.0f, 0.5f)) // Moon's orbit eccentricity
+    {
+        Post([this, eccentricity = mMoonOrbitEccentricity]() -> void
+        {
+            mBodies.SetOrbit(mMoonId, MakeOrbit(mMoonOrbitRadius, mMoonOrbitSpeed, mEarthOrbitInclination, eccentricity));
+        });
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Asteroids:");
+    int region = static_cast<int>(snapshot.asteroidRegion);
+    bool regenerate = ImGui::RadioButton("Off", &region, static_cast<int>(AsteroidBelt::Region::NONE));
+    ImGui::SameLine();
+    regenerate |= ImGui::RadioButton("Main Belt", &region, static_cast<int>(AsteroidBelt::Region::MAIN_BELT));
+    ImGui::SameLine();
+    regenerate |= ImGui::RadioButton("Kuiper Belt", &region, static_cast<int>(AsteroidBelt::Region::KUIPER_BELT));
+    ImGui::SameLine();
+    ImGui::BeginDisabled(mMinorPlanets == nullptr); // Needs assets/catalogs/MPCORB.DAT
+    regenerate |= ImGui::RadioButton("MPCORB", &region, static_cast<int>(AsteroidBelt::Region::CATALOG));
+    ImGui::EndDisabled();
+    regenerate |= ImGui::RadioButton("10k", &mAsteroidCountIndex, 0);
+    ImGui::SameLine();
+    regenerate |= ImGui::RadioButton("100k", &mAsteroidCountIndex, 1);
+    ImGui::SameLine();
+    regenerate |= ImGui::RadioButton("1M", &mAsteroidCountIndex, 2);
+    if (regenerate)
+    {
+        Post([this, region = static_cast<AsteroidBelt::Region>(region), count = AsteroidCounts[mAsteroidCountIndex]]() -> void
+        {
+            GenerateAsteroids(region, count);
+        });
+    }
+    if (snapshot.instances.empty() == false)
+    {
+        ImGui::Text("Instances: %zu", snapshot.instances.size());
+        ImGui::Text("Average FPS: %.1f", ImGui::GetIO().Framerate); // ImGui averages over the last 60 frames
+        ImGui::Text("CPU Update: %.2f ms", snapshot.asteroidUpdateMs);
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Gravity:");
+    int gravityMode = static_cast<int>(snapshot.gravityMode);
+    bool gravityModeChanged = ImGui::RadioButton("Kepler", &gravityMode, static_cast<int>(GravityMode::KEPLER));
+    ImGui::SameLine();
+    gravityModeChanged |= ImGui::RadioButton("N-Body", &gravityMode, static_cast<int>(GravityMode::N_BODY));
+    ImGui::SameLine();
+    ImGui::BeginDisabled(mEphemeris == nullptr); // Needs assets/ephemeris/JPLEPH
+    gravityModeChanged |= ImGui::RadioButton("Ephemeris", &gravityMode, static_cast<int>(GravityMode::EPHEMERIS));
+    ImGui::EndDisabled();
+    if (gravityModeChanged) // Switching back to Kepler resumes the closed-form orbits
+    {
+        Post([this, mode = static_cast<GravityMode>(gravityMode)]() -> void
+        {
+            mGravityMode = mode;
+            if (mGravityMode == GravityMode::N_BODY)
+            {
+                StartNBody();
+            }
+            else if (mGravityMode == GravityMode::EPHEMERIS)
+            {
+                UpdateEphemeris();
+            }
+            SnapRenderState();
+        });
+    }
+    if (snapshot.gravityMode == GravityMode::N_BODY)
+    {
+        auto const & settings = snapshot.nBodySettings;
+        int solver = static_cast<int>(settings.solver);
+        bool solverChanged = ImGui::RadioButton("Barnes-Hut", &solver, static_cast<int>(NBodySystem::ForceSolver::BARNES_HUT));
+        ImGui::SameLine();
+        ImGui::BeginDisabled(snapshot.nBodyCount > DirectSummation::MaxBodies); // O(N^2) stops being interactive past this
+        solverChanged |= ImGui::RadioButton("Direct", &solver, static_cast<int>(NBodySystem::ForceSolver::DIRECT));
+        ImGui::EndDisabled();
+        if (solverChanged)
+        {
+            Post([this, solver = static_cast<NBodySystem::ForceSolver>(solver)]() -> void
+            {
+                mNBody.GetSettings().solver = solver;
+            });
+        }
+
+        if (settings.solver == NBodySystem::ForceSolver::BARNES_HUT)
+        {
+            float openingAngle = static_cast<float>(settings.openingAngle);
+            if (ImGui::SliderFloat("Opening Angle", &openingAngle, 0.0f, 1.0f)) // 0 = exact, larger = faster and rougher
+            {
+                Post([this, openingAngle]() -> void
+                {
+                    mNBody.GetSettings().openingAngle = openingAngle;
+                });
+            }
+            ImGui::Text("Bodies: %zu (%zu tree nodes)", snapshot.nBodyCount, snapshot.treeNodeCount);
+        }
+        else
+        {
+            ImGui::Text("Bodies: %zu", snapshot.nBodyCount);
+        }
+        ImGui::Text("Step: %.2f ms", snapshot.nBodyStepMs);
+        ImGui::Text("Energy Drift: %+.3e", snapshot.energyDrift);
+    }
+    else if (snapshot.gravityMode == GravityMode::EPHEMERIS)
+    {
+        ImGui::Text("DE%d, JD %.2f TDB", mEphemeris->Version(), snapshot.ephemerisDate);
+        ImGui::Text("Query: %.2f us/body", snapshot.ephemerisQueryUs);
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Kepler Solver: %s", CpuFeatures::Name(KeplerBatch::Selected())); // orbital-benchmark measures them all
     ImGui::End();
 }
 
 //======================================================================================================================
 
+void SolarSystem::DrawGpuMemoryTable() const
+{
+    constexpr double MB = 1.0 / (1024.0 * 1024.0);
+    if (mGpuMemory->Budget() > 0)
+    {
+        ImGui::Text("%.1f / %.1f MB", static_cast<double>(mGpuMemory->Resident()) * MB, static_cast<double>(mGpuMemory->Budget()) * MB);
+    }
+    else
+    {
+        ImGui::Text("%.1f MB, no budget (GPU_MEMORY_BUDGET_MB)", static_cast<double>(mGpuMemory->Resident()) * MB);
+    }
+
+    // Objects with the same name and category are one row, all the geometry or all the uniform buffers
+    std::map<std::pair<GpuMemory::Category, std::string>, size_t> assets{};
+    for (auto const & [id, entry] : mGpuMemory->Entries())
+    {
+        assets[{entry.category, entry.name}] += entry.bytes;
+    }
+    std::vector<std::pair<std::pair<GpuMemory::Category, std::string>, size_t>> rows(assets.begin(), assets.end());
+    std::sort(rows.begin(), rows.end(), [](auto const & a, auto const & b) -> bool
+    {
+        return a.second > b.second;
+    });
+
+    if (ImGui::BeginTable("GpuMemory", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+    {
+        ImGui::TableSetupColumn("Asset");
+        ImGui::TableSetupColumn("Category");
+        ImGui::TableSetupColumn("MB");
+        ImGui::TableHeadersRow();
+        for (auto const & [asset, bytes] : rows)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(asset.second.c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(GpuMemory::Name(asset.first));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", static_cast<double>(bytes) * MB);
+        }
+        ImGui::EndTable();
+    }
+}
+
+//======================================================================================================================
+
 void SolarSystem::PrepareUnitSphereGeometry()
 {
     // Creates all the sphere geometries we need for our solar system
@@ -1,12 +1,36 @@
 #pragma once
 
 #include "AssetPath.h"
+#include "AsteroidBelt.hpp"
+#include "AsteroidRenderer.hpp"
+#include "BodyTable.hpp"
+#include "Ephemeris.hpp"
+#include "GLState.hpp"
 #include "Geometry.h"
+#include "GpuMemory.hpp"
+#include "GpuTimer.hpp"
 #include "InputManager.hpp"
-#include "ShaderProgram.h"
-#include "Texture.h"
+#include "ProgramBinaryCache.hpp"
+#include "RenderQueue.hpp"
+#include "SceneGraph.hpp"
+#include "ShaderPermutations.hpp"
+#include "TextureArray.hpp"
+#include "TextureLoader.hpp"
 #include "Time.hpp"
+#include "TripleBuffer.hpp"
 #include "TurnTableCamera.hpp"
+#include "UniformBlocks.hpp"
+#include "UniformBuffer.hpp"
+#include "VirtualTextures.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 class SolarSystem
 {
@@ -20,11 +44,70 @@ public:
 
 private:
 
-    void Update(float deltaTime);
+    struct RenderState;
+    struct Snapshot;
 
-    void Render();
+    // Camera input for the frame
+    void HandleInput(float deltaTime);
 
-    void UI();
+    // Body of the simulation thread: posted commands, then fixed steps at the simulation rate, then a
+    // snapshot for the render thread. Runs until mStopSimulation is set.
+    void SimulationLoop();
+
+    // Runs a function on the simulation thread before its next step. Everything that changes simulation
+    // state from the UI goes through here, so the simulation never sees a half-made edit.
+    void Post(std::function<void()> command);
+
+    // Returns whether there were any
+    bool RunCommands();
+
+    // Copies what the render thread needs into the next snapshot and hands it over. stepTime is when the
+    // latest step was due in real time, the render thread blends toward it from the step before.
+    void Publish(std::chrono::steady_clock::time_point stepTime, double stepSeconds);
+
+    // Advances the simulation by one step of the given length (in simulation time, 0 just re-evaluates)
+    void FixedUpdate(double simulationDelta);
+
+    void UpdateOrbits();
+
+    // Seeds the N-body system from the closed-form orbits at the current time
+    void StartNBody();
+
+    void UpdateNBody();
+
+    // Places the planets and the Moon where the ephemeris has them at the current time
+    void UpdateEphemeris();
+
+    // Julian date (TDB) the simulation clock maps to, kept inside the file's range
+    [[nodiscard]]
+    double EphemerisDate() const;
+
+    // One scene year (one turn of the model Earth) is one Julian year
+    [[nodiscard]]
+    double DaysPerTimeUnit() const;
+
+    // Real heliocentric distance (AU) to scene units, piecewise linear between the planet orbits
+    [[nodiscard]]
+    double SceneDistance(double astronomicalUnits) const;
+
+    void GenerateAsteroids(AsteroidBelt::Region region, size_t count);
+
+    // Where a body is drawn, which depends on the gravity mode
+    [[nodiscard]]
+    glm::dvec3 BodyPosition(BodyTable::BodyId id) const;
+
+    void Render(Snapshot const & snapshot);
+
+    // Nodes for everything Render draws, added once
+    void BuildSceneGraph();
+
+    // Local transforms from the blended state, world transforms only where something moved
+    void UpdateSceneGraph(RenderState const & state);
+
+    void UI(Snapshot const & snapshot);
+
+    // Resident bytes per asset, largest first, against the budget if there is one
+    void DrawGpuMemoryTable() const;
 
     void PrepareUnitSphereGeometry();
 
@@ -34,13 +117,26 @@ private:
 
     std::shared_ptr<AssetPath> mPath{};
     std::shared_ptr<Time> mTime{};
+    std::shared_ptr<GLState> mGLState{};
+    std::shared_ptr<GpuMemory> mGpuMemory{};
+    std::shared_ptr<ProgramBinaryCache> mShaderCache{};
     std::unique_ptr<Window> mWindow;
     std::shared_ptr<InputManager> mInputManager{};
 
-    std::unique_ptr<ShaderProgram> mBasicShader{};
+    std::chrono::steady_clock::time_point mStartTime{};
+    bool mFirstFrameShown = false;
 
-    // Textures for all our celestial bodies
-    std::vector<std::unique_ptr<Texture>> mTextures;
+    // Bits of the permutation key, in the order of the names given to mBasicShader
+    enum ShaderFeature : uint32_t
+    {
+        UNLIT_FEATURE = 1u << 0,        // sun and sky
+        EARTH_FEATURE = 1u << 1,        // night side from the night lights texture
+        NIGHT_LIGHTS_FEATURE = 1u << 2,
+        CLOUDS_FEATURE = 1u << 3,       // earth's cloud shell on its own, blended over earth
+        VIRTUAL_TEXTURE_FEATURE = 1u << 4 // diffuse from mVirtualTextures
+    };
+
+    std::unique_ptr<ShaderPermutations> mBasicShader{};
 
     // Enum to identify textures 
     enum TextureIndex
@@ -49,6 +145,7 @@ private:
         EARTH_DAY_TEXTURE, 
         EARTH_NIGHT_TEXTURE,
         EARTH_CLOUDS_TEXTURE,
+        EARTH_SPECULAR_TEXTURE,
         MOON_TEXTURE,
         SKY_TEXTURE,
         MERCURY_TEXTURE,
@@ -62,6 +159,26 @@ private:
         NUM_TEXTURES
     };
 
+    // Diffuse, night, clouds and specular map of a body
+    using Material = std::array<TextureIndex, 4>;
+
+    // Where a texture lives: maps of one size share an array and take a layer each
+    struct TextureLayer
+    {
+        uint32_t array = 0; // into mTextureArrays
+        int layer = 0;
+    };
+
+    // Textures for all our celestial bodies
+    std::vector<std::unique_ptr<TextureArray>> mTextureArrays{};
+    std::array<TextureLayer, NUM_TEXTURES> mTextureLayers{};
+    std::unique_ptr<TextureLoader> mTextureLoader{}; // after mTextureArrays, so it stops before they go away
+
+    // Earth's day map and the moon are paged in as the camera needs them, their layers stay placeholders
+    std::unique_ptr<VirtualTextures> mVirtualTextures{};
+    VirtualTextures::TextureId mEarthVirtualTexture = VirtualTextures::NoTexture;
+    VirtualTextures::TextureId mMoonVirtualTexture = VirtualTextures::NoTexture;
+
     // geometry that stores all sphere geometries
     std::vector<std::unique_ptr<GPU_Geometry>> mUnitSphereGeometry;
     std::vector<int> mUnitSphereIndexCount;
@@ -83,6 +200,24 @@ private:
         NUM_GEOMETRIES
     };
 
+    // Slots in the per-object uniform buffer, one per draw
+    enum ObjectIndex
+    {
+        SKY_OBJECT,
+        SUN_OBJECT,
+        EARTH_OBJECT,
+        CLOUDS_OBJECT,
+        MOON_OBJECT,
+        NUM_OBJECTS
+    };
+
+    std::unique_ptr<UniformBuffer> mFrameUniforms{};
+    std::unique_ptr<UniformBuffer> mObjectUniforms{};
+
+    // Draws of the frame, issued sorted by state and depth instead of in source order
+    RenderQueue mRenderQueue{};
+    std::unique_ptr<GpuTimer> mBodiesTimer{}; // GPU time of the queue's draws
+
     std::unique_ptr<TurnTableCamera> mTurnTableCamera{};
     glm::dvec2 mPreviousCursorPosition {};
     bool mCursorPositionIsSetOnce = false;
@@ -97,31 +232,73 @@ private:
     float mZoomSpeed = 20.0f;
     float mRotationSpeed = 0.25f;
 
-    // Animation state
-    bool mIsAnimating = true;
-    float mAnimationSpeed = 1.0f;
-    float mLastAnimationTime = 0.0f;
+    // Animation state, set by the UI and read by the simulation thread
+    std::atomic<bool> mIsAnimating{true};
+    std::atomic<float> mAnimationSpeed{1.0f};
+
+    // Fixed simulation rate, independent of the frame rate. Render blends the last two steps, so a
+    // fast display still sees smooth motion and slow frames don't make physics more expensive.
+    struct RenderState
+    {
+        glm::vec3 sunPosition{};
+        glm::vec3 earthPosition{};
+        glm::vec3 moonPosition{};
+        float sunRotationAngle = 0.0f;
+        float earthRotationAngle = 0.0f;
+        float moonRotationAngle = 0.0f;
+        float cloudRotationAngle = 0.0f;
+    };
+
+    [[nodiscard]]
+    RenderState CaptureRenderState() const;
+
+    // Blended state of the snapshot's two steps, interpolation 0 = previous, 1 = latest
+    [[nodiscard]]
+    static RenderState InterpolatedRenderState(Snapshot const & snapshot, float interpolation);
+
+    // How far the render thread is from the snapshot's previous step to its latest one
+    [[nodiscard]]
+    static float Interpolation(Snapshot const & snapshot);
+
+    // Skips the blend after a jump (reset, mode switch) so nothing visibly slides into place
+    void SnapRenderState();
+
+    std::atomic<int> mSimulationRate{60}; // steps per real second
+    RenderState mPreviousRenderState{};
+    RenderState mRenderState{};
+    uint64_t mStepCount = 0;
+    uint64_t mAsteroidStep = 0;       // step the belt last moved at
+    uint64_t mAsteroidGeneration = 0; // belt generation at that step
+    inline static constexpr int MaxStepsPerBatch = 8; // past this, time is dropped instead of piling up
 
     // Cloud state
     bool mShowClouds = false;
     float mCloudRotationAngle = 0.0f;
-    float mCloudRotationSpeed = 0.1f;
-    float mCloudOpacity = 0.3f; // How see-through clouds are
+    std::atomic<float> mCloudRotationSpeed{0.1f};
+    float mCloudOpacity = 0.8f; // Alpha of the thickest clouds
 
     // Celestial body animation parameters
     float mSunRotationAngle = 0.0f;
-    float mEarthOrbitAngle = 0.0f;
     float mEarthRotationAngle = 0.0f;
-    float mMoonOrbitAngle = 0.0f;
     float mMoonRotationAngle = 0.0f;
 
+    // Simulation clock, every orbit is evaluated in closed form from it
+    double mSimulationTime = 0.0;
+
     // Orbital parameters
     const float mEarthOrbitRadius = 5.0f;
     const float mMoonOrbitRadius = 1.5f;
+    const float mEarthOrbitSpeed = 0.2f;
+    const float mMoonOrbitSpeed = 0.5f;
     const float mEarthAxialTilt = 23.5f;
     const float mMoonAxialTilt = 6.68f;
     const float mEarthOrbitInclination = 5.0f; // Orbit tilt, exaggerated for visibility
 
+    // n^2 a^3 of Earth's orbit. Every orbit around the Sun is built with it, so the closed-form
+    // orbits and the N-body simulation (G = 1, Sun mass = this) move the planets the same way.
+    const double mSunGravitationalParameter = static_cast<double>(mEarthOrbitSpeed) * mEarthOrbitSpeed *
+        mEarthOrbitRadius * mEarthOrbitRadius * mEarthOrbitRadius;
+
     // Camera focus options
     enum class CameraFocus
     {
@@ -141,28 +318,105 @@ private:
     std::unique_ptr<GPU_Geometry> mSaturnRingGeometry;
     int mSaturnRingIndexCount;
 
-    // Add planet animation parameters
-    struct PlanetData
-    {
-        float orbitAngle = 0.0f;
-        float rotationAngle = 0.0f;
-        float orbitRadius = 0.0f;
-        float size = 0.0f;
-        float orbitSpeed = 0.0f;
-        float rotationSpeed = 0.0f;
-        float axialTilt = 0.0f;
-        float orbitInclination = 0.0f;
-        float eccentricity = 0.0f;
+    // Frame nodes only move, spin nodes hang off them with tilt and rotation, so children of a body
+    // (the Moon around Earth) follow it without inheriting its spin
+    SceneGraph mSceneGraph{};
+    SceneGraph::NodeId mSunNode = SceneGraph::InvalidId;
+    SceneGraph::NodeId mSunSpinNode = SceneGraph::InvalidId;
+    SceneGraph::NodeId mEarthNode = SceneGraph::InvalidId;
+    SceneGraph::NodeId mEarthSpinNode = SceneGraph::InvalidId;
+    SceneGraph::NodeId mCloudNode = SceneGraph::InvalidId; // turns on top of earth's spin, slightly larger
+    SceneGraph::NodeId mMoonNode = SceneGraph::InvalidId;
+    SceneGraph::NodeId mMoonSpinNode = SceneGraph::InvalidId;
+    size_t mSceneNodesUpdated = 0;
+
+    [[nodiscard]]
+    static Kepler::OrbitalElements MakeOrbit(float orbitRadius, double orbitSpeed, float orbitInclination, float eccentricity);
+
+    // Every celestial body, parents before children. Positions are heliocentric after UpdateOrbits.
+    BodyTable mBodies{};
+    BodyTable::BodyId mSunId = BodyTable::InvalidId;
+    BodyTable::BodyId mEarthId = BodyTable::InvalidId;
+    BodyTable::BodyId mMoonId = BodyTable::InvalidId;
+    std::vector<BodyTable::BodyId> mPlanetIds{}; // Mercury (0) to Neptune (7)
+
+    // Semi-major axes of the real planets in AU, Mercury (0) to Neptune (7)
+    inline static constexpr std::array<double, 8> RealSemiMajorAxes{
+        0.3871, 0.7233, 1.0000, 1.5237, 5.2034, 9.5371, 19.1913, 30.0690
     };
 
-    std::vector<PlanetData> mPlanets;
-    std::vector<std::vector<PlanetData>> mMoons; // Moons for each planet
-
-
     // Elliptic orbit parameters
     float mEarthOrbitEccentricity = 0.0f;
     float mMoonOrbitEccentricity = 0.0f; 
-    float mEarthOrbitSemiMajorAxis = 5.0f;
-    float mMoonOrbitSemiMajorAxis = 1.5f;
+
+    // Small-body swarm, drawn with a single instanced call
+    std::unique_ptr<AsteroidBelt> mAsteroidBelt{};
+    std::unique_ptr<AsteroidRenderer> mAsteroidRenderer{};
+    std::unique_ptr<MinorPlanetCatalog> mMinorPlanets{}; // null when MPCORB.DAT isn't there
+    inline static constexpr char const * MinorPlanetFile = "catalogs/MPCORB.DAT";
+    inline static constexpr std::array<size_t, 3> AsteroidCounts{10'000, 100'000, 1'000'000};
+    int mAsteroidCountIndex = 0;
+
+    // Gravity: closed-form two-body orbits, the Sun, planets and belt all pulling on each other, or the
+    // real planets from a JPL ephemeris. Moons that aren't simulated or tabulated keep their Kepler orbit
+    // around wherever their parent is.
+    enum class GravityMode
+    {
+        KEPLER,
+        N_BODY,
+        EPHEMERIS
+    };
+    GravityMode mGravityMode = GravityMode::KEPLER;
+    NBodySystem mNBody{};
+    std::vector<size_t> mNBodyIndexOfBody{}; // by BodyId, NotSimulated for bodies outside the system
+    size_t mAsteroidNBodyOffset = 0;
+    bool mAsteroidsInNBody = false;
+    double mNBodyAccumulator = 0.0;
+    float mNBodyStepMs = 0.0f;
+    inline static constexpr size_t NotSimulated = SIZE_MAX;
+    inline static constexpr double NBodyTimeStep = 0.01; // fixed, leapfrog is only symplectic with a constant step
+    inline static constexpr int NBodyMaxStepsPerFrame = 8;
+    inline static constexpr size_t NBodyMaxAsteroids = 100'000;
+
+    // JPL DE ephemeris, null when the file isn't there. Real directions and eccentricities, with every
+    // distance scaled so each planet stays on its scene orbit; the clock runs at the scene Earth's pace.
+    std::unique_ptr<Ephemeris> mEphemeris{};
+    std::vector<std::optional<glm::dvec3>> mEphemerisPositions{}; // by BodyId, planets and the Moon only
+    double mEphemerisEpoch = Ephemeris::J2000; // Julian date at simulation time 0
+    float mEphemerisQueryUs = 0.0f;
+    inline static constexpr char const * EphemerisFile = "ephemeris/JPLEPH";
+
+    // The simulation runs on its own thread, the main thread only renders and handles input. Once the
+    // thread is started everything above that the simulation touches belongs to it: the UI reads the
+    // latest snapshot and posts its edits as commands. Only the atomics are shared directly.
+    struct Snapshot
+    {
+        uint64_t asteroidStep = 0; // FixedUpdate call the instances are from
+        std::chrono::steady_clock::time_point stepTime{};
+        double stepSeconds = 0.0;
+        RenderState previous{};
+        RenderState latest{};
+        std::vector<glm::vec4> previousInstances{};
+        std::vector<glm::vec4> instances{};
+        uint64_t asteroidGeneration = 0;
+
+        // Readouts for the UI
+        GravityMode gravityMode = GravityMode::KEPLER;
+        AsteroidBelt::Region asteroidRegion = AsteroidBelt::Region::NONE;
+        float asteroidUpdateMs = 0.0f;
+        NBodySystem::Settings nBodySettings{};
+        size_t nBodyCount = 0;
+        size_t treeNodeCount = 0;
+        float nBodyStepMs = 0.0f;
+        double energyDrift = 0.0;
+        double ephemerisDate = 0.0;
+        float ephemerisQueryUs = 0.0f;
+    };
+    TripleBuffer<Snapshot> mSnapshots{};
+
+    std::thread mSimulationThread{};
+    std::atomic<bool> mStopSimulation{false};
+    std::mutex mCommandMutex{};
+    std::vector<std::function<void()>> mCommands{};
 };
 
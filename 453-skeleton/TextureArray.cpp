@@ -0,0 +1,157 @@
+#include "TextureArray.hpp"
+
+#include "GLState.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <utility>
+
+// Not in the 3.3 loader, values from the texture_filter_anisotropic spec
+static constexpr GLenum TEXTURE_MAX_ANISOTROPY = 0x84FE;
+static constexpr GLenum MAX_TEXTURE_MAX_ANISOTROPY = 0x84FF;
+
+// Past this the sharper distant surfaces aren't worth the extra samples
+static constexpr GLfloat MaxAnisotropyLimit = 16.0f;
+
+static bool ContextAtLeast(GLint const major, GLint const minor)
+{
+    GLint contextMajor = 0;
+    GLint contextMinor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+    glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+    return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+// glTexStorage3D (core in 4.2, else ARB_texture_storage), null without either
+using TexStorage3D = void (APIENTRYP)(GLenum, GLsizei, GLenum, GLsizei, GLsizei, GLsizei);
+static TexStorage3D TexStorage3DFunction()
+{
+    static TexStorage3D const function = []() -> TexStorage3D
+    {
+        if (ContextAtLeast(4, 2) == false && glfwExtensionSupported("GL_ARB_texture_storage") == GLFW_FALSE)
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<TexStorage3D>(glfwGetProcAddress("glTexStorage3D"));
+    }();
+    return function;
+}
+
+// Anisotropy the arrays get, 0 when the driver has no anisotropic filtering
+static GLfloat MaxAnisotropy()
+{
+    static GLfloat const anisotropy = []() -> GLfloat
+    {
+        if (ContextAtLeast(4, 6) == false &&
+            glfwExtensionSupported("GL_ARB_texture_filter_anisotropic") == GLFW_FALSE &&
+            glfwExtensionSupported("GL_EXT_texture_filter_anisotropic") == GLFW_FALSE)
+        {
+            return 0.0f;
+        }
+        GLfloat supported = 0.0f;
+        glGetFloatv(MAX_TEXTURE_MAX_ANISOTROPY, &supported);
+        return std::min(supported, MaxAnisotropyLimit);
+    }();
+    return anisotropy;
+}
+
+// Levels of a full chain down to 1x1
+static int MipLevelCount(int const width, int const height)
+{
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+    {
+        ++levels;
+    }
+    return levels;
+}
+
+//======================================================================================================================
+
+TextureArray::TextureArray(
+    std::string name,
+    int const width,
+    int const height,
+    std::vector<glm::u8vec4> const & placeholders
+)
+    : mMemory(GpuMemory::Category::TEXTURE, std::move(name))
+    , mWidth(width)
+    , mHeight(height)
+    , mLayerCount(static_cast<int>(placeholders.size()))
+    , mLevelCount(MipLevelCount(width, height))
+{
+    glGenTextures(1, &mTexture);
+    GLState::Instance()->BindTextureArray(0, mTexture);
+
+    // Immutable storage where the driver has it, so it never has to check the levels for completeness
+    if (TexStorage3D const storage = TexStorage3DFunction())
+    {
+        storage(GL_TEXTURE_2D_ARRAY, mLevelCount, GL_RGBA8, width, height, mLayerCount);
+    }
+    else
+    {
+        for (int level = 0; level < mLevelCount; ++level)
+        {
+            glTexImage3D(
+                GL_TEXTURE_2D_ARRAY, level, GL_RGBA8,
+                std::max(1, width >> level), std::max(1, height >> level), mLayerCount,
+                0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr
+            );
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, mLevelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, mLevelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (mLevelCount > 1 && MaxAnisotropy() > 1.0f)
+    {
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, TEXTURE_MAX_ANISOTROPY, MaxAnisotropy());
+    }
+    mMemory.Resize(GpuMemory::TextureBytes(width, height, mLayerCount));
+
+    // Clearing every level of every layer through a framebuffer costs no uploads, unlike filling them
+    // from memory would. glClearBuffer leaves the clear color alone.
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    for (int layer = 0; layer < mLayerCount; ++layer)
+    {
+        glm::vec4 const color = glm::vec4{placeholders[layer]} / 255.0f;
+        for (int level = 0; level < mLevelCount; ++level)
+        {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mTexture, level, layer);
+            glClearBufferfv(GL_COLOR, 0, &color[0]);
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+//======================================================================================================================
+
+TextureArray::~TextureArray()
+{
+    glDeleteTextures(1, &mTexture);
+    GLState::ObjectDeleted();
+}
+
+//======================================================================================================================
+
+void TextureArray::UploadLayer(int const layer, unsigned char const * const * const levels)
+{
+    GLState::Instance()->BindTextureArray(0, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int level = 0; level < mLevelCount; ++level)
+    {
+        glTexSubImage3D(
+            GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+            std::max(1, mWidth >> level), std::max(1, mHeight >> level), 1,
+            GL_RGBA, GL_UNSIGNED_BYTE, levels[level]
+        );
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+//======================================================================================================================
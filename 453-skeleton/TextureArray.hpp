@@ -0,0 +1,57 @@
+#pragma once
+
+#include "GpuMemory.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Same sized images as the layers of one GL_TEXTURE_2D_ARRAY, RGBA8 with a full mip chain in immutable
+// storage where the driver supports it, trilinear and anisotropic filtering.
+//
+// Every body whose maps are the same size samples the same array and only picks a layer, which goes
+// in its object block, so drawing one body after another binds no textures in between.
+//
+// Layers start as their placeholder color, cleared on the GPU, and get their image from UploadLayer,
+// see TextureLoader.
+class TextureArray
+{
+public:
+
+    // One layer per placeholder. name is what GpuMemory lists it as.
+    explicit TextureArray(std::string name, int width, int height, std::vector<glm::u8vec4> const & placeholders);
+
+    ~TextureArray();
+
+    TextureArray(TextureArray const &) = delete;
+    TextureArray & operator=(TextureArray const &) = delete;
+
+    // Replaces a whole layer. levels[i] is RGBA8 of max(1, size >> i), LevelCount of them.
+    void UploadLayer(int layer, unsigned char const * const * levels);
+
+    [[nodiscard]]
+    GLuint Id() const { return mTexture; }
+
+    [[nodiscard]]
+    int Width() const { return mWidth; }
+
+    [[nodiscard]]
+    int Height() const { return mHeight; }
+
+    [[nodiscard]]
+    int LayerCount() const { return mLayerCount; }
+
+    [[nodiscard]]
+    int LevelCount() const { return mLevelCount; }
+
+private:
+
+    GLuint mTexture = 0;
+    GpuMemory::Allocation mMemory{};
+    int mWidth = 0;
+    int mHeight = 0;
+    int mLayerCount = 0;
+    int mLevelCount = 0;
+};
@@ -0,0 +1,332 @@
+#include "TextureCache.hpp"
+
+#include "Log.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <system_error>
+
+// Start of every entry, level data follows at the offsets in it
+struct EntryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+    uint32_t padding;
+    uint64_t sourceSize;
+    int64_t sourceTime; // last write time, in the file clock's ticks
+    uint64_t sourceHash;
+    uint64_t offsets[TextureCache::MaxLevels];
+};
+static constexpr char EntryMagic[4] = {'S', 'T', 'X', 'C'};
+static constexpr uint32_t EntryVersion = 1;
+
+// Levels start on their own cache line
+static constexpr uint64_t LevelAlignment = 64;
+
+static constexpr size_t BytesPerPixel = 4;
+
+//======================================================================================================================
+
+static uint64_t Fnv1a(unsigned char const * data, size_t const size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+//======================================================================================================================
+
+static std::optional<std::vector<unsigned char>> ReadFile(std::string const & path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (file.is_open() == false)
+    {
+        return std::nullopt;
+    }
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+//======================================================================================================================
+
+// Name to write an entry under before it's renamed into place. Unique per call and per process, so two
+// workers (or two instances of the app) building the same entry never write into each other's file.
+static std::filesystem::path TemporaryPath(std::filesystem::path const & path)
+{
+    static uint32_t const processTag = std::random_device{}();
+    static std::atomic<uint64_t> counter{0};
+    char suffix[48]{};
+    std::snprintf(
+        suffix, sizeof(suffix), ".%08x-%llu.tmp",
+        static_cast<unsigned>(processTag), static_cast<unsigned long long>(counter.fetch_add(1))
+    );
+    std::filesystem::path temporary = path;
+    temporary += suffix;
+    return temporary;
+}
+
+//======================================================================================================================
+
+static uint64_t AlignUp(uint64_t const value)
+{
+    return (value + LevelAlignment - 1) / LevelAlignment * LevelAlignment;
+}
+
+//======================================================================================================================
+
+// Each texel of the smaller level is the average of the 2x2 block above it. An odd last row or column
+// is counted twice instead of reading past the edge.
+static void Downsample(
+    unsigned char const * source,
+    int const sourceWidth,
+    int const sourceHeight,
+    unsigned char * destination
+)
+{
+    int const width = std::max(1, sourceWidth / 2);
+    int const height = std::max(1, sourceHeight / 2);
+    for (int y = 0; y < height; ++y)
+    {
+        unsigned char const * const row0 = source + static_cast<size_t>(std::min(2 * y, sourceHeight - 1)) * sourceWidth * BytesPerPixel;
+        unsigned char const * const row1 = source + static_cast<size_t>(std::min(2 * y + 1, sourceHeight - 1)) * sourceWidth * BytesPerPixel;
+        unsigned char * const out = destination + static_cast<size_t>(y) * width * BytesPerPixel;
+        for (int x = 0; x < width; ++x)
+        {
+            size_t const x0 = static_cast<size_t>(std::min(2 * x, sourceWidth - 1)) * BytesPerPixel;
+            size_t const x1 = static_cast<size_t>(std::min(2 * x + 1, sourceWidth - 1)) * BytesPerPixel;
+            for (size_t c = 0; c < BytesPerPixel; ++c)
+            {
+                unsigned const sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                out[x * BytesPerPixel + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+//======================================================================================================================
+
+std::array<unsigned char const *, TextureCache::MaxLevels> TextureCache::Image::Levels() const
+{
+    unsigned char const * const base = mMapping.has_value()
+        ? reinterpret_cast<unsigned char const *>(mMapping->Data())
+        : mPixels.data();
+    std::array<unsigned char const *, MaxLevels> levels{};
+    for (uint32_t i = 0; i < mLevelCount; ++i)
+    {
+        levels[i] = base + mOffsets[i];
+    }
+    return levels;
+}
+
+//======================================================================================================================
+
+TextureCache::TextureCache(std::filesystem::path directory)
+    : mDirectory(std::move(directory))
+{
+    if (std::getenv("NO_TEXTURE_CACHE") != nullptr)
+    {
+        Log::info("Texture cache: disabled by NO_TEXTURE_CACHE");
+        return;
+    }
+
+    std::error_code error{};
+    std::filesystem::create_directories(mDirectory, error);
+    if (error)
+    {
+        Log::warn("Texture cache: can't create {0} ({1})", mDirectory.string(), error.message());
+        return;
+    }
+    mEnabled = true;
+}
+
+//======================================================================================================================
+
+std::optional<TextureCache::Image> TextureCache::Open(std::string const & sourcePath) const
+{
+    if (mEnabled == false)
+    {
+        return std::nullopt;
+    }
+
+    std::error_code error{};
+    std::filesystem::path const path = EntryPath(sourcePath);
+    uint64_t const sourceSize = std::filesystem::file_size(sourcePath, error);
+    auto const sourceTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error || std::filesystem::exists(path, error) == false)
+    {
+        return std::nullopt;
+    }
+
+    Image image{};
+    try
+    {
+        image.mMapping.emplace(path.string());
+    }
+    catch (std::runtime_error const &)
+    {
+        return std::nullopt;
+    }
+
+    MappedFile const & mapping = *image.mMapping;
+    if (mapping.Size() < sizeof(EntryHeader))
+    {
+        return std::nullopt;
+    }
+    EntryHeader header{};
+    std::memcpy(&header, mapping.Data(), sizeof(header));
+    bool valid = std::equal(std::begin(EntryMagic), std::end(EntryMagic), header.magic) &&
+        header.version == EntryVersion &&
+        header.sourceSize == sourceSize &&
+        header.sourceTime == static_cast<int64_t>(sourceTime.time_since_epoch().count()) &&
+        header.levelCount >= 1 && header.levelCount <= MaxLevels;
+
+    // Every level has to lie inside the file, a truncated entry is as good as none
+    for (uint32_t i = 0; valid && i < header.levelCount; ++i)
+    {
+        uint64_t const width = std::max(1u, header.width >> i);
+        uint64_t const height = std::max(1u, header.height >> i);
+        valid = header.offsets[i] + width * height * BytesPerPixel <= mapping.Size();
+    }
+    if (valid == false)
+    {
+        return std::nullopt;
+    }
+
+    // Size and time can survive an edit (a copy that keeps the time, a checkout), so the bytes decide.
+    // Hashing the source is far cheaper than decoding it again.
+    std::optional<std::vector<unsigned char>> const source = ReadFile(sourcePath);
+    if (source.has_value() == false || Fnv1a(source->data(), source->size()) != header.sourceHash)
+    {
+        return std::nullopt;
+    }
+
+    image.mWidth = static_cast<int>(header.width);
+    image.mHeight = static_cast<int>(header.height);
+    image.mLevelCount = header.levelCount;
+    std::copy(std::begin(header.offsets), std::end(header.offsets), image.mOffsets.begin());
+    return image;
+}
+
+//======================================================================================================================
+
+std::optional<TextureCache::Image> TextureCache::Build(std::string const & sourcePath) const
+{
+    // Read once, hashed and decoded from the same bytes
+    std::optional<std::vector<unsigned char>> const read = ReadFile(sourcePath);
+    if (read.has_value() == false)
+    {
+        return std::nullopt;
+    }
+    std::vector<unsigned char> const & source = *read;
+
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    std::unique_ptr<unsigned char, void (*)(void *)> const pixels(
+        stbi_load_from_memory(source.data(), static_cast<int>(source.size()), &width, &height, &components, BytesPerPixel),
+        stbi_image_free
+    );
+    if (pixels == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    EntryHeader header{};
+    std::copy(std::begin(EntryMagic), std::end(EntryMagic), header.magic);
+    header.version = EntryVersion;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.levelCount = 1;
+    for (int size = std::max(width, height); size > 1 && header.levelCount < MaxLevels; size /= 2)
+    {
+        ++header.levelCount;
+    }
+    header.sourceSize = source.size();
+    header.sourceHash = Fnv1a(source.data(), source.size());
+    std::error_code error{};
+    header.sourceTime = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count());
+
+    // Laid out exactly like the file, so the same bytes get written and uploaded
+    uint64_t offset = AlignUp(sizeof(EntryHeader));
+    for (uint32_t i = 0; i < header.levelCount; ++i)
+    {
+        header.offsets[i] = offset;
+        offset = AlignUp(offset + uint64_t{std::max(1u, header.width >> i)} * std::max(1u, header.height >> i) * BytesPerPixel);
+    }
+
+    Image image{};
+    image.mWidth = width;
+    image.mHeight = height;
+    image.mLevelCount = header.levelCount;
+    std::copy(std::begin(header.offsets), std::end(header.offsets), image.mOffsets.begin());
+    image.mPixels.resize(offset);
+    std::memcpy(image.mPixels.data(), &header, sizeof(header));
+    std::memcpy(image.mPixels.data() + header.offsets[0], pixels.get(), static_cast<size_t>(width) * height * BytesPerPixel);
+    for (uint32_t i = 1; i < header.levelCount; ++i)
+    {
+        Downsample(
+            image.mPixels.data() + header.offsets[i - 1],
+            std::max(1, width >> (i - 1)),
+            std::max(1, height >> (i - 1)),
+            image.mPixels.data() + header.offsets[i]
+        );
+    }
+
+    if (mEnabled == false || error)
+    {
+        return image;
+    }
+
+    // Written aside and renamed, so a crash never leaves half an entry where Open would find it
+    std::filesystem::path const path = EntryPath(sourcePath);
+    std::filesystem::path const temporary = TemporaryPath(path);
+    bool written = false;
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<char const *>(image.mPixels.data()), static_cast<std::streamsize>(image.mPixels.size()));
+        written = file.good();
+    }
+    if (written == false)
+    {
+        Log::warn("Texture cache: can't write {0}", temporary.string());
+        std::filesystem::remove(temporary, error);
+        return image;
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+    }
+    return image;
+}
+
+//======================================================================================================================
+
+std::filesystem::path TextureCache::EntryPath(std::string const & sourcePath) const
+{
+    // Name for whoever looks into the directory, hash of the whole path so equal names don't collide
+    std::string const name = std::filesystem::path(sourcePath).filename().string();
+    char suffix[32]{};
+    std::snprintf(
+        suffix, sizeof(suffix), ".%016llx.tex",
+        static_cast<unsigned long long>(Fnv1a(reinterpret_cast<unsigned char const *>(sourcePath.data()), sourcePath.size()))
+    );
+    return mDirectory / (name + suffix);
+}
+
+//======================================================================================================================
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "MappedFile.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Decoded images kept on disk in the layout TextureArray::UploadLayer takes, so a warm start maps the
+// file and uploads from the mapping instead of decoding the JPEG or PNG again.
+//
+// An entry holds every mip level as RGBA8, box filtered on the CPU, behind a small header with the
+// dimensions, level offsets, and the size, modification time and FNV-1a hash of the source. It is
+// used as long as all three still match the source, anything else rebuilds it. Only the worker
+// threads of TextureLoader touch this, it has no GL in it.
+class TextureCache
+{
+public:
+
+    static constexpr uint32_t MaxLevels = 16; // 32k, far past anything in assets/
+
+    // One image, ready to upload. Backed by either the mapped entry or its own memory.
+    class Image
+    {
+    public:
+
+        [[nodiscard]]
+        int Width() const { return mWidth; }
+
+        [[nodiscard]]
+        int Height() const { return mHeight; }
+
+        [[nodiscard]]
+        int LevelCount() const { return static_cast<int>(mLevelCount); }
+
+        // Pointers to every level, valid while the image is
+        [[nodiscard]]
+        std::array<unsigned char const *, MaxLevels> Levels() const;
+
+        [[nodiscard]]
+        bool Mapped() const { return mMapping.has_value(); }
+
+    private:
+
+        friend class TextureCache;
+
+        int mWidth = 0;
+        int mHeight = 0;
+        uint32_t mLevelCount = 0;
+        std::array<uint64_t, MaxLevels> mOffsets{};
+        std::optional<MappedFile> mMapping{};
+        std::vector<unsigned char> mPixels{};
+    };
+
+    // Entries go to directory, which is created if needed. Without it, or with NO_TEXTURE_CACHE set
+    // in the environment, every image is decoded and nothing is written.
+    explicit TextureCache(std::filesystem::path directory);
+
+    // The source's entry if there is an up to date one
+    [[nodiscard]]
+    std::optional<Image> Open(std::string const & sourcePath) const;
+
+    // Decodes the source and writes its entry. Empty if the source can't be read or decoded.
+    [[nodiscard]]
+    std::optional<Image> Build(std::string const & sourcePath) const;
+
+private:
+
+    [[nodiscard]]
+    std::filesystem::path EntryPath(std::string const & sourcePath) const;
+
+    std::filesystem::path mDirectory{};
+    bool mEnabled = false;
+};
@@ -0,0 +1,210 @@
+#include "TextureLoader.hpp"
+
+#include "Log.h"
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+
+// Bilinear, RGBA8, texel centers lined up
+static std::vector<unsigned char> Resample(
+    unsigned char const * const source,
+    int const sourceWidth,
+    int const sourceHeight,
+    int const width,
+    int const height
+)
+{
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+    float const scaleX = static_cast<float>(sourceWidth) / static_cast<float>(width);
+    float const scaleY = static_cast<float>(sourceHeight) / static_cast<float>(height);
+    for (int y = 0; y < height; ++y)
+    {
+        float const sourceY = std::clamp((static_cast<float>(y) + 0.5f) * scaleY - 0.5f, 0.0f, static_cast<float>(sourceHeight - 1));
+        int const y0 = static_cast<int>(sourceY);
+        int const y1 = std::min(y0 + 1, sourceHeight - 1);
+        float const fy = sourceY - static_cast<float>(y0);
+        for (int x = 0; x < width; ++x)
+        {
+            float const sourceX = std::clamp((static_cast<float>(x) + 0.5f) * scaleX - 0.5f, 0.0f, static_cast<float>(sourceWidth - 1));
+            int const x0 = static_cast<int>(sourceX);
+            int const x1 = std::min(x0 + 1, sourceWidth - 1);
+            float const fx = sourceX - static_cast<float>(x0);
+            unsigned char const * const a = source + (static_cast<size_t>(y0) * sourceWidth + x0) * 4;
+            unsigned char const * const b = source + (static_cast<size_t>(y0) * sourceWidth + x1) * 4;
+            unsigned char const * const c = source + (static_cast<size_t>(y1) * sourceWidth + x0) * 4;
+            unsigned char const * const d = source + (static_cast<size_t>(y1) * sourceWidth + x1) * 4;
+            unsigned char * const out = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+            for (int channel = 0; channel < 4; ++channel)
+            {
+                float const top = a[channel] + (b[channel] - a[channel]) * fx;
+                float const bottom = c[channel] + (d[channel] - c[channel]) * fx;
+                out[channel] = static_cast<unsigned char>(top + (bottom - top) * fy + 0.5f);
+            }
+        }
+    }
+    return pixels;
+}
+
+//======================================================================================================================
+
+TextureLoader::TextureLoader(std::filesystem::path cacheDirectory, size_t threadCount)
+    : mCache(std::move(cacheDirectory))
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max<size_t>(1, std::thread::hardware_concurrency() / 2);
+    }
+    mWorkers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        mWorkers.emplace_back([this]() -> void { WorkerLoop(); });
+    }
+}
+
+//======================================================================================================================
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> const lock(mMutex);
+        mStopping = true;
+        mQueued.clear();
+    }
+    mWake.notify_all();
+    for (auto & worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+//======================================================================================================================
+
+void TextureLoader::Load(TextureArray & array, int const layer, std::string path)
+{
+    Job job{};
+    job.array = &array;
+    job.layer = layer;
+    job.path = std::move(path);
+    {
+        std::lock_guard<std::mutex> const lock(mMutex);
+        mQueued.emplace_back(std::move(job));
+    }
+    ++mPendingCount;
+    mWake.notify_one();
+}
+
+//======================================================================================================================
+
+size_t TextureLoader::Update(size_t const maxUploads)
+{
+    size_t uploads = 0;
+    while (uploads < maxUploads)
+    {
+        Job job{};
+        {
+            std::lock_guard<std::mutex> const lock(mMutex);
+            if (mDecoded.empty())
+            {
+                break;
+            }
+            job = std::move(mDecoded.front());
+            mDecoded.pop_front();
+        }
+        --mPendingCount;
+
+        if (job.image.has_value() == false)
+        {
+            Log::error("Texture: can't read {0}, keeping its placeholder", job.path);
+            continue;
+        }
+
+        TextureCache::Image const & image = *job.image;
+        auto const start = std::chrono::steady_clock::now();
+        job.array->UploadLayer(job.layer, job.layerLevels.data());
+        double const uploadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        Log::info(
+            "Texture: {0} ({1}x{2}) {3} in {4:.1f} ms, uploaded in {5:.1f} ms",
+            job.path, image.Width(), image.Height(), image.Mapped() ? "mapped from the cache" : "decoded",
+            job.loadMilliseconds, uploadMilliseconds
+        );
+        ++uploads;
+    }
+    return uploads;
+}
+
+//======================================================================================================================
+
+void TextureLoader::WorkerLoop()
+{
+    // Per thread in stb, the GL thread's own loads keep their setting. Cache entries store the flipped rows.
+    stbi_set_flip_vertically_on_load_thread(true);
+
+    while (true)
+    {
+        Job job{};
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this]() -> bool { return mStopping || mQueued.empty() == false; });
+            if (mStopping)
+            {
+                return;
+            }
+            job = std::move(mQueued.front());
+            mQueued.pop_front();
+        }
+
+        auto const start = std::chrono::steady_clock::now();
+        job.image = mCache.Open(job.path);
+        if (job.image.has_value() == false)
+        {
+            job.image = mCache.Build(job.path);
+        }
+        if (job.image.has_value())
+        {
+            FitToArray(job);
+        }
+        job.loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> const lock(mMutex);
+        mDecoded.emplace_back(std::move(job));
+    }
+}
+
+//======================================================================================================================
+
+void TextureLoader::FitToArray(Job & job)
+{
+    TextureCache::Image const & image = *job.image;
+    std::array<unsigned char const *, TextureCache::MaxLevels> const levels = image.Levels();
+    int const levelCount = job.array->LevelCount();
+    job.layerLevels.resize(levelCount);
+    job.resampled.reserve(levelCount);
+    for (int level = 0; level < levelCount; ++level)
+    {
+        int const width = std::max(1, job.array->Width() >> level);
+        int const height = std::max(1, job.array->Height() >> level);
+
+        // The finest source level no smaller than the target, or the whole image if it is smaller
+        int source = 0;
+        while (source + 1 < image.LevelCount() &&
+            std::max(1, image.Width() >> (source + 1)) >= width &&
+            std::max(1, image.Height() >> (source + 1)) >= height)
+        {
+            ++source;
+        }
+        int const sourceWidth = std::max(1, image.Width() >> source);
+        int const sourceHeight = std::max(1, image.Height() >> source);
+        if (sourceWidth == width && sourceHeight == height)
+        {
+            job.layerLevels[level] = levels[source];
+            continue;
+        }
+
+        job.resampled.emplace_back(Resample(levels[source], sourceWidth, sourceHeight, width, height));
+        job.layerLevels[level] = job.resampled.back().data();
+    }
+}
+
+//======================================================================================================================
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "TextureArray.hpp"
+#include "TextureCache.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decodes image files on worker threads and uploads them on the GL thread.
+//
+// Workers go through a TextureCache, so after the first run an image is a mapped file whose levels
+// are uploaded as they are, and only new or changed files are decoded.
+//
+// Load returns right away, the layer keeps its placeholder until Update finds the decoded image and
+// uploads it. Update only does a little each call, so a frame that picks up an 8k image isn't any
+// longer than one layer upload. A file that can't be read is logged and its layer keeps the
+// placeholder.
+//
+// Images that aren't the array's size are fitted on the worker: a cached mip level of the right size
+// is used as it is, anything else is resampled bilinearly from the closest larger level.
+//
+// Arrays handed to Load have to outlive the loader.
+class TextureLoader
+{
+public:
+
+    // 0 = about half of the machine, the simulation thread and its pool want the rest
+    explicit TextureLoader(std::filesystem::path cacheDirectory, size_t threadCount = 0);
+
+    // Waits for the decodes in progress, drops everything else
+    ~TextureLoader();
+
+    TextureLoader(TextureLoader const &) = delete;
+    TextureLoader & operator=(TextureLoader const &) = delete;
+
+    // GL thread, fills a layer of the array. Files are decoded in the order they were asked for.
+    void Load(TextureArray & array, int layer, std::string path);
+
+    // GL thread, uploads at most maxUploads decoded images. Returns how many it uploaded.
+    size_t Update(size_t maxUploads = 1);
+
+    // Asked for and not uploaded yet
+    [[nodiscard]]
+    size_t PendingCount() const { return mPendingCount; }
+
+private:
+
+    struct Job
+    {
+        TextureArray * array = nullptr;
+        int layer = 0;
+        std::string path{};
+        std::optional<TextureCache::Image> image{};
+        std::vector<unsigned char const *> layerLevels{};         // into image or resampled
+        std::vector<std::vector<unsigned char>> resampled{};
+        double loadMilliseconds = 0.0;
+    };
+
+    void WorkerLoop();
+
+    // Worker side of an array job, points layerLevels at a level of the array's size for each of its levels
+    static void FitToArray(Job & job);
+
+    TextureCache const mCache;
+    std::vector<std::thread> mWorkers{};
+
+    std::mutex mMutex{};
+    std::condition_variable mWake{};
+    std::deque<Job> mQueued{};  // waiting for a worker
+    std::deque<Job> mDecoded{}; // waiting for Update
+    bool mStopping = false;
+
+    size_t mPendingCount = 0; // GL thread only
+};
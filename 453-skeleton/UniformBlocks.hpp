@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+
+// std140 layouts of the uniform blocks every shader in assets/shaders shares, and the binding points
+// they live at. ShaderProgram connects blocks to these points by name when it links, so shaders only
+// declare the blocks they use and never look anything up.
+//
+// Only vec4 and mat4 members, std140 pads everything else to them anyway and this way the C++ layout
+// matches without any explicit padding.
+namespace UniformBlocks
+{
+    enum Binding : GLuint
+    {
+        FRAME_BINDING = 0,
+        OBJECT_BINDING = 1,
+        BINDING_COUNT
+    };
+
+    // Block names as declared in GLSL, by binding point
+    inline constexpr std::array<char const *, BINDING_COUNT> Names{"Frame", "Object"};
+
+    // Camera, light and time, uploaded once per frame
+    struct Frame
+    {
+        glm::mat4 view{1.0f};
+        glm::mat4 projection{1.0f};
+        glm::vec4 viewPosition{0.0f};  // w unused
+        glm::vec4 lightPosition{0.0f}; // w unused
+        glm::vec4 lightAmbient{0.0f};
+        glm::vec4 lightDiffuse{0.0f};
+        glm::vec4 lightSpecular{0.0f};
+        glm::vec4 time{0.0f};          // x = seconds since start, y = interpolation between simulation steps
+    };
+
+    // Per draw, every object of a frame sits in its own slot of one buffer
+    struct Object
+    {
+        glm::mat4 model{1.0f};
+        glm::mat4 normalMatrix{1.0f};  // inverse transpose of the model's upper 3x3
+        glm::vec4 specular{0.0f};      // rgb = specular color, a = shininess
+        glm::vec4 clouds{0.0f};        // x = cloud opacity, cloud shell only
+        glm::vec4 virtualTexture{0.0f}; // see VirtualTextures::ObjectParameters, all zero without one
+        glm::vec4 layers{0.0f};        // texture array layers of the diffuse, night, cloud and specular maps
+    };
+
+    static_assert(sizeof(Frame) % 16 == 0 && sizeof(Object) % 16 == 0, "std140 blocks are made of whole vec4s");
+}
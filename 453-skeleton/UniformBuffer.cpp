@@ -0,0 +1,56 @@
+#include "UniformBuffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+//======================================================================================================================
+
+UniformBuffer::UniformBuffer(GLuint const binding, size_t const blockSize, size_t const blockCount)
+    : mBinding(binding)
+    , mBlockSize(blockSize)
+    , mBlockCount(blockCount)
+{
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    size_t const step = static_cast<size_t>(std::max(alignment, 1));
+    mStride = (blockSize + step - 1) / step * step;
+    mStaging.resize(mStride * blockCount);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(mStaging.size()), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    Bind(0);
+
+    mMemory = GpuMemory::Allocation(GpuMemory::Category::UNIFORM_BUFFER, "Binding " + std::to_string(binding));
+    mMemory.Resize(mStaging.size());
+}
+
+//======================================================================================================================
+
+void UniformBuffer::Upload(size_t const count)
+{
+    if (count > mBlockCount)
+    {
+        throw std::out_of_range("UniformBuffer: more blocks than the buffer was made for");
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(mStaging.size()), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(count * mStride), mStaging.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+//======================================================================================================================
+
+void UniformBuffer::Bind(size_t const index) const
+{
+    glBindBufferRange(
+        GL_UNIFORM_BUFFER,
+        mBinding,
+        mBuffer,
+        static_cast<GLintptr>(index * mStride),
+        static_cast<GLsizeiptr>(mBlockSize)
+    );
+}
+
+//======================================================================================================================
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "GLHandles.h"
+#include "GpuMemory.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// A uniform buffer holding a number of equally sized blocks for one binding point.
+//
+// Blocks are staged on the CPU and sent in a single call per frame. Each one starts at a multiple of
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, so a draw can bind just its own block with glBindBufferRange
+// instead of uploading anything.
+class UniformBuffer
+{
+public:
+
+    explicit UniformBuffer(GLuint binding, size_t blockSize, size_t blockCount = 1);
+
+    template <typename T>
+    void Set(size_t const index, T const & block)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "uniform blocks are copied as bytes");
+        std::memcpy(mStaging.data() + index * mStride, &block, sizeof(T));
+    }
+
+    // Sends the first count blocks, orphaning the old storage so draws still reading it don't stall
+    void Upload(size_t count);
+
+    // Points the binding at one block
+    void Bind(size_t index = 0) const;
+
+    [[nodiscard]]
+    size_t BlockCount() const { return mBlockCount; }
+
+private:
+
+    VertexBufferHandle mBuffer{}; // any buffer object can back a uniform block
+    GpuMemory::Allocation mMemory{};
+    GLuint mBinding = 0;
+    size_t mBlockSize = 0;
+    size_t mBlockCount = 0;
+    size_t mStride = 0;
+    std::vector<std::byte> mStaging{};
+};
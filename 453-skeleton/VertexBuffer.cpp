@@ -5,7 +5,7 @@
 //======================================================================================================================
 
 VertexBuffer::VertexBuffer(GLuint index, GLint size, GLenum dataType)
-	: bufferID{}
+	: bufferID{}, memory(GpuMemory::Category::VERTEX_BUFFER, "Geometry")
 {
 	bind();
 	glVertexAttribPointer(index, size, dataType, GL_FALSE, 0, (void*)0);
@@ -15,12 +15,13 @@ VertexBuffer::VertexBuffer(GLuint index, GLint size, GLenum dataType)
 void VertexBuffer::uploadData(GLsizeiptr size, const void* data, GLenum usage) {
 	bind();
 	glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+	memory.Resize(static_cast<size_t>(size));
 }
 
 //======================================================================================================================
 
 IndexBuffer::IndexBuffer(GLuint index, GLint size, GLenum dataType)
-    : bufferID{}
+    : bufferID{}, memory(GpuMemory::Category::INDEX_BUFFER, "Geometry")
 {
     bind();
     glVertexAttribPointer(index, size, dataType, GL_FALSE, 0, (void*)0);
@@ -30,9 +31,10 @@ IndexBuffer::IndexBuffer(GLuint index, GLint size, GLenum dataType)
 void IndexBuffer::uploadData(GLsizeiptr size, const void* data, GLenum usage) {
     bind();
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, usage);
+    memory.Resize(static_cast<size_t>(size));
 }
 
-IndexBuffer::IndexBuffer() : bufferID{} // Just initialize the handle, no vertex attrib setup needed
+IndexBuffer::IndexBuffer() : bufferID{}, memory(GpuMemory::Category::INDEX_BUFFER, "Geometry") // Just initialize the handle, no vertex attrib setup needed
 {
     // Note: Unlike VertexBuffer, we don't call glVertexAttribPointer here
     // because index buffers are handled differently in OpenGL
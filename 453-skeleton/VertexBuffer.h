@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GLHandles.h"
+#include "GpuMemory.hpp"
 
 #include <glad/glad.h>
 
@@ -23,6 +24,7 @@ public:
 
 private:
 	VertexBufferHandle bufferID;
+	GpuMemory::Allocation memory;
 };
 
 class IndexBuffer {
@@ -43,4 +45,5 @@ public:
 
 private:
     VertexBufferHandle bufferID;
+    GpuMemory::Allocation memory;
 };
@@ -0,0 +1,648 @@
+#include "VirtualTextures.hpp"
+
+#include "GLState.hpp"
+#include "Log.h"
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr int AtlasSize = VirtualTextures::AtlasPages * VirtualTextures::PhysicalPageSize;
+
+static constexpr uint64_t CoordinateBits = 20;
+static constexpr uint64_t LevelBits = 8;
+
+//======================================================================================================================
+
+// One indirection texel, RGBA8 in memory order
+static uint32_t IndirectionEntry(size_t const slot, int const level)
+{
+    uint32_t const x = static_cast<uint32_t>(slot % VirtualTextures::AtlasPages);
+    uint32_t const y = static_cast<uint32_t>(slot / VirtualTextures::AtlasPages);
+    return x | (y << 8) | (static_cast<uint32_t>(level) << 16) | (0xFFu << 24);
+}
+
+//======================================================================================================================
+
+static bool IsPowerOfTwo(int const value)
+{
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+//======================================================================================================================
+
+uint64_t VirtualTextures::Page::Key() const
+{
+    return (static_cast<uint64_t>(id) << (LevelBits + 2 * CoordinateBits)) |
+        (static_cast<uint64_t>(level) << (2 * CoordinateBits)) |
+        (static_cast<uint64_t>(y) << CoordinateBits) |
+        static_cast<uint64_t>(x);
+}
+
+//======================================================================================================================
+
+VirtualTextures::Page VirtualTextures::Page::FromKey(uint64_t const key)
+{
+    uint64_t const coordinateMask = (uint64_t{1} << CoordinateBits) - 1;
+    Page page{};
+    page.id = static_cast<TextureId>(key >> (LevelBits + 2 * CoordinateBits));
+    page.level = static_cast<int>((key >> (2 * CoordinateBits)) & ((uint64_t{1} << LevelBits) - 1));
+    page.y = static_cast<int>((key >> CoordinateBits) & coordinateMask);
+    page.x = static_cast<int>(key & coordinateMask);
+    return page;
+}
+
+//======================================================================================================================
+
+VirtualTextures::VirtualTextures(
+    std::filesystem::path cacheDirectory,
+    std::string const & vertexPath,
+    std::string const & feedbackPath
+)
+    : mCache(std::move(cacheDirectory))
+{
+    mFeedbackShader = std::make_unique<ShaderProgram>(deferredLink, vertexPath, feedbackPath);
+
+    // Linear without mips, the border does the filtering between pages
+    glGenTextures(1, &mAtlas);
+    GLState::Instance()->BindTexture(0, mAtlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, AtlasSize, AtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    mAtlasMemory = GpuMemory::Allocation(GpuMemory::Category::TEXTURE, "Virtual texture atlas");
+    mAtlasMemory.Resize(static_cast<size_t>(AtlasSize) * AtlasSize * 4);
+    mSlots.resize(SlotCount());
+
+    glGenBuffers(static_cast<GLsizei>(mReadbackBuffers.size()), mReadbackBuffers.data());
+    mFeedbackMemory = GpuMemory::Allocation(GpuMemory::Category::RENDER_TARGET, "Virtual texture feedback");
+
+    mWorker = std::thread([this]() -> void { WorkerLoop(); });
+}
+
+//======================================================================================================================
+
+VirtualTextures::~VirtualTextures()
+{
+    {
+        std::lock_guard<std::mutex> const lock(mMutex);
+        mStopping = true;
+        mQueued.clear();
+    }
+    mWake.notify_all();
+    mWorker.join();
+
+    for (GLsync const fence : mReadbackFences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    glDeleteBuffers(static_cast<GLsizei>(mReadbackBuffers.size()), mReadbackBuffers.data());
+    glDeleteRenderbuffers(1, &mFeedbackColor);
+    glDeleteRenderbuffers(1, &mFeedbackDepth);
+    glDeleteFramebuffers(1, &mFramebuffer);
+
+    for (auto const & source : mSources)
+    {
+        glDeleteTextures(1, &source->indirection);
+    }
+    glDeleteTextures(1, &mAtlas);
+    GLState::ObjectDeleted();
+}
+
+//======================================================================================================================
+
+VirtualTextures::TextureId VirtualTextures::Add(std::string sourcePath)
+{
+    auto const id = static_cast<TextureId>(mSources.size());
+    mSources.emplace_back(std::make_unique<Source>());
+    mSources.back()->path = sourcePath;
+
+    Job job{};
+    job.id = id;
+    job.path = std::move(sourcePath);
+    {
+        std::lock_guard<std::mutex> const lock(mMutex);
+        mQueued.emplace_front(std::move(job)); // before any page
+    }
+    mWake.notify_one();
+    return id;
+}
+
+//======================================================================================================================
+
+glm::vec4 VirtualTextures::ObjectParameters(TextureId const id) const
+{
+    Source const & source = *mSources[id];
+    if (source.indirection == 0)
+    {
+        return glm::vec4{0.0f};
+    }
+    return glm::vec4{
+        static_cast<float>(source.width),
+        static_cast<float>(source.height),
+        static_cast<float>(source.levelCount),
+        static_cast<float>(id + 1)
+    };
+}
+
+//======================================================================================================================
+
+GLuint VirtualTextures::Indirection(TextureId const id) const
+{
+    return mSources[id]->indirection;
+}
+
+//======================================================================================================================
+
+bool VirtualTextures::BeginFeedback(int const windowWidth, int const windowHeight)
+{
+    // Sources only get an indirection texture once the worker opened them
+    bool const anyOpen = std::any_of(
+        mSources.begin(), mSources.end(),
+        [](std::unique_ptr<Source> const & source) -> bool { return source->indirection != 0; }
+    );
+    if (anyOpen == false || mFeedbackShader->poll() == false)
+    {
+        return false;
+    }
+
+    mWindowSize = glm::ivec2{windowWidth, windowHeight};
+    glm::ivec2 const size = glm::max(mWindowSize / FeedbackDivisor, glm::ivec2{1});
+    if (size != mFeedbackSize)
+    {
+        mFeedbackSize = size;
+        if (mFramebuffer == 0)
+        {
+            glGenFramebuffers(1, &mFramebuffer);
+            glGenRenderbuffers(1, &mFeedbackColor);
+            glGenRenderbuffers(1, &mFeedbackDepth);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, mFeedbackColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+        glBindRenderbuffer(GL_RENDERBUFFER, mFeedbackDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mFeedbackColor);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mFeedbackDepth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            Log::error("VirtualTextures: feedback framebuffer is incomplete");
+        }
+
+        // Color, depth and both readback buffers, 4 bytes a pixel each
+        mFeedbackMemory.Resize(static_cast<size_t>(size.x) * size.y * 4 * (2 + ReadbackCount));
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glViewport(0, 0, size.x, size.y);
+    // Alpha 0 marks pixels without a virtual texture. Clears through glClearBuffer leave the clear color alone.
+    GLfloat const clearColor[4]{0.0f, 0.0f, 0.0f, 0.0f};
+    GLfloat const clearDepth = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, clearColor);
+    glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+    GLState::Instance()->SetEnabled(GL_DEPTH_TEST, true);
+
+    // Derivatives are FeedbackDivisor times larger down here, the bias brings the level back to what
+    // the full size pass picks
+    static constexpr UniformHandle<float> LodBias("lodBias");
+    mFeedbackShader->use();
+    mFeedbackShader->set(LodBias, -std::log2(static_cast<float>(FeedbackDivisor)));
+    return true;
+}
+
+//======================================================================================================================
+
+void VirtualTextures::EndFeedback()
+{
+    // A buffer whose feedback was never read in time is simply overwritten
+    size_t const index = mNextReadback;
+    if (mReadbackFences[index] != nullptr)
+    {
+        glDeleteSync(mReadbackFences[index]);
+        mReadbackFences[index] = nullptr;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, mReadbackBuffers[index]);
+    if (mReadbackSizes[index] != mFeedbackSize)
+    {
+        mReadbackSizes[index] = mFeedbackSize;
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(mFeedbackSize.x) * mFeedbackSize.y * 4, nullptr, GL_STREAM_READ);
+    }
+    glReadPixels(0, 0, mFeedbackSize.x, mFeedbackSize.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    mReadbackFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mNextReadback = (mNextReadback + 1) % ReadbackCount;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, mWindowSize.x, mWindowSize.y);
+}
+
+//======================================================================================================================
+
+void VirtualTextures::Update()
+{
+    // The oldest readback, if the GPU is done with it. Never waits.
+    size_t const index = mNextReadback;
+    if (mReadbackFences[index] != nullptr)
+    {
+        GLenum const status = glClientWaitSync(mReadbackFences[index], 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+        {
+            glDeleteSync(mReadbackFences[index]);
+            mReadbackFences[index] = nullptr;
+
+            size_t const count = static_cast<size_t>(mReadbackSizes[index].x) * mReadbackSizes[index].y;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, mReadbackBuffers[index]);
+            void const * texels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(count * 4), GL_MAP_READ_BIT);
+            if (texels != nullptr)
+            {
+                ReadFeedback(static_cast<unsigned char const *>(texels), count);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+    }
+
+    // Opened sources are always taken, pages only a few at a time
+    size_t uploads = 0;
+    while (true)
+    {
+        Result result{};
+        {
+            std::lock_guard<std::mutex> const lock(mMutex);
+            auto const next = std::find_if(mDone.begin(), mDone.end(), [uploads](Result const & done) -> bool
+            {
+                return done.page.has_value() == false || uploads < MaxUploadsPerFrame;
+            });
+            if (next == mDone.end())
+            {
+                break;
+            }
+            result = std::move(*next);
+            mDone.erase(next);
+        }
+
+        if (result.page.has_value())
+        {
+            Upload(result);
+            ++uploads;
+        }
+        else
+        {
+            Opened(result);
+        }
+    }
+
+    ++mFrame;
+}
+
+//======================================================================================================================
+
+void VirtualTextures::WorkerLoop()
+{
+    // Per thread in stb, building a cache entry decodes on this one
+    stbi_set_flip_vertically_on_load_thread(true);
+
+    while (true)
+    {
+        Job job{};
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this]() -> bool { return mStopping || mQueued.empty() == false; });
+            if (mStopping)
+            {
+                return;
+            }
+            job = std::move(mQueued.front());
+            mQueued.pop_front();
+        }
+
+        Result result{};
+        result.id = job.id;
+        result.page = job.page;
+        if (job.page.has_value())
+        {
+            result.pixels = ReadPage(*job.image, Page::FromKey(*job.page));
+        }
+        else
+        {
+            result.image = mCache.Open(job.path);
+            if (result.image.has_value() == false)
+            {
+                result.image = mCache.Build(job.path);
+            }
+        }
+
+        std::lock_guard<std::mutex> const lock(mMutex);
+        mDone.emplace_back(std::move(result));
+    }
+}
+
+//======================================================================================================================
+
+std::vector<unsigned char> VirtualTextures::ReadPage(TextureCache::Image const & image, Page const & page) const
+{
+    int const width = std::max(1, image.Width() >> page.level);
+    int const height = std::max(1, image.Height() >> page.level);
+    auto const * const level = reinterpret_cast<uint32_t const *>(image.Levels()[page.level]);
+
+    // Maps wrap around in longitude and stop at the poles
+    std::vector<unsigned char> pixels(static_cast<size_t>(PhysicalPageSize) * PhysicalPageSize * 4);
+    auto * const texels = reinterpret_cast<uint32_t *>(pixels.data());
+    for (int y = 0; y < PhysicalPageSize; ++y)
+    {
+        int const sourceY = std::clamp(page.y * PageSize - PageBorder + y, 0, height - 1);
+        uint32_t const * const row = level + static_cast<size_t>(sourceY) * width;
+        for (int x = 0; x < PhysicalPageSize; ++x)
+        {
+            int const sourceX = ((page.x * PageSize - PageBorder + x) % width + width) % width;
+            texels[static_cast<size_t>(y) * PhysicalPageSize + x] = row[sourceX];
+        }
+    }
+    return pixels;
+}
+
+//======================================================================================================================
+
+void VirtualTextures::Opened(Result & result)
+{
+    Source & source = *mSources[result.id];
+    if (result.image.has_value() == false)
+    {
+        Log::error("VirtualTextures: can't read {0}", source.path);
+        return;
+    }
+    int const width = result.image->Width();
+    int const height = result.image->Height();
+    if (IsPowerOfTwo(width) == false || IsPowerOfTwo(height) == false || std::max(width, height) < PageSize)
+    {
+        Log::error("VirtualTextures: {0} is {1}x{2}, needs powers of two of at least {3}", source.path, width, height, PageSize);
+        return;
+    }
+
+    source.image = std::move(result.image);
+    source.width = width;
+    source.height = height;
+    source.levelCount = 1;
+    while ((std::max(width, height) >> (source.levelCount - 1)) > PageSize)
+    {
+        ++source.levelCount;
+    }
+
+    // Nearest everything, a texel is a page. Starts out all empty.
+    glGenTextures(1, &source.indirection);
+    GLState::Instance()->BindTexture(0, source.indirection);
+    source.table.resize(source.levelCount);
+    for (int level = 0; level < source.levelCount; ++level)
+    {
+        int const pagesX = PagesAt(width, level);
+        int const pagesY = PagesAt(height, level);
+        source.table[level].assign(static_cast<size_t>(pagesX) * pagesY, 0u);
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, pagesX, pagesY, 0, GL_RGBA, GL_UNSIGNED_BYTE, source.table[level].data());
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, source.levelCount - 1);
+    source.memory = GpuMemory::Allocation(GpuMemory::Category::TEXTURE, source.path + " (page table)");
+    source.memory.Resize(GpuMemory::TextureBytes(PagesAt(width, 0), PagesAt(height, 0)));
+
+    Log::info(
+        "VirtualTextures: {0} is {1}x{2}, {3} levels of pages, {4}",
+        source.path, width, height, source.levelCount, source.image->Mapped() ? "mapped" : "decoded"
+    );
+
+    // The page everything falls back to
+    Page top{};
+    top.id = result.id;
+    top.level = source.levelCount - 1;
+    Request(top);
+}
+
+//======================================================================================================================
+
+void VirtualTextures::Request(Page const & page)
+{
+    uint64_t const key = page.Key();
+    if (mResident.count(key) != 0 || mRequested.insert(key).second == false)
+    {
+        return;
+    }
+
+    Job job{};
+    job.id = page.id;
+    job.page = key;
+    job.image = &*mSources[page.id]->image;
+    {
+        std::lock_guard<std::mutex> const lock(mMutex);
+        mQueued.emplace_back(std::move(job));
+    }
+    mWake.notify_one();
+}
+
+//======================================================================================================================
+
+void VirtualTextures::Upload(Result & result)
+{
+    uint64_t const key = *result.page;
+    mRequested.erase(key);
+
+    // Everything is wanted right now, it gets asked for again once something isn't
+    std::optional<size_t> const slot = TakeSlot();
+    if (slot.has_value() == false)
+    {
+        return;
+    }
+
+    Page const page = Page::FromKey(key);
+    GLState::Instance()->BindTexture(0, mAtlas);
+    glTexSubImage2D(
+        GL_TEXTURE_2D, 0,
+        static_cast<GLint>(*slot % AtlasPages) * PhysicalPageSize,
+        static_cast<GLint>(*slot / AtlasPages) * PhysicalPageSize,
+        PhysicalPageSize, PhysicalPageSize,
+        GL_RGBA, GL_UNSIGNED_BYTE, result.pixels.data()
+    );
+
+    mSlots[*slot].page = key;
+    mSlots[*slot].lastWanted = mFrame;
+    mSlots[*slot].pinned = page.level == mSources[page.id]->levelCount - 1;
+    mResident.emplace(key, *slot);
+    UpdateIndirection(page);
+}
+
+//======================================================================================================================
+
+std::optional<size_t> VirtualTextures::TakeSlot()
+{
+    std::optional<size_t> oldest{};
+    for (size_t i = 0; i < mSlots.size(); ++i)
+    {
+        Slot const & slot = mSlots[i];
+        if (slot.page.has_value() == false)
+        {
+            return i;
+        }
+        if (slot.pinned == false && slot.lastWanted < mFrame &&
+            (oldest.has_value() == false || slot.lastWanted < mSlots[*oldest].lastWanted))
+        {
+            oldest = i;
+        }
+    }
+    if (oldest.has_value() == false)
+    {
+        return std::nullopt;
+    }
+
+    Slot & slot = mSlots[*oldest];
+    Page const evicted = Page::FromKey(*slot.page);
+    mResident.erase(*slot.page);
+    slot.page.reset();
+    UpdateIndirection(evicted);
+    ++mEvictions;
+    return oldest;
+}
+
+//======================================================================================================================
+
+void VirtualTextures::UpdateIndirection(Page const & page)
+{
+    Source & source = *mSources[page.id];
+    GLState::Instance()->BindTexture(0, source.indirection);
+
+    // Coarse to fine, a page without its own slot copies its parent's entry, which is already final
+    for (int level = page.level; level >= 0; --level)
+    {
+        int const pagesX = PagesAt(source.width, level);
+        int const pagesY = PagesAt(source.height, level);
+        int const scale = 1 << (page.level - level);
+        int const x0 = std::min(page.x * scale, pagesX - 1);
+        int const y0 = std::min(page.y * scale, pagesY - 1);
+        int const x1 = std::min((page.x + 1) * scale, pagesX);
+        int const y1 = std::min((page.y + 1) * scale, pagesY);
+
+        std::vector<uint32_t> & table = source.table[level];
+        for (int y = y0; y < y1; ++y)
+        {
+            for (int x = x0; x < x1; ++x)
+            {
+                Page texel{};
+                texel.id = page.id;
+                texel.level = level;
+                texel.x = x;
+                texel.y = y;
+                auto const resident = mResident.find(texel.Key());
+                uint32_t entry = 0;
+                if (resident != mResident.end())
+                {
+                    entry = IndirectionEntry(resident->second, level);
+                }
+                else if (level + 1 < source.levelCount)
+                {
+                    entry = source.table[level + 1][static_cast<size_t>(y / 2) * PagesAt(source.width, level + 1) + x / 2];
+                }
+                table[static_cast<size_t>(y) * pagesX + x] = entry;
+            }
+        }
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, pagesX);
+        glTexSubImage2D(
+            GL_TEXTURE_2D, level, x0, y0, x1 - x0, y1 - y0,
+            GL_RGBA, GL_UNSIGNED_BYTE, table.data() + static_cast<size_t>(y0) * pagesX + x0
+        );
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+}
+
+//======================================================================================================================
+
+void VirtualTextures::ReadFeedback(unsigned char const * const texels, size_t const count)
+{
+    // Every page seen, with its ancestors, so the fallbacks stay around too
+    std::unordered_set<uint64_t> wanted{};
+    uint64_t previous = ~uint64_t{0};
+    for (size_t i = 0; i < count; ++i)
+    {
+        unsigned char const * const texel = texels + i * 4;
+        if (texel[3] == 0)
+        {
+            continue;
+        }
+
+        Page page{};
+        page.id = static_cast<TextureId>(texel[3] - 1);
+        page.level = texel[2];
+        page.x = texel[0];
+        page.y = texel[1];
+        if (page.id >= mSources.size() || mSources[page.id]->indirection == 0)
+        {
+            continue;
+        }
+        Source const & source = *mSources[page.id];
+        if (page.level >= source.levelCount || page.x >= PagesAt(source.width, page.level) || page.y >= PagesAt(source.height, page.level))
+        {
+            continue;
+        }
+
+        // Neighbouring pixels mostly want the same page
+        if (page.Key() == previous)
+        {
+            continue;
+        }
+        previous = page.Key();
+
+        for (; page.level < source.levelCount; ++page.level, page.x /= 2, page.y /= 2)
+        {
+            if (wanted.insert(page.Key()).second == false)
+            {
+                break; // the rest of the chain is in already
+            }
+        }
+    }
+
+    std::vector<Page> missing{};
+    for (uint64_t const key : wanted)
+    {
+        auto const resident = mResident.find(key);
+        if (resident != mResident.end())
+        {
+            mSlots[resident->second].lastWanted = mFrame;
+        }
+        else if (mRequested.count(key) == 0)
+        {
+            missing.emplace_back(Page::FromKey(key));
+        }
+    }
+
+    // Coarse first, a blurry planet beats a patchy one
+    std::sort(missing.begin(), missing.end(), [](Page const & a, Page const & b) -> bool
+    {
+        return a.level > b.level;
+    });
+    if (missing.size() > MaxRequestsPerFrame)
+    {
+        missing.resize(MaxRequestsPerFrame);
+    }
+    for (Page const & page : missing)
+    {
+        Request(page);
+    }
+}
+
+//======================================================================================================================
+
+int VirtualTextures::PagesAt(int const size, int const level)
+{
+    return std::max(1, (size >> level) / PageSize);
+}
+
+//======================================================================================================================
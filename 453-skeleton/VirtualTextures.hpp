@@ -0,0 +1,220 @@
+#pragma once
+
+#include "GpuMemory.hpp"
+#include "ShaderProgram.h"
+#include "TextureCache.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Sparse virtual texturing, for planet maps too big to keep whole in video memory.
+//
+// Every level of a source is cut into PageSize pages. Only the pages the camera actually needs live on
+// the GPU, in one shared atlas of AtlasPages x AtlasPages slots, and each source has a small
+// indirection texture with a texel per page of every level, telling the shader which slot holds it.
+// A page that isn't resident points at its nearest resident ancestor, and the single page of the
+// coarsest level is loaded first and never evicted, so there is always something to sample.
+//
+// What is needed comes from a feedback pass: the virtual textured objects are drawn again into a
+// small framebuffer that records the page each pixel would sample. It is read back through pixel
+// buffers a frame later, so nothing waits on the GPU. Missing pages are read on a worker thread out of
+// the TextureCache entry of the source, which after the first run is a mapped file, and uploaded a
+// few per frame. When the atlas is full the least recently wanted page makes room.
+//
+// Pages carry a border of PageBorder texels from their neighbours, enough for bilinear filtering
+// inside a page. Filtering across levels is left out, each pixel reads the one level it asked for.
+//
+// Sources have to be powers of two and at least a page wide. GL thread only, apart from the worker.
+class VirtualTextures
+{
+public:
+
+    using TextureId = uint32_t;
+
+    static constexpr TextureId NoTexture = ~TextureId{0};
+
+    // These four are repeated in test.frag and vt_feedback.frag
+    static constexpr int PageSize = 128;
+    static constexpr int PageBorder = 1;
+    static constexpr int PhysicalPageSize = PageSize + 2 * PageBorder;
+    static constexpr int AtlasPages = 16; // slots per side
+
+    static constexpr int FeedbackDivisor = 8;       // feedback resolution relative to the window
+    static constexpr size_t MaxUploadsPerFrame = 8; // pages, about 530 KB
+    static constexpr size_t MaxRequestsPerFrame = 32;
+
+    // Starts the worker, pages are read from the TextureCache kept in cacheDirectory
+    explicit VirtualTextures(std::filesystem::path cacheDirectory, std::string const & vertexPath, std::string const & feedbackPath);
+
+    // Waits for the page being read, drops the rest
+    ~VirtualTextures();
+
+    VirtualTextures(VirtualTextures const &) = delete;
+    VirtualTextures & operator=(VirtualTextures const &) = delete;
+
+    // The source is opened in the background, until then it has no pages at all
+    TextureId Add(std::string sourcePath);
+
+    // For UniformBlocks::Object::virtualTexture, all zero until the source is open
+    [[nodiscard]]
+    glm::vec4 ObjectParameters(TextureId id) const;
+
+    // 0 until the source is open
+    [[nodiscard]]
+    GLuint Indirection(TextureId id) const;
+
+    [[nodiscard]]
+    GLuint Atlas() const { return mAtlas; }
+
+    // Binds the feedback framebuffer and program. The caller then draws every object that uses a
+    // virtual texture, with its object block bound. Leaves GL_DEPTH_TEST on. False, with nothing bound,
+    // while the program is still compiling or no source is open yet, there is nothing to ask for then.
+    [[nodiscard]]
+    bool BeginFeedback(int windowWidth, int windowHeight);
+
+    // Starts reading the feedback back and restores the default framebuffer, only after BeginFeedback said yes
+    void EndFeedback();
+
+    // Once per frame: goes through the oldest finished feedback, asks for missing pages and uploads the
+    // ones the worker has read
+    void Update();
+
+    [[nodiscard]]
+    size_t ResidentPages() const { return mResident.size(); }
+
+    [[nodiscard]]
+    static constexpr size_t SlotCount() { return AtlasPages * AtlasPages; }
+
+    // Asked for and not uploaded yet
+    [[nodiscard]]
+    size_t PendingPages() const { return mRequested.size(); }
+
+    // Pages that had to make room since the start
+    [[nodiscard]]
+    size_t Evictions() const { return mEvictions; }
+
+private:
+
+    // Page (x, y) of a level of a source, packed into one key
+    struct Page
+    {
+        TextureId id = 0;
+        int level = 0;
+        int x = 0;
+        int y = 0;
+
+        [[nodiscard]]
+        uint64_t Key() const;
+
+        [[nodiscard]]
+        static Page FromKey(uint64_t key);
+    };
+
+    struct Source
+    {
+        std::string path{};
+        std::optional<TextureCache::Image> image{}; // set once the worker opened it, never changes after
+        int width = 0;
+        int height = 0;
+        int levelCount = 0;                          // virtual levels, the last one is a single page
+        GLuint indirection = 0;
+        GpuMemory::Allocation memory{};              // of the indirection texture
+        std::vector<std::vector<uint32_t>> table{};  // indirection texels by level, RGBA8
+    };
+
+    struct Slot
+    {
+        std::optional<uint64_t> page{};
+        uint64_t lastWanted = 0; // frame
+        bool pinned = false;
+    };
+
+    // For the worker, a source to open or a page to copy out of one
+    struct Job
+    {
+        TextureId id = 0;
+        std::optional<uint64_t> page{};
+        std::string path{};
+        TextureCache::Image const * image = nullptr;
+    };
+
+    struct Result
+    {
+        TextureId id = 0;
+        std::optional<uint64_t> page{};
+        std::optional<TextureCache::Image> image{};
+        std::vector<unsigned char> pixels{}; // PhysicalPageSize^2 RGBA8 texels
+    };
+
+    void WorkerLoop();
+
+    [[nodiscard]]
+    std::vector<unsigned char> ReadPage(TextureCache::Image const & image, Page const & page) const;
+
+    void Opened(Result & result);
+
+    void Request(Page const & page);
+
+    void Upload(Result & result);
+
+    // Slot for a new page, evicting if needed. Empty when every slot is wanted this frame.
+    [[nodiscard]]
+    std::optional<size_t> TakeSlot();
+
+    // Rewrites the indirection of the page and everything below it, after it came or went
+    void UpdateIndirection(Page const & page);
+
+    void ReadFeedback(unsigned char const * texels, size_t count);
+
+    [[nodiscard]]
+    static int PagesAt(int size, int level);
+
+    TextureCache const mCache;
+    std::unique_ptr<ShaderProgram> mFeedbackShader{};
+
+    std::vector<std::unique_ptr<Source>> mSources{}; // stable addresses, the worker reads the images
+    GLuint mAtlas = 0;
+    GpuMemory::Allocation mAtlasMemory{};
+    std::vector<Slot> mSlots{};
+    std::unordered_map<uint64_t, size_t> mResident{}; // page to slot
+    std::unordered_set<uint64_t> mRequested{};        // queued, being read or waiting for upload
+    uint64_t mFrame = 0;
+    size_t mEvictions = 0;
+
+    // Feedback target at window size / FeedbackDivisor, recreated when that changes
+    GLuint mFramebuffer = 0;
+    GLuint mFeedbackColor = 0;
+    GLuint mFeedbackDepth = 0;
+    glm::ivec2 mFeedbackSize{0};
+    glm::ivec2 mWindowSize{0};
+    GpuMemory::Allocation mFeedbackMemory{}; // target and readback buffers
+
+    // Readback, each frame fills one buffer while an older one is read
+    static constexpr size_t ReadbackCount = 2;
+    std::array<GLuint, ReadbackCount> mReadbackBuffers{};
+    std::array<GLsync, ReadbackCount> mReadbackFences{};
+    std::array<glm::ivec2, ReadbackCount> mReadbackSizes{};
+    size_t mNextReadback = 0;
+
+    std::thread mWorker{};
+    std::mutex mMutex{};
+    std::condition_variable mWake{};
+    std::deque<Job> mQueued{}; // coarsest first
+    std::deque<Result> mDone{};
+    bool mStopping = false;
+};
@@ -0,0 +1,28 @@
+#version 330 core
+
+in vec3 FragPos;
+in vec3 Normal;
+in float Albedo;
+
+out vec4 fragColor;
+
+// Layout matches UniformBlocks.hpp
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+    vec4 lightPosition; // sun position, moves in N-body mode
+    vec4 lightAmbient;
+    vec4 lightDiffuse;
+    vec4 lightSpecular;
+    vec4 time;
+} frame;
+
+void main()
+{
+    vec3 lightDir = normalize(frame.lightPosition.xyz - FragPos);
+    float diff = max(dot(normalize(Normal), lightDir), 0.0);
+
+    vec3 rock = vec3(0.55, 0.5, 0.45) * Albedo; // dusty grey-brown
+    fragColor = vec4(rock * (0.25 + 0.75 * diff), 1.0);
+}
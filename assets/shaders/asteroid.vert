@@ -0,0 +1,32 @@
+#version 330 core
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 2) in vec3 inNormal;
+layout (location = 4) in vec4 inInstance;         // xyz = world position, w = scale
+layout (location = 5) in vec4 inPreviousInstance; // same, one simulation step earlier
+
+out vec3 FragPos;   // World space position
+out vec3 Normal;    // World space normal
+out float Albedo;   // per-rock brightness so the belt doesn't look flat
+
+// Layout matches UniformBlocks.hpp
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;
+    vec4 lightPosition;
+    vec4 lightAmbient;
+    vec4 lightDiffuse;
+    vec4 lightSpecular;
+    vec4 time;          // y = interpolation, 0 = previous step, 1 = latest
+} frame;
+
+void main()
+{
+    // only translation and uniform scale per instance, so the normal needs no extra transform
+    vec4 instance = mix(inPreviousInstance, inInstance, frame.time.y);
+    FragPos = instance.xyz + inPosition * instance.w;
+    Normal = inNormal;
+    Albedo = 0.5 + 0.5 * fract(sin(float(gl_InstanceID) * 12.9898) * 43758.5453);
+    gl_Position = frame.projection * frame.view * vec4(FragPos, 1.0);
+}
@@ -1,90 +1,144 @@
 #version 330 core
 
+// Features are #defined by ShaderPermutations, see SolarSystem::ShaderFeature
+//   UNLIT        just the diffuse texture, for the sun and the sky
+//   EARTH        night side comes from the night lights texture
+//   NIGHT_LIGHTS blend towards the night color on the dark side
+//   CLOUDS       earth's cloud shell on its own, alpha from the cloud map
+//   VIRTUAL_TEXTURE  diffuse comes from the page atlas, see VirtualTextures.hpp
+
+// Layers of texture arrays, which layer is in object.layers
 struct Material {
-    sampler2D diffuse;   // daytime texture
-    sampler2D specular;  // specular map
-    sampler2D night;     // night lights texture
-    sampler2D clouds;    // cloud texture
-    float shininess;     // how shiny the surface is
+    sampler2DArray diffuse;   // daytime texture
+    sampler2DArray specular;  // specular map
+    sampler2DArray night;     // night lights texture
+    sampler2DArray clouds;    // cloud texture
 }; 
 
-// Light properties
-struct Light {
-    vec3 position; // sun position
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+// Layouts match UniformBlocks.hpp
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition;  // camera position
+    vec4 lightPosition; // sun position
+    vec4 lightAmbient;
+    vec4 lightDiffuse;
+    vec4 lightSpecular;
+    vec4 time;
+} frame;
+
+layout (std140) uniform Object {
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 specular;      // rgb = specular color, a = how shiny the surface is
+    vec4 clouds;        // x = cloud opacity
+    vec4 virtualTexture; // xy = size, z = levels, w = id + 1, 0 until the source is open
+    vec4 layers;        // texture array layers: x = diffuse, y = night, z = clouds, w = specular
+} object;
 
 // Inputs from vertex shader
 in vec3 FragPos;      // world space position
 in vec3 Normal;       // world space normal
 in vec2 TexCoord;     // regular texture coords
-in vec2 CloudTexCoord; // cloud texture coords
 
 out vec4 fragColor; // output color
 
-uniform Material material;  // surface material
-uniform Light light;       // light source
-uniform vec3 viewPos;      // camera position
-uniform bool isSun;        // is this the sun?
-uniform bool isEarth;      // is this the earth?
-uniform bool showNightTexture; // do we need night light
-uniform bool showClouds;   // show clouds
+uniform Material material;  // surface textures
 
-void main()
+#ifdef VIRTUAL_TEXTURE
+// Match VirtualTextures.hpp
+const float PAGE_SIZE = 128.0;
+const float PAGE_BORDER = 1.0;
+const float PHYSICAL_PAGE_SIZE = 130.0;
+const float ATLAS_PAGES = 16.0;
+
+uniform sampler2D virtualIndirection; // texel per page: atlas slot xy, level the slot holds, a = 0 if none
+uniform sampler2D virtualAtlas;
+
+// The page for this pixel's level, or the nearest coarser one that is resident
+vec3 sampleVirtual(vec2 uv, vec3 fallback)
 {
-    if (isSun) { // for the sun, just render its texture
-        fragColor = texture(material.diffuse, TexCoord);
-        return; // Skip all other calculations
+    vec2 size = object.virtualTexture.xy;
+    vec2 dx = dFdx(uv * size);
+    vec2 dy = dFdy(uv * size);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    if (object.virtualTexture.w == 0.0) {
+        return fallback;
     }
 
-    vec3 dayColor = texture(material.diffuse, TexCoord).rgb;   // Get base colors
-    vec3 nightColor = isEarth ? texture(material.night, TexCoord).rgb * 0.8 : dayColor * 0.9; // Night color is dimmer: 80% for earth, 90% for moon
+    float level = clamp(floor(lod), 0.0, object.virtualTexture.z - 1.0);
+    vec4 entry = floor(textureLod(virtualIndirection, uv, level) * 255.0 + 0.5);
+    if (entry.a == 0.0) {
+        return fallback;
+    }
+
+    vec2 levelSize = size / exp2(entry.z);
+    vec2 texel = min(uv * levelSize, levelSize - 0.001);
+    vec2 inPage = texel - floor(texel / PAGE_SIZE) * PAGE_SIZE;
+    vec2 atlasTexel = entry.xy * PHYSICAL_PAGE_SIZE + PAGE_BORDER + inPage;
+    return textureLod(virtualAtlas, atlasTexel / (ATLAS_PAGES * PHYSICAL_PAGE_SIZE), 0.0).rgb;
+}
+#endif
+
+void main()
+{
+#if defined(CLOUDS)
+    // The map is white clouds on black, brightness is how much cloud there is
+    vec4 cloudColor = texture(material.clouds, vec3(TexCoord, object.layers.z));
+    float coverage = max(max(cloudColor.r, cloudColor.g), cloudColor.b) * cloudColor.a;
+
+    // Lit like the surface below, so the night side stays dark
+    vec3 lightDir = normalize(frame.lightPosition.xyz - FragPos);
+    float diff = max(dot(normalize(Normal), lightDir), 0.0);
+    vec3 light = frame.lightAmbient.rgb * 0.6 + frame.lightDiffuse.rgb * diff;
+
+    fragColor = vec4(cloudColor.rgb * light, coverage * object.clouds.x);
+#elif defined(UNLIT)
+    // for the sun, just render its texture
+    fragColor = texture(material.diffuse, vec3(TexCoord, object.layers.x));
+#else
+    vec3 viewPos = frame.viewPosition.xyz;
+
+    vec3 dayColor = texture(material.diffuse, vec3(TexCoord, object.layers.x)).rgb;   // Get base colors
+#ifdef VIRTUAL_TEXTURE
+    dayColor = sampleVirtual(TexCoord, dayColor); // the diffuse texture is its placeholder
+#endif
     
     // Lighting calculations
     vec3 norm = normalize(Normal); // normalized normal vector
-    vec3 lightDir = normalize(light.position - FragPos); // light direction
+    vec3 lightDir = normalize(frame.lightPosition.xyz - FragPos); // light direction
     float diff = max(dot(norm, lightDir), 0.0); // diffuse lighting
     
     // dark side visibility
-    vec3 ambient = light.ambient * dayColor * 0.6;
-    vec3 diffuse = light.diffuse * diff * dayColor;
+    vec3 ambient = frame.lightAmbient.rgb * dayColor * 0.6;
+    vec3 diffuse = frame.lightDiffuse.rgb * diff * dayColor;
     
     // Specular highlights
     vec3 specular = vec3(0.0);
     if (diff > 0.0) { // only calculate if light is hitting surface
         vec3 viewDir = normalize(viewPos - FragPos); // view direction
         vec3 reflectDir = reflect(-lightDir, norm);  // reflection direction
-        float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-        specular = light.specular * spec * texture(material.specular, TexCoord).rgb;
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), object.specular.a);
+        specular = frame.lightSpecular.rgb * spec * object.specular.rgb * texture(material.specular, vec3(TexCoord, object.layers.w)).rgb;
     }
 
     // Combine lighting components
     vec3 result = ambient + diffuse + specular;
 
-    // Enhanced night effect when enabled
-    if (showNightTexture) {
-        float nightBlend = smoothstep(0.0, 0.6, -dot(norm, lightDir)); // Wider transition
-        vec3 nightEffect = isEarth ? nightColor : dayColor * 0.5; // Moon gets darker when night enabled
-        result = mix(result, nightEffect, nightBlend * 0.8); // More subtle blending
-    }
-    else {
-        float minLight = 0.1; // a little visibility when night textures are off
-        result = max(result, dayColor * minLight);
-    }
-
-    // Cloud blending, only earth
-    if (isEarth && showClouds) {
-    // Sample cloud texture with wrapping
-    vec2 wrappedCoords = fract(CloudTexCoord); // Ensure coordinates wrap around
-    vec4 cloudColor = texture(material.clouds, wrappedCoords);
-    
-    // Better blending with edge feathering
-    float edge = smoothstep(0.0, 0.1, min(CloudTexCoord.x, 1.0 - CloudTexCoord.x)) * 
-                smoothstep(0.0, 0.1, min(CloudTexCoord.y, 1.0 - CloudTexCoord.y));
-    result = mix(result, cloudColor.rgb, cloudColor.a * 0.3 * edge);
-    }
+#ifdef NIGHT_LIGHTS
+    // Enhanced night effect
+    float nightBlend = smoothstep(0.0, 0.6, -dot(norm, lightDir)); // Wider transition
+#ifdef EARTH
+    vec3 nightEffect = texture(material.night, vec3(TexCoord, object.layers.y)).rgb * 0.8; // Night color is dimmer
+#else
+    vec3 nightEffect = dayColor * 0.5; // Moon gets darker when night enabled
+#endif
+    result = mix(result, nightEffect, nightBlend * 0.8); // More subtle blending
+#else
+    float minLight = 0.1; // a little visibility when night textures are off
+    result = max(result, dayColor * minLight);
+#endif
 
     fragColor = vec4(result, 1.0); // Final output color
-}
\ No newline at end of file
+#endif
+}
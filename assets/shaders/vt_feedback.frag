@@ -0,0 +1,38 @@
+#version 330 core
+
+// Feedback pass of VirtualTextures: the page every pixel wants, drawn small and read back by the CPU.
+// Uses test.vert without any features.
+
+// Match VirtualTextures.hpp
+const float PAGE_SIZE = 128.0;
+
+// Layout matches UniformBlocks.hpp
+layout (std140) uniform Object {
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 specular;
+    vec4 clouds;
+    vec4 virtualTexture; // xy = size, z = levels, w = id + 1, 0 until the source is open
+    vec4 layers;
+} object;
+
+in vec2 TexCoord;
+
+out vec4 fragColor; // page x, page y, level, id + 1, read back as bytes
+
+uniform float lodBias; // this pass is smaller than the window, see VirtualTextures::FeedbackDivisor
+
+void main()
+{
+    vec2 size = object.virtualTexture.xy;
+    vec2 dx = dFdx(TexCoord * size);
+    vec2 dy = dFdy(TexCoord * size);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + lodBias;
+
+    float level = clamp(floor(lod), 0.0, max(object.virtualTexture.z - 1.0, 0.0));
+    vec2 pages = max(floor(size / exp2(level) / PAGE_SIZE), vec2(1.0));
+    vec2 page = min(floor(TexCoord * pages), pages - 1.0);
+
+    // Alpha 0 without a virtual texture, the clear color
+    fragColor = vec4(page, level, object.virtualTexture.w) / 255.0;
+}
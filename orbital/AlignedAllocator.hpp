@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Allocator for std::vector that hands out cache-line aligned storage, so SoA columns can be streamed
+// with aligned SIMD loads and two columns never share a line.
+template <typename T, std::size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(AlignedAllocator<U, Alignment> const &) noexcept {}
+
+    [[nodiscard]]
+    T * allocate(std::size_t const count)
+    {
+        return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T * pointer, std::size_t) noexcept
+    {
+        ::operator delete(pointer, std::align_val_t{Alignment});
+    }
+
+    template <typename U>
+    bool operator==(AlignedAllocator<U, Alignment> const &) const noexcept { return true; }
+
+    template <typename U>
+    bool operator!=(AlignedAllocator<U, Alignment> const &) const noexcept { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
@@ -0,0 +1,377 @@
+#include "BarnesHut.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//======================================================================================================================
+
+// Distance inside which a cell has to be opened. Adding the offset of the center of mass from the cell
+// center guarantees a body is never approximated by a cell it sits in (Barnes 1994).
+static double OpenRadiusSquared(double const cellSize, double const openingAngle, double const comOffset)
+{
+    if (openingAngle <= 0.0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    double const radius = cellSize / openingAngle + comOffset;
+    return radius * radius;
+}
+
+//======================================================================================================================
+
+void BarnesHut::Build(Bodies const & bodies, double const openingAngle, ThreadPool & pool)
+{
+    mOpeningAngle = openingAngle;
+    mNodes.clear();
+
+    size_t const count = bodies.count;
+    mOrder.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        mOrder[i] = static_cast<uint32_t>(i);
+    }
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Bounding cube, reduced per chunk in parallel
+    constexpr size_t BoundsChunk = 16384;
+    size_t const chunkCount = (count + BoundsChunk - 1) / BoundsChunk;
+    std::vector<double> chunkBounds(chunkCount * 6);
+    pool.ParallelFor(chunkCount, [&](size_t const chunk) -> void
+    {
+        size_t const begin = chunk * BoundsChunk;
+        size_t const end = std::min(count, begin + BoundsChunk);
+        double bounds[6] = {bodies.x[begin], bodies.y[begin], bodies.z[begin], bodies.x[begin], bodies.y[begin], bodies.z[begin]};
+        for (size_t i = begin + 1; i < end; ++i)
+        {
+            bounds[0] = std::min(bounds[0], bodies.x[i]);
+            bounds[1] = std::min(bounds[1], bodies.y[i]);
+            bounds[2] = std::min(bounds[2], bodies.z[i]);
+            bounds[3] = std::max(bounds[3], bodies.x[i]);
+            bounds[4] = std::max(bounds[4], bodies.y[i]);
+            bounds[5] = std::max(bounds[5], bodies.z[i]);
+        }
+        std::copy(bounds, bounds + 6, chunkBounds.begin() + static_cast<std::ptrdiff_t>(chunk * 6));
+    });
+    double bounds[6] = {chunkBounds[0], chunkBounds[1], chunkBounds[2], chunkBounds[3], chunkBounds[4], chunkBounds[5]};
+    for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            bounds[axis] = std::min(bounds[axis], chunkBounds[chunk * 6 + axis]);
+            bounds[axis + 3] = std::max(bounds[axis + 3], chunkBounds[chunk * 6 + axis + 3]);
+        }
+    }
+
+    // Slightly padded so bodies on the upper faces still land inside
+    double const extent = std::max({bounds[3] - bounds[0], bounds[4] - bounds[1], bounds[5] - bounds[2]});
+    Cell const root{
+        0.5 * (bounds[0] + bounds[3]),
+        0.5 * (bounds[1] + bounds[4]),
+        0.5 * (bounds[2] + bounds[5]),
+        0.5 * extent * (1.0 + 1e-9) + std::numeric_limits<double>::min()
+    };
+
+    if (count <= LeafCapacity)
+    {
+        BuildNode(bodies, 0, static_cast<uint32_t>(count), root, 0, mNodes, mScratch[0]);
+        return;
+    }
+
+    // Split the root on this thread, then build one subtree per octant in parallel
+    uint32_t counts[8]{};
+    Partition(bodies, 0, static_cast<uint32_t>(count), root, counts, mScratch[0]);
+
+    uint32_t begins[8]{};
+    for (int octant = 1; octant < 8; ++octant)
+    {
+        begins[octant] = begins[octant - 1] + counts[octant - 1];
+    }
+
+    pool.ParallelFor(8, [&](size_t const octant) -> void
+    {
+        mSubtrees[octant].clear();
+        if (counts[octant] > 0)
+        {
+            uint32_t const begin = begins[octant];
+            BuildNode(bodies, begin, begin + counts[octant], ChildCell(root, static_cast<int>(octant)), 1, mSubtrees[octant], mScratch[octant]);
+        }
+    });
+
+    // Stitch: root first, then the subtrees back to back in octant order, which is already depth first
+    uint32_t offsets[8]{};
+    uint32_t total = 1;
+    for (int octant = 0; octant < 8; ++octant)
+    {
+        offsets[octant] = total;
+        total += static_cast<uint32_t>(mSubtrees[octant].size());
+    }
+    mNodes.resize(total);
+
+    pool.ParallelFor(8, [&](size_t const octant) -> void
+    {
+        std::vector<Node> const & subtree = mSubtrees[octant];
+        uint32_t const offset = offsets[octant];
+        for (size_t i = 0; i < subtree.size(); ++i)
+        {
+            Node node = subtree[i];
+            node.next += offset;
+            if (node.firstChild != NoChild)
+            {
+                node.firstChild += offset;
+            }
+            mNodes[offset + i] = node;
+        }
+    });
+
+    Node rootNode{};
+    for (int octant = 0; octant < 8; ++octant)
+    {
+        if (mSubtrees[octant].empty() == false)
+        {
+            Node const & child = mSubtrees[octant].front();
+            rootNode.mass += child.mass;
+            rootNode.comX += child.mass * child.comX;
+            rootNode.comY += child.mass * child.comY;
+            rootNode.comZ += child.mass * child.comZ;
+        }
+    }
+    if (rootNode.mass > 0.0)
+    {
+        rootNode.comX /= rootNode.mass;
+        rootNode.comY /= rootNode.mass;
+        rootNode.comZ /= rootNode.mass;
+    }
+    else
+    {
+        rootNode.comX = root.cx;
+        rootNode.comY = root.cy;
+        rootNode.comZ = root.cz;
+    }
+    double const comOffset = std::sqrt(
+        (rootNode.comX - root.cx) * (rootNode.comX - root.cx) +
+        (rootNode.comY - root.cy) * (rootNode.comY - root.cy) +
+        (rootNode.comZ - root.cz) * (rootNode.comZ - root.cz));
+    rootNode.openRadiusSquared = OpenRadiusSquared(2.0 * root.half, mOpeningAngle, comOffset);
+    rootNode.next = total;
+    rootNode.firstChild = 1;
+    mNodes[0] = rootNode;
+}
+
+//======================================================================================================================
+
+void BarnesHut::Evaluate(
+    Bodies const & bodies,
+    double const gravitationalConstant,
+    double const softening,
+    Forces const & forces,
+    ThreadPool & pool
+) const
+{
+    size_t const count = bodies.count;
+    double const softeningSquared = softening * softening;
+    uint32_t const nodeCount = static_cast<uint32_t>(mNodes.size());
+
+    // Bodies are walked in leaf order, so neighbouring bodies on a thread visit mostly the same nodes
+    constexpr size_t Chunk = 256;
+    size_t const chunkCount = (count + Chunk - 1) / Chunk;
+    pool.ParallelFor(chunkCount, [&](size_t const chunk) -> void
+    {
+        size_t const end = std::min(count, (chunk + 1) * Chunk);
+        for (size_t k = chunk * Chunk; k < end; ++k)
+        {
+            uint32_t const i = mOrder[k];
+            double const xi = bodies.x[i];
+            double const yi = bodies.y[i];
+            double const zi = bodies.z[i];
+            double ax = 0.0, ay = 0.0, az = 0.0, potential = 0.0;
+
+            uint32_t index = 0;
+            while (index < nodeCount)
+            {
+                Node const & node = mNodes[index];
+                if (node.firstChild == NoChild)
+                {
+                    for (uint32_t b = node.bodyBegin; b < node.bodyBegin + node.bodyCount; ++b)
+                    {
+                        uint32_t const j = mOrder[b];
+                        if (j == i)
+                        {
+                            continue;
+                        }
+                        double const dx = bodies.x[j] - xi;
+                        double const dy = bodies.y[j] - yi;
+                        double const dz = bodies.z[j] - zi;
+                        double const inverseDistance = 1.0 / std::sqrt(dx * dx + dy * dy + dz * dz + softeningSquared);
+                        double const massOverDistance = bodies.mass[j] * inverseDistance;
+                        double const scale = massOverDistance * inverseDistance * inverseDistance;
+                        ax += dx * scale;
+                        ay += dy * scale;
+                        az += dz * scale;
+                        potential -= massOverDistance;
+                    }
+                    index = node.next;
+                    continue;
+                }
+
+                double const dx = node.comX - xi;
+                double const dy = node.comY - yi;
+                double const dz = node.comZ - zi;
+                double const distanceSquared = dx * dx + dy * dy + dz * dz;
+                if (distanceSquared > node.openRadiusSquared)
+                {
+                    // Far enough, the whole cell acts as a point mass
+                    double const inverseDistance = 1.0 / std::sqrt(distanceSquared + softeningSquared);
+                    double const massOverDistance = node.mass * inverseDistance;
+                    double const scale = massOverDistance * inverseDistance * inverseDistance;
+                    ax += dx * scale;
+                    ay += dy * scale;
+                    az += dz * scale;
+                    potential -= massOverDistance;
+                    index = node.next;
+                }
+                else
+                {
+                    index = node.firstChild;
+                }
+            }
+
+            forces.ax[i] = gravitationalConstant * ax;
+            forces.ay[i] = gravitationalConstant * ay;
+            forces.az[i] = gravitationalConstant * az;
+            forces.potential[i] = gravitationalConstant * potential;
+        }
+    });
+}
+
+//======================================================================================================================
+
+uint32_t BarnesHut::BuildNode(
+    Bodies const & bodies,
+    uint32_t const begin,
+    uint32_t const end,
+    Cell const & cell,
+    int const depth,
+    std::vector<Node> & nodes,
+    std::vector<uint32_t> & scratch
+)
+{
+    auto const index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    Node node{};
+    if (end - begin <= LeafCapacity || depth >= MaxDepth)
+    {
+        for (uint32_t k = begin; k < end; ++k)
+        {
+            uint32_t const j = mOrder[k];
+            double const mass = bodies.mass[j];
+            node.mass += mass;
+            node.comX += mass * bodies.x[j];
+            node.comY += mass * bodies.y[j];
+            node.comZ += mass * bodies.z[j];
+        }
+        node.bodyBegin = begin;
+        node.bodyCount = end - begin;
+    }
+    else
+    {
+        uint32_t counts[8]{};
+        Partition(bodies, begin, end, cell, counts, scratch);
+
+        node.firstChild = index + 1;
+        uint32_t childBegin = begin;
+        for (int octant = 0; octant < 8; ++octant)
+        {
+            if (counts[octant] == 0)
+            {
+                continue;
+            }
+            uint32_t const child = BuildNode(bodies, childBegin, childBegin + counts[octant], ChildCell(cell, octant), depth + 1, nodes, scratch);
+            Node const & childNode = nodes[child];
+            node.mass += childNode.mass;
+            node.comX += childNode.mass * childNode.comX;
+            node.comY += childNode.mass * childNode.comY;
+            node.comZ += childNode.mass * childNode.comZ;
+            childBegin += counts[octant];
+        }
+    }
+
+    if (node.mass > 0.0)
+    {
+        node.comX /= node.mass;
+        node.comY /= node.mass;
+        node.comZ /= node.mass;
+    }
+    else
+    {
+        node.comX = cell.cx;
+        node.comY = cell.cy;
+        node.comZ = cell.cz;
+    }
+
+    double const comOffset = std::sqrt(
+        (node.comX - cell.cx) * (node.comX - cell.cx) +
+        (node.comY - cell.cy) * (node.comY - cell.cy) +
+        (node.comZ - cell.cz) * (node.comZ - cell.cz));
+    node.openRadiusSquared = OpenRadiusSquared(2.0 * cell.half, mOpeningAngle, comOffset);
+    node.next = static_cast<uint32_t>(nodes.size());
+    nodes[index] = node;
+    return index;
+}
+
+//======================================================================================================================
+
+void BarnesHut::Partition(
+    Bodies const & bodies,
+    uint32_t const begin,
+    uint32_t const end,
+    Cell const & cell,
+    uint32_t (&counts)[8],
+    std::vector<uint32_t> & scratch
+)
+{
+    auto const octantOf = [&](uint32_t const j) -> int
+    {
+        return (bodies.x[j] >= cell.cx ? 1 : 0) | (bodies.y[j] >= cell.cy ? 2 : 0) | (bodies.z[j] >= cell.cz ? 4 : 0);
+    };
+
+    // Counting sort through the scratch buffer
+    std::fill(counts, counts + 8, 0u);
+    for (uint32_t k = begin; k < end; ++k)
+    {
+        ++counts[octantOf(mOrder[k])];
+    }
+
+    uint32_t write[8]{};
+    for (int octant = 1; octant < 8; ++octant)
+    {
+        write[octant] = write[octant - 1] + counts[octant - 1];
+    }
+
+    scratch.resize(std::max<size_t>(scratch.size(), end - begin));
+    for (uint32_t k = begin; k < end; ++k)
+    {
+        uint32_t const j = mOrder[k];
+        scratch[write[octantOf(j)]++] = j;
+    }
+    std::copy(scratch.begin(), scratch.begin() + (end - begin), mOrder.begin() + begin);
+}
+
+//======================================================================================================================
+
+BarnesHut::Cell BarnesHut::ChildCell(Cell const & cell, int const octant)
+{
+    double const quarter = 0.5 * cell.half;
+    return Cell{
+        cell.cx + ((octant & 1) != 0 ? quarter : -quarter),
+        cell.cy + ((octant & 2) != 0 ? quarter : -quarter),
+        cell.cz + ((octant & 4) != 0 ? quarter : -quarter),
+        quarter
+    };
+}
+
+//======================================================================================================================
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Gravity.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Barnes-Hut octree for O(N log N) gravity.
+//
+// The tree is rebuilt from scratch every step: the root is split into its eight octants on one thread,
+// then each octant's subtree is built on its own task and the pieces are stitched together. Nodes are
+// stored depth first with a skip index, so a walk is a flat loop with no stack.
+class BarnesHut
+{
+public:
+
+    using Bodies = Gravity::Bodies;
+    using Forces = Gravity::Forces;
+
+    // Bodies per leaf before it gets split
+    inline static constexpr uint32_t LeafCapacity = 8;
+
+    // Stops runaway splitting when bodies sit on top of each other
+    inline static constexpr int MaxDepth = 32;
+
+    // openingAngle is theta: a cell of size s is treated as a point mass when s / d < theta.
+    // theta = 0 opens every cell and gives the exact sum.
+    void Build(Bodies const & bodies, double openingAngle, ThreadPool & pool);
+
+    // Softened gravity on every body from the tree made by the last Build
+    void Evaluate(
+        Bodies const & bodies,
+        double gravitationalConstant,
+        double softening,
+        Forces const & forces,
+        ThreadPool & pool
+    ) const;
+
+    [[nodiscard]]
+    size_t NodeCount() const { return mNodes.size(); }
+
+private:
+
+    static constexpr uint32_t NoChild = UINT32_MAX;
+
+    struct Node
+    {
+        double comX = 0.0, comY = 0.0, comZ = 0.0; // center of mass
+        double mass = 0.0;
+        double openRadiusSquared = 0.0; // closer than this and the cell must be opened
+        uint32_t next = 0;              // first node after this subtree
+        uint32_t firstChild = NoChild;  // NoChild for leaves
+        uint32_t bodyBegin = 0;         // leaves only, range in mOrder
+        uint32_t bodyCount = 0;
+    };
+
+    struct Cell
+    {
+        double cx, cy, cz;
+        double half;
+    };
+
+    // Appends the subtree for mOrder[begin, end) to nodes, returns the index of its root
+    uint32_t BuildNode(
+        Bodies const & bodies,
+        uint32_t begin,
+        uint32_t end,
+        Cell const & cell,
+        int depth,
+        std::vector<Node> & nodes,
+        std::vector<uint32_t> & scratch
+    );
+
+    // Sorts mOrder[begin, end) by octant of the cell, counts receives the size of each octant
+    void Partition(
+        Bodies const & bodies,
+        uint32_t begin,
+        uint32_t end,
+        Cell const & cell,
+        uint32_t (&counts)[8],
+        std::vector<uint32_t> & scratch
+    );
+
+    [[nodiscard]]
+    static Cell ChildCell(Cell const & cell, int octant);
+
+    double mOpeningAngle = 0.5;
+
+    std::vector<Node> mNodes{};
+    std::vector<uint32_t> mOrder{}; // body indices, grouped by leaf
+
+    // Per-octant build output, kept between steps so the allocations are reused
+    std::vector<Node> mSubtrees[8]{};
+    std::vector<uint32_t> mScratch[8]{};
+};
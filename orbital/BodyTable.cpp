@@ -0,0 +1,318 @@
+#include "BodyTable.hpp"
+
+#include <cassert>
+#include <cmath>
+
+//======================================================================================================================
+
+// Static bodies (no orbit) and elliptic orbits away from e == 1 go through the batched loop
+static bool IsBatched(Kepler::OrbitalElements const & orbit)
+{
+    return orbit.periapsisDistance == 0.0 || orbit.eccentricity < 1.0 - Kepler::NearParabolicTolerance;
+}
+
+static size_t RoundUpToLanes(size_t const count)
+{
+    return (count + BodyTable::LaneCount - 1) / BodyTable::LaneCount * BodyTable::LaneCount;
+}
+
+//======================================================================================================================
+
+void BodyTable::Reserve(size_t const count)
+{
+    size_t const padded = RoundUpToLanes(count);
+    mSemiMajorAxis.reserve(padded);
+    mSemiMinorAxis.reserve(padded);
+    mEccentricity.reserve(padded);
+    mMeanMotion.reserve(padded);
+    mPeriapsisTime.reserve(padded);
+    mPx.reserve(padded);
+    mPy.reserve(padded);
+    mPz.reserve(padded);
+    mQx.reserve(padded);
+    mQy.reserve(padded);
+    mQz.reserve(padded);
+    mParent.reserve(padded);
+    mX.reserve(padded);
+    mY.reserve(padded);
+    mZ.reserve(padded);
+    mOrbit.reserve(padded);
+    mPhysical.reserve(padded);
+    mId.reserve(padded);
+    mIndexOfId.reserve(count);
+}
+
+//======================================================================================================================
+
+void BodyTable::Clear()
+{
+    mSize = 0;
+    ResizeColumns(0);
+    mGeneralBodies.clear();
+    mIndexOfId.clear();
+    mFreeIds.clear();
+}
+
+//======================================================================================================================
+
+BodyTable::BodyId BodyTable::Add(Kepler::OrbitalElements const & orbit, Physical const & physical, BodyId const parent)
+{
+    BodyId const id = Append(orbit, physical, parent);
+    if (IsBatched(orbit) == false)
+    {
+        mGeneralBodies.push_back(IndexOf(id));
+    }
+    return id;
+}
+
+//======================================================================================================================
+
+BodyTable::BodyId BodyTable::AddStatic(Physical const & physical, BodyId const parent)
+{
+    Kepler::OrbitalElements orbit{};
+    orbit.periapsisDistance = 0.0;
+    orbit.gravitationalParameter = 0.0;
+    return Append(orbit, physical, parent);
+}
+
+//======================================================================================================================
+
+BodyTable::BodyId BodyTable::Append(Kepler::OrbitalElements const & orbit, Physical const & physical, BodyId const parent)
+{
+    assert(parent == InvalidId || Contains(parent));
+
+    if (mSize == PaddedSize())
+    {
+        ResizeColumns(mSize + LaneCount);
+    }
+
+    BodyId id = InvalidId;
+    if (mFreeIds.empty() == false)
+    {
+        id = mFreeIds.back();
+        mFreeIds.pop_back();
+    }
+    else
+    {
+        id = static_cast<BodyId>(mIndexOfId.size());
+        mIndexOfId.emplace_back();
+    }
+
+    size_t const index = mSize++;
+    mIndexOfId[id] = static_cast<uint32_t>(index);
+    mId[index] = id;
+    mParent[index] = parent == InvalidId ? NoParent : IndexOf(parent);
+    mOrbit[index] = orbit;
+    mPhysical[index] = physical;
+    WriteHotColumns(index);
+
+    return id;
+}
+
+//======================================================================================================================
+
+void BodyTable::Remove(BodyId const id)
+{
+    assert(Contains(id));
+
+    // Parents come first, so one forward pass finds the whole subtree and compacts what is left
+    uint32_t const first = IndexOf(id);
+    std::vector<uint32_t> newIndex(mSize - first, InvalidIndex);
+
+    size_t write = first;
+    for (size_t read = first; read < mSize; ++read)
+    {
+        uint32_t const parent = mParent[read];
+        bool const removed = read == first ||
+            (parent != NoParent && parent >= first && newIndex[parent - first] == InvalidIndex);
+
+        if (removed)
+        {
+            mIndexOfId[mId[read]] = InvalidIndex;
+            mFreeIds.push_back(mId[read]);
+            continue;
+        }
+
+        newIndex[read - first] = static_cast<uint32_t>(write);
+        if (write != read)
+        {
+            mSemiMajorAxis[write] = mSemiMajorAxis[read];
+            mSemiMinorAxis[write] = mSemiMinorAxis[read];
+            mEccentricity[write] = mEccentricity[read];
+            mMeanMotion[write] = mMeanMotion[read];
+            mPeriapsisTime[write] = mPeriapsisTime[read];
+            mPx[write] = mPx[read];
+            mPy[write] = mPy[read];
+            mPz[write] = mPz[read];
+            mQx[write] = mQx[read];
+            mQy[write] = mQy[read];
+            mQz[write] = mQz[read];
+            mX[write] = mX[read];
+            mY[write] = mY[read];
+            mZ[write] = mZ[read];
+            mOrbit[write] = mOrbit[read];
+            mPhysical[write] = mPhysical[read];
+            mId[write] = mId[read];
+        }
+        mParent[write] = (parent != NoParent && parent >= first) ? newIndex[parent - first] : parent;
+        mIndexOfId[mId[write]] = static_cast<uint32_t>(write);
+        ++write;
+    }
+
+    mSize = write;
+    ResizeColumns(RoundUpToLanes(mSize));
+    RebuildGeneralBodies();
+}
+
+//======================================================================================================================
+
+void BodyTable::SetOrbit(BodyId const id, Kepler::OrbitalElements const & orbit)
+{
+    uint32_t const index = IndexOf(id);
+    bool const wasBatched = IsBatched(mOrbit[index]);
+    mOrbit[index] = orbit;
+    WriteHotColumns(index);
+    if (wasBatched != IsBatched(orbit))
+    {
+        RebuildGeneralBodies();
+    }
+}
+
+//======================================================================================================================
+
+void BodyTable::Propagate(double const time)
+{
+    // Batched elliptic solve, eight bodies per step on the widest instruction set the CPU has
+    KeplerBatch::Columns columns{};
+    columns.semiMajorAxis = mSemiMajorAxis.data();
+    columns.semiMinorAxis = mSemiMinorAxis.data();
+    columns.eccentricity = mEccentricity.data();
+    columns.meanMotion = mMeanMotion.data();
+    columns.periapsisTime = mPeriapsisTime.data();
+    columns.px = mPx.data();
+    columns.py = mPy.data();
+    columns.pz = mPz.data();
+    columns.qx = mQx.data();
+    columns.qy = mQy.data();
+    columns.qz = mQz.data();
+    columns.x = mX.data();
+    columns.y = mY.data();
+    columns.z = mZ.data();
+    columns.count = PaddedSize();
+    KeplerBatch::Propagate(columns, time);
+
+    // The rare orbits the batch can't handle
+    for (uint32_t const index : mGeneralBodies)
+    {
+        glm::dvec3 const position = Kepler::Propagate(mOrbit[index], time).position;
+        mX[index] = position.x;
+        mY[index] = position.y;
+        mZ[index] = position.z;
+    }
+
+    // Move children into their parent's frame, parents are always final by the time we reach a child
+    for (size_t i = 0; i < mSize; ++i)
+    {
+        uint32_t const parent = mParent[i];
+        if (parent != NoParent)
+        {
+            mX[i] += mX[parent];
+            mY[i] += mY[parent];
+            mZ[i] += mZ[parent];
+        }
+    }
+}
+
+//======================================================================================================================
+
+glm::dvec3 BodyTable::Position(BodyId const id) const
+{
+    uint32_t const index = IndexOf(id);
+    return glm::dvec3{mX[index], mY[index], mZ[index]};
+}
+
+//======================================================================================================================
+
+void BodyTable::WriteHotColumns(size_t const index)
+{
+    Kepler::OrbitalElements const & orbit = mOrbit[index];
+    bool const batched = IsBatched(orbit) && orbit.periapsisDistance != 0.0;
+
+    // Static and non-elliptic bodies get all zeros, which the batched loop turns into the origin
+    Kepler::PerifocalBasis basis{};
+    double a = 0.0;
+    double b = 0.0;
+    double e = 0.0;
+    double n = 0.0;
+    double periapsisTime = 0.0;
+    if (batched)
+    {
+        basis = Kepler::Basis(orbit);
+        e = orbit.eccentricity;
+        a = Kepler::SemiMajorAxis(orbit);
+        b = a * std::sqrt(1.0 - e * e);
+        n = Kepler::MeanMotion(orbit);
+        periapsisTime = orbit.periapsisTime;
+    }
+
+    mSemiMajorAxis[index] = a;
+    mSemiMinorAxis[index] = b;
+    mEccentricity[index] = e;
+    mMeanMotion[index] = n;
+    mPeriapsisTime[index] = periapsisTime;
+    mPx[index] = basis.p.x;
+    mPy[index] = basis.p.y;
+    mPz[index] = basis.p.z;
+    mQx[index] = basis.q.x;
+    mQy[index] = basis.q.y;
+    mQz[index] = basis.q.z;
+}
+
+//======================================================================================================================
+
+void BodyTable::ResizeColumns(size_t const paddedSize)
+{
+    mSemiMajorAxis.resize(paddedSize, 0.0);
+    mSemiMinorAxis.resize(paddedSize, 0.0);
+    mEccentricity.resize(paddedSize, 0.0);
+    mMeanMotion.resize(paddedSize, 0.0);
+    mPeriapsisTime.resize(paddedSize, 0.0);
+    mPx.resize(paddedSize, 0.0);
+    mPy.resize(paddedSize, 0.0);
+    mPz.resize(paddedSize, 0.0);
+    mQx.resize(paddedSize, 0.0);
+    mQy.resize(paddedSize, 0.0);
+    mQz.resize(paddedSize, 0.0);
+    mParent.resize(paddedSize, NoParent);
+    mX.resize(paddedSize, 0.0);
+    mY.resize(paddedSize, 0.0);
+    mZ.resize(paddedSize, 0.0);
+    mOrbit.resize(paddedSize);
+    mPhysical.resize(paddedSize);
+    mId.resize(paddedSize, InvalidId);
+
+    // Rows that used to hold bodies must go back to being inert
+    for (size_t i = mSize; i < paddedSize; ++i)
+    {
+        mSemiMajorAxis[i] = mSemiMinorAxis[i] = mEccentricity[i] = mMeanMotion[i] = mPeriapsisTime[i] = 0.0;
+        mPx[i] = mPy[i] = mPz[i] = mQx[i] = mQy[i] = mQz[i] = 0.0;
+        mParent[i] = NoParent;
+        mId[i] = InvalidId;
+    }
+}
+
+//======================================================================================================================
+
+void BodyTable::RebuildGeneralBodies()
+{
+    mGeneralBodies.clear();
+    for (size_t i = 0; i < mSize; ++i)
+    {
+        if (IsBatched(mOrbit[i]) == false)
+        {
+            mGeneralBodies.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+//======================================================================================================================
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "Kepler.hpp"
+#include "KeplerBatch.hpp"
+
+#include <cstdint>
+#include <limits>
+
+// Flat structure-of-arrays store for every orbiting body.
+//
+// Each property lives in its own 64-byte aligned column so the propagation loop only streams the
+// values it needs. Bodies are kept topologically sorted (a parent always has a lower index than its
+// children), which lets the hierarchy be resolved in a single forward pass. Columns are padded to a
+// multiple of LaneCount with inert bodies so batched kernels never need a scalar tail.
+//
+// Indices change when bodies are removed, ids don't. Use IndexOf to go from one to the other.
+class BodyTable
+{
+public:
+
+    using BodyId = uint32_t;
+
+    static constexpr BodyId InvalidId = std::numeric_limits<BodyId>::max();
+    static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NoParent = InvalidIndex;
+    static constexpr size_t LaneCount = KeplerBatch::LaneCount;
+
+    // Per-body values that don't take part in propagation
+    struct Physical
+    {
+        float radius = 0.0f;
+        float rotationSpeed = 0.0f; // radians per unit time
+        float axialTilt = 0.0f;     // degrees
+    };
+
+    void Reserve(size_t count);
+
+    void Clear();
+
+    // The parent must already be in the table, which is what keeps the table topologically sorted
+    BodyId Add(Kepler::OrbitalElements const & orbit, Physical const & physical, BodyId parent = InvalidId);
+
+    // A body that sits still relative to its parent (e.g. the Sun at the origin)
+    BodyId AddStatic(Physical const & physical, BodyId parent = InvalidId);
+
+    // Removes the body and all of its descendants in one order preserving pass
+    void Remove(BodyId id);
+
+    void SetOrbit(BodyId id, Kepler::OrbitalElements const & orbit);
+
+    // Evaluates every body at the given time. Positions end up relative to the root of each hierarchy.
+    void Propagate(double time);
+
+    [[nodiscard]]
+    size_t Size() const { return mSize; }
+
+    // Size rounded up to LaneCount, the length of every column
+    [[nodiscard]]
+    size_t PaddedSize() const { return mX.size(); }
+
+    [[nodiscard]]
+    uint32_t IndexOf(BodyId id) const { return mIndexOfId[id]; }
+
+    [[nodiscard]]
+    bool Contains(BodyId id) const { return id < mIndexOfId.size() && mIndexOfId[id] != InvalidIndex; }
+
+    [[nodiscard]]
+    glm::dvec3 Position(BodyId id) const;
+
+    // InvalidId for bodies at the root of a hierarchy
+    [[nodiscard]]
+    BodyId Parent(BodyId id) const
+    {
+        uint32_t const parent = mParent[IndexOf(id)];
+        return parent == NoParent ? InvalidId : mId[parent];
+    }
+
+    [[nodiscard]]
+    Kepler::OrbitalElements const & Orbit(BodyId id) const { return mOrbit[IndexOf(id)]; }
+
+    [[nodiscard]]
+    Physical const & PhysicalProperties(BodyId id) const { return mPhysical[IndexOf(id)]; }
+
+    // Raw column access for batched consumers (instancing, force kernels, ...)
+    [[nodiscard]] double const * X() const { return mX.data(); }
+    [[nodiscard]] double const * Y() const { return mY.data(); }
+    [[nodiscard]] double const * Z() const { return mZ.data(); }
+    [[nodiscard]] uint32_t const * Parents() const { return mParent.data(); }
+    [[nodiscard]] Physical const * Physicals() const { return mPhysical.data(); }
+
+private:
+
+    BodyId Append(Kepler::OrbitalElements const & orbit, Physical const & physical, BodyId parent);
+
+    void WriteHotColumns(size_t index);
+
+    // Resizes every column, new rows are inert padding
+    void ResizeColumns(size_t paddedSize);
+
+    void RebuildGeneralBodies();
+
+    size_t mSize = 0;
+
+    // Propagation inputs, only valid for bodies the batched solver can handle (everything else is zeroed)
+    AlignedVector<double> mSemiMajorAxis{};
+    AlignedVector<double> mSemiMinorAxis{};
+    AlignedVector<double> mEccentricity{};
+    AlignedVector<double> mMeanMotion{};
+    AlignedVector<double> mPeriapsisTime{};
+    AlignedVector<double> mPx{}, mPy{}, mPz{};
+    AlignedVector<double> mQx{}, mQy{}, mQz{};
+    AlignedVector<uint32_t> mParent{};
+
+    // Propagation outputs
+    AlignedVector<double> mX{}, mY{}, mZ{};
+
+    // Cold data
+    AlignedVector<Kepler::OrbitalElements> mOrbit{};
+    AlignedVector<Physical> mPhysical{};
+    AlignedVector<BodyId> mId{};
+
+    // Near-parabolic and hyperbolic bodies, propagated through the general solver after the batch
+    std::vector<uint32_t> mGeneralBodies{};
+
+    std::vector<uint32_t> mIndexOfId{};
+    std::vector<BodyId> mFreeIds{};
+};
@@ -0,0 +1,83 @@
+#include "CpuFeatures.hpp"
+
+#if defined(ORBITAL_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//======================================================================================================================
+
+namespace
+{
+    using InstructionSet = CpuFeatures::InstructionSet;
+
+    bool CpuSupports(InstructionSet const instructionSet)
+    {
+        if (instructionSet == InstructionSet::Scalar)
+        {
+            return true;
+        }
+#if defined(ORBITAL_X86_SIMD) && defined(_MSC_VER)
+        int info[4]{};
+        __cpuid(info, 1);
+        bool const sse42 = (info[2] & (1 << 20)) != 0;
+        if (instructionSet == InstructionSet::SSE42)
+        {
+            return sse42;
+        }
+        // AVX needs the OS to save the ymm registers, which xgetbv reports
+        bool const fma = (info[2] & (1 << 12)) != 0;
+        bool const osxsave = (info[2] & (1 << 27)) != 0;
+        if (sse42 == false || fma == false || osxsave == false || (_xgetbv(0) & 0x6) != 0x6)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(ORBITAL_X86_SIMD)
+        __builtin_cpu_init();
+        if (instructionSet == InstructionSet::SSE42)
+        {
+            return __builtin_cpu_supports("sse4.2");
+        }
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+        return false;
+#endif
+    }
+}
+
+//======================================================================================================================
+
+CpuFeatures::InstructionSet CpuFeatures::Detect()
+{
+    static InstructionSet const best = CpuSupports(InstructionSet::AVX2) ? InstructionSet::AVX2
+        : CpuSupports(InstructionSet::SSE42) ? InstructionSet::SSE42
+        : InstructionSet::Scalar;
+    return best;
+}
+
+//======================================================================================================================
+
+bool CpuFeatures::IsSupported(InstructionSet const instructionSet)
+{
+    return instructionSet <= Detect();
+}
+
+//======================================================================================================================
+
+char const * CpuFeatures::Name(InstructionSet const instructionSet)
+{
+    switch (instructionSet)
+    {
+    case InstructionSet::AVX2:
+        return "AVX2";
+    case InstructionSet::SSE42:
+        return "SSE4.2";
+    case InstructionSet::Scalar:
+        return "Scalar";
+    }
+    return "Unknown";
+}
+
+//======================================================================================================================
+
@@ -0,0 +1,23 @@
+#pragma once
+
+// Runtime check for the SIMD instruction sets the kernels in this library are built for
+namespace CpuFeatures
+{
+    // Ordered, every set implies the ones before it
+    enum class InstructionSet
+    {
+        Scalar,
+        SSE42,
+        AVX2 // with FMA
+    };
+
+    // Best instruction set this CPU (and OS) supports, only ever computed once
+    [[nodiscard]]
+    InstructionSet Detect();
+
+    [[nodiscard]]
+    bool IsSupported(InstructionSet instructionSet);
+
+    [[nodiscard]]
+    char const * Name(InstructionSet instructionSet);
+}
@@ -0,0 +1,160 @@
+#include "DirectSummation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+// Targets per vector in the AVX2 kernel, every column is padded to it
+static constexpr size_t VectorWidth = 4;
+
+//======================================================================================================================
+
+// Same loop structure as the AVX2 kernel, for CPUs without it and non-x86 builds
+static void TileScalar(DirectSummation::Padded const & bodies, size_t const iBegin, size_t const iEnd)
+{
+    std::fill(bodies.ax + iBegin, bodies.ax + iEnd, 0.0);
+    std::fill(bodies.ay + iBegin, bodies.ay + iEnd, 0.0);
+    std::fill(bodies.az + iBegin, bodies.az + iEnd, 0.0);
+    std::fill(bodies.potential + iBegin, bodies.potential + iEnd, 0.0);
+
+    for (size_t jBegin = 0; jBegin < bodies.count; jBegin += DirectSummation::TileJ)
+    {
+        size_t const jEnd = std::min(bodies.count, jBegin + DirectSummation::TileJ);
+        for (size_t i = iBegin; i < iEnd; ++i)
+        {
+            double ax = 0.0, ay = 0.0, az = 0.0, potential = 0.0;
+            for (size_t j = jBegin; j < jEnd; ++j)
+            {
+                double const dx = bodies.x[j] - bodies.x[i];
+                double const dy = bodies.y[j] - bodies.y[i];
+                double const dz = bodies.z[j] - bodies.z[i];
+                double const distanceSquared = dx * dx + dy * dy + dz * dz + bodies.softeningSquared;
+                double const inverseDistance = distanceSquared > 0.0 ? 1.0 / std::sqrt(distanceSquared) : 0.0;
+                double const massOverDistance = bodies.mass[j] * inverseDistance;
+                double const scale = massOverDistance * inverseDistance * inverseDistance;
+                ax += dx * scale;
+                ay += dy * scale;
+                az += dz * scale;
+                potential -= massOverDistance;
+            }
+            bodies.ax[i] += ax;
+            bodies.ay[i] += ay;
+            bodies.az[i] += az;
+            bodies.potential[i] += potential;
+        }
+    }
+}
+
+//======================================================================================================================
+
+void DirectSummation::Evaluate(
+    Bodies const & bodies,
+    double const gravitationalConstant,
+    double const softening,
+    Forces const & forces,
+    ThreadPool & pool,
+    size_t const maxThreads,
+    CpuFeatures::InstructionSet const instructionSet
+)
+{
+    size_t const count = bodies.count;
+    size_t const padded = (count + VectorWidth - 1) / VectorWidth * VectorWidth;
+
+    // Padding sits at the origin with no mass, so it adds nothing to anyone
+    for (AlignedVector<double> * column : {&mX, &mY, &mZ, &mMass, &mAx, &mAy, &mAz, &mPotential})
+    {
+        column->assign(padded, 0.0);
+    }
+    std::copy(bodies.x, bodies.x + count, mX.begin());
+    std::copy(bodies.y, bodies.y + count, mY.begin());
+    std::copy(bodies.z, bodies.z + count, mZ.begin());
+    std::copy(bodies.mass, bodies.mass + count, mMass.begin());
+
+    Padded const input{
+        mX.data(), mY.data(), mZ.data(), mMass.data(), padded, softening * softening,
+        mAx.data(), mAy.data(), mAz.data(), mPotential.data()
+    };
+
+    auto tile = &TileScalar;
+#if defined(ORBITAL_X86_SIMD)
+    if (instructionSet == CpuFeatures::InstructionSet::AVX2 && CpuFeatures::IsSupported(CpuFeatures::InstructionSet::AVX2))
+    {
+        tile = &DirectSummationDetail::TileAVX2;
+    }
+#endif
+
+    // Each task owns its i-tile outright, which is what keeps the accumulation free of atomics
+    size_t const tileCount = (padded + TileI - 1) / TileI;
+    pool.ParallelFor(tileCount, [&](size_t const t) -> void
+    {
+        size_t const iBegin = t * TileI;
+        tile(input, iBegin, std::min(padded, iBegin + TileI));
+    }, maxThreads);
+
+    // Softening turns the self pair into a finite -m/eps, take it back out
+    double const inverseSoftening = softening > 0.0 ? 1.0 / softening : 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        forces.ax[i] = gravitationalConstant * mAx[i];
+        forces.ay[i] = gravitationalConstant * mAy[i];
+        forces.az[i] = gravitationalConstant * mAz[i];
+        forces.potential[i] = gravitationalConstant * (mPotential[i] + bodies.mass[i] * inverseSoftening);
+    }
+}
+
+//======================================================================================================================
+
+std::vector<DirectSummation::BenchmarkResult> DirectSummation::Benchmark(size_t const bodyCount, ThreadPool & pool)
+{
+    // Uniform ball, only the amount of work matters here
+    std::mt19937 generator(453);
+    std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+    std::vector<double> x, y, z, mass(bodyCount, 1.0 / static_cast<double>(bodyCount));
+    while (x.size() < bodyCount)
+    {
+        double const px = coordinate(generator), py = coordinate(generator), pz = coordinate(generator);
+        if (px * px + py * py + pz * pz <= 1.0)
+        {
+            x.push_back(px);
+            y.push_back(py);
+            z.push_back(pz);
+        }
+    }
+    std::vector<double> ax(bodyCount), ay(bodyCount), az(bodyCount), potential(bodyCount);
+    Bodies const bodies{x.data(), y.data(), z.data(), mass.data(), bodyCount};
+    Forces const forces{ax.data(), ay.data(), az.data(), potential.data()};
+
+    std::vector<size_t> threadCounts{};
+    for (size_t threads = 1; threads < pool.ThreadCount(); threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(pool.ThreadCount());
+
+    DirectSummation solver{};
+    std::vector<BenchmarkResult> results{};
+    for (size_t const threads : threadCounts)
+    {
+        // Best of three, the first run also warms the caches and the pool
+        double best = 0.0;
+        for (int run = 0; run < 3; ++run)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            solver.Evaluate(bodies, 1.0, 1e-3, forces, pool, threads);
+            double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = run == 0 ? seconds : std::min(best, seconds);
+        }
+
+        double const interactions = static_cast<double>(bodyCount) * static_cast<double>(bodyCount);
+        BenchmarkResult result{};
+        result.threads = threads;
+        result.seconds = best;
+        result.interactionsPerSecond = interactions / std::max(best, 1e-9);
+        result.gflops = result.interactionsPerSecond * FlopsPerInteraction * 1e-9;
+        results.push_back(result);
+    }
+    return results;
+}
+
+//======================================================================================================================
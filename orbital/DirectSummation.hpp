@@ -0,0 +1,86 @@
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "CpuFeatures.hpp"
+#include "Gravity.hpp"
+#include "ThreadPool.hpp"
+
+#include <vector>
+
+// Exact O(N^2) gravity for systems small enough to afford it.
+//
+// Bodies are split into i-tiles, one task each, so every thread only ever writes the forces of its own
+// bodies and nothing needs to be atomic. Inside a tile the sources are streamed in j-tiles small enough
+// to stay in L1 while every i-vector of the tile runs over them. The AVX2 kernel gets 1/sqrt(r^2) from
+// the single precision rsqrt estimate plus two Newton steps, which is good to ~1e-13 relative. The
+// estimate only covers the float range, so squared distances are clamped to at least FLT_MIN first:
+// without softening, bodies closer than ~1e-19 pull as if they were that far apart.
+class DirectSummation
+{
+public:
+
+    using Bodies = Gravity::Bodies;
+    using Forces = Gravity::Forces;
+
+    // Past this the tree is the better tool
+    inline static constexpr size_t MaxBodies = 50'000;
+
+    // Bodies per task
+    inline static constexpr size_t TileI = 256;
+
+    // Sources per L1 pass (4 columns * 512 * 8 bytes = 16 KB)
+    inline static constexpr size_t TileJ = 512;
+
+    // Usual convention for counting the cost of one softened interaction
+    inline static constexpr double FlopsPerInteraction = 20.0;
+
+    struct BenchmarkResult
+    {
+        size_t threads = 0;
+        double seconds = 0.0;               // one full evaluation
+        double interactionsPerSecond = 0.0;
+        double gflops = 0.0;
+    };
+
+    // maxThreads limits how much of the pool is used (0 = all of it). instructionSet caps the kernel,
+    // AVX2 still only runs if the CPU has it and anything below it runs the scalar one.
+    void Evaluate(
+        Bodies const & bodies,
+        double gravitationalConstant,
+        double softening,
+        Forces const & forces,
+        ThreadPool & pool,
+        size_t maxThreads = 0,
+        CpuFeatures::InstructionSet instructionSet = CpuFeatures::InstructionSet::AVX2
+    );
+
+    // Scaling for 1, 2, 4, ... threads up to the whole pool, on a random cluster of the given size
+    [[nodiscard]]
+    static std::vector<BenchmarkResult> Benchmark(size_t bodyCount, ThreadPool & pool);
+
+    // Inputs copied and padded to the vector width (padding has no mass), outputs before scaling by G
+    struct Padded
+    {
+        double const * x;
+        double const * y;
+        double const * z;
+        double const * mass;
+        size_t count;
+        double softeningSquared;
+        double * ax;
+        double * ay;
+        double * az;
+        double * potential;
+    };
+
+private:
+
+    AlignedVector<double> mX{}, mY{}, mZ{}, mMass{};
+    AlignedVector<double> mAx{}, mAy{}, mAz{}, mPotential{};
+};
+
+namespace DirectSummationDetail
+{
+    // Accumulates every source into bodies [iBegin, iEnd), built with AVX2 + FMA in its own translation unit (x86 only)
+    void TileAVX2(DirectSummation::Padded const & bodies, size_t iBegin, size_t iEnd);
+}
@@ -0,0 +1,80 @@
+// Compiled with AVX2 + FMA enabled, only ever called after CpuFeatures::Detect has checked for them.
+// Sticks to intrinsics so no standard library inline function gets built with the wider flags.
+#include "DirectSummation.hpp"
+
+#include <cfloat>
+#include <immintrin.h>
+
+//======================================================================================================================
+
+// 1/sqrt(x) from the ~12 bit single precision estimate, each Newton step doubles the good bits (12 -> 24 -> 48).
+// The estimate needs x as a normal float. Below FLT_MIN it turns into infinity and the Newton steps into
+// NaN, so x is clamped up to it. Above FLT_MAX the estimate is zero and so is the result, which is within
+// 1/sqrt(FLT_MAX) ~ 5e-20 of the true value anyway.
+// Zero (a body meeting itself without softening) gives zero instead of infinity.
+static inline __m256d InverseSqrt(__m256d const x)
+{
+    __m256d const clamped = _mm256_max_pd(x, _mm256_set1_pd(FLT_MIN));
+    __m256d y = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(clamped)));
+    __m256d const halfX = _mm256_mul_pd(_mm256_set1_pd(0.5), clamped);
+    __m256d const threeHalves = _mm256_set1_pd(1.5);
+    y = _mm256_mul_pd(y, _mm256_fnmadd_pd(halfX, _mm256_mul_pd(y, y), threeHalves));
+    y = _mm256_mul_pd(y, _mm256_fnmadd_pd(halfX, _mm256_mul_pd(y, y), threeHalves));
+    return _mm256_and_pd(y, _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_GT_OQ));
+}
+
+//======================================================================================================================
+
+void DirectSummationDetail::TileAVX2(DirectSummation::Padded const & bodies, size_t const iBegin, size_t const iEnd)
+{
+    __m256d const softeningSquared = _mm256_set1_pd(bodies.softeningSquared);
+
+    for (size_t i = iBegin; i < iEnd; i += 4)
+    {
+        _mm256_store_pd(bodies.ax + i, _mm256_setzero_pd());
+        _mm256_store_pd(bodies.ay + i, _mm256_setzero_pd());
+        _mm256_store_pd(bodies.az + i, _mm256_setzero_pd());
+        _mm256_store_pd(bodies.potential + i, _mm256_setzero_pd());
+    }
+
+    for (size_t jBegin = 0; jBegin < bodies.count; jBegin += DirectSummation::TileJ)
+    {
+        size_t const jEnd = jBegin + DirectSummation::TileJ < bodies.count ? jBegin + DirectSummation::TileJ : bodies.count;
+
+        // Four targets per vector, the sources are broadcast one at a time
+        for (size_t i = iBegin; i < iEnd; i += 4)
+        {
+            __m256d const xi = _mm256_load_pd(bodies.x + i);
+            __m256d const yi = _mm256_load_pd(bodies.y + i);
+            __m256d const zi = _mm256_load_pd(bodies.z + i);
+            __m256d ax = _mm256_load_pd(bodies.ax + i);
+            __m256d ay = _mm256_load_pd(bodies.ay + i);
+            __m256d az = _mm256_load_pd(bodies.az + i);
+            __m256d potential = _mm256_load_pd(bodies.potential + i);
+
+            for (size_t j = jBegin; j < jEnd; ++j)
+            {
+                __m256d const dx = _mm256_sub_pd(_mm256_broadcast_sd(bodies.x + j), xi);
+                __m256d const dy = _mm256_sub_pd(_mm256_broadcast_sd(bodies.y + j), yi);
+                __m256d const dz = _mm256_sub_pd(_mm256_broadcast_sd(bodies.z + j), zi);
+                __m256d const distanceSquared = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_fmadd_pd(dz, dz, softeningSquared)));
+
+                __m256d const inverseDistance = InverseSqrt(distanceSquared);
+                __m256d const massOverDistance = _mm256_mul_pd(_mm256_broadcast_sd(bodies.mass + j), inverseDistance);
+                __m256d const scale = _mm256_mul_pd(massOverDistance, _mm256_mul_pd(inverseDistance, inverseDistance));
+
+                ax = _mm256_fmadd_pd(dx, scale, ax);
+                ay = _mm256_fmadd_pd(dy, scale, ay);
+                az = _mm256_fmadd_pd(dz, scale, az);
+                potential = _mm256_sub_pd(potential, massOverDistance);
+            }
+
+            _mm256_store_pd(bodies.ax + i, ax);
+            _mm256_store_pd(bodies.ay + i, ay);
+            _mm256_store_pd(bodies.az + i, az);
+            _mm256_store_pd(bodies.potential + i, potential);
+        }
+    }
+}
+
+//======================================================================================================================
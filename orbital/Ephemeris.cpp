@@ -0,0 +1,230 @@
+#include "Ephemeris.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// Byte offsets into the header record, as written by asc2eph
+static constexpr size_t DatesOffset = 2652;          // start, end, days per record
+static constexpr size_t ConstantCountOffset = 2676;
+static constexpr size_t AstronomicalUnitOffset = 2680;
+static constexpr size_t EarthMoonMassRatioOffset = 2688;
+static constexpr size_t LayoutOffset = 2696;         // 12 triples: the 11 body series + nutations
+static constexpr size_t VersionOffset = 2840;
+static constexpr size_t LibrationLayoutOffset = 2844;
+static constexpr size_t ExtraNamesOffset = 2856;     // names of the constants past the first 400
+static constexpr size_t ConstantNameLength = 6;
+static constexpr size_t HeaderConstantNames = 400;
+
+// Longest series any DE file uses is 18 coefficients, this leaves room without a heap allocation
+static constexpr uint32_t MaxCoefficients = 32;
+
+//======================================================================================================================
+
+template <typename T>
+static T ReadHeader(std::byte const * data, size_t const offset)
+{
+    T value{};
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+//======================================================================================================================
+
+Ephemeris::Ephemeris(std::string const & path)
+    : mFile(path)
+{
+    std::byte const * data = mFile.Data();
+    if (mFile.Size() < ExtraNamesOffset)
+    {
+        throw std::runtime_error(path + " is too small to be a DE ephemeris");
+    }
+
+    // A file in the other byte order has nonsense here, which is the cheapest way to tell
+    int32_t const constantCount = ReadHeader<int32_t>(data, ConstantCountOffset);
+    mVersion = ReadHeader<int32_t>(data, VersionOffset);
+    if (mVersion < 100 || mVersion > 9999 || constantCount < 0 || constantCount > 10'000)
+    {
+        throw std::runtime_error(path + " is not a DE ephemeris in native byte order");
+    }
+
+    mStartDate = ReadHeader<double>(data, DatesOffset);
+    mEndDate = ReadHeader<double>(data, DatesOffset + 8);
+    mRecordSpan = ReadHeader<double>(data, DatesOffset + 16);
+    mAstronomicalUnit = ReadHeader<double>(data, AstronomicalUnitOffset);
+    mEarthMoonMassRatio = ReadHeader<double>(data, EarthMoonMassRatioOffset);
+
+    // The record length isn't stored, it is wherever the last coefficient of the last series ends.
+    // Newer files append two more series after the names of the extra constants, those count too.
+    auto const seriesEnd = [data](size_t const offset, uint32_t const components) -> size_t
+    {
+        auto const value = [data, offset](size_t const i) -> uint32_t
+        {
+            return static_cast<uint32_t>(std::max(ReadHeader<int32_t>(data, offset + i * 4), 0));
+        };
+        return value(0) == 0 ? 0 : value(0) - 1 + static_cast<size_t>(value(1)) * components * value(2);
+    };
+
+    for (size_t i = 0; i < SERIES_COUNT; ++i)
+    {
+        size_t const offset = LayoutOffset + i * 12;
+        SeriesLayout & layout = mLayout[i];
+        layout.offset = static_cast<uint32_t>(ReadHeader<int32_t>(data, offset));
+        layout.coefficientCount = static_cast<uint32_t>(ReadHeader<int32_t>(data, offset + 4));
+        layout.subintervalCount = static_cast<uint32_t>(ReadHeader<int32_t>(data, offset + 8));
+        if (layout.offset < 3 || layout.coefficientCount < 2 || layout.coefficientCount > MaxCoefficients ||
+            layout.subintervalCount == 0)
+        {
+            throw std::runtime_error(path + " has an unexpected series layout");
+        }
+        mRecordSize = std::max(mRecordSize, seriesEnd(offset, 3));
+    }
+    mRecordSize = std::max(mRecordSize, seriesEnd(LayoutOffset + 11 * 12, 2)); // nutations
+    mRecordSize = std::max(mRecordSize, seriesEnd(LibrationLayoutOffset, 3));
+    if (static_cast<size_t>(constantCount) > HeaderConstantNames)
+    {
+        size_t const offset = ExtraNamesOffset + (constantCount - HeaderConstantNames) * ConstantNameLength;
+        if (offset + 24 <= mFile.Size())
+        {
+            mRecordSize = std::max(mRecordSize, seriesEnd(offset, 3));      // lunar mantle angular velocity
+            mRecordSize = std::max(mRecordSize, seriesEnd(offset + 12, 1)); // TT - TDB
+        }
+    }
+
+    // Header, constants, then the data records
+    size_t const recordBytes = mRecordSize * sizeof(double);
+    mRecordCount = mFile.Size() / recordBytes >= 2 ? mFile.Size() / recordBytes - 2 : 0;
+    if (mRecordCount == 0 || mRecordSpan <= 0.0 ||
+        ReadHeader<double>(data, 2 * recordBytes) != mStartDate)
+    {
+        throw std::runtime_error(path + " has no data records where the header says they are");
+    }
+    mEndDate = std::min(mEndDate, mStartDate + static_cast<double>(mRecordCount) * mRecordSpan);
+}
+
+//======================================================================================================================
+
+Kepler::StateVector Ephemeris::Barycentric(Body const body, double const julianDate)
+{
+    switch (body)
+    {
+    case Body::EARTH:
+    case Body::MOON:
+    {
+        // The file has the Earth-Moon barycenter and the geocentric Moon, the mass ratio splits them
+        Kepler::StateVector const barycenter = Evaluate(EARTH_MOON_SERIES, julianDate);
+        Kepler::StateVector const moon = Evaluate(GEOCENTRIC_MOON_SERIES, julianDate);
+        double const share = body == Body::EARTH
+            ? -1.0 / (1.0 + mEarthMoonMassRatio)
+            : mEarthMoonMassRatio / (1.0 + mEarthMoonMassRatio);
+        return Kepler::StateVector{
+            barycenter.position + share * moon.position,
+            barycenter.velocity + share * moon.velocity
+        };
+    }
+
+    case Body::EARTH_MOON_BARYCENTER:
+        return Evaluate(EARTH_MOON_SERIES, julianDate);
+
+    case Body::SUN:
+        return Evaluate(SUN_SERIES, julianDate);
+
+    case Body::COUNT:
+        break;
+
+    default:
+        // Mercury to Pluto are numbered the same in both enums
+        return Evaluate(static_cast<Series>(body), julianDate);
+    }
+    throw std::invalid_argument("Ephemeris: invalid body");
+}
+
+//======================================================================================================================
+
+Kepler::StateVector Ephemeris::Relative(Body const body, Body const center, double const julianDate)
+{
+    if (body == Body::MOON && center == Body::EARTH)
+    {
+        // Stored directly, and far more precise than the difference of two barycentric vectors
+        return Evaluate(GEOCENTRIC_MOON_SERIES, julianDate);
+    }
+    Kepler::StateVector const target = Barycentric(body, julianDate);
+    Kepler::StateVector const origin = Barycentric(center, julianDate);
+    return Kepler::StateVector{target.position - origin.position, target.velocity - origin.velocity};
+}
+
+//======================================================================================================================
+
+glm::dvec3 Ephemeris::EquatorialToEcliptic(glm::dvec3 const & equatorial)
+{
+    static double const cosine = std::cos(ObliquityJ2000);
+    static double const sine = std::sin(ObliquityJ2000);
+    return glm::dvec3{
+        equatorial.x,
+        cosine * equatorial.y + sine * equatorial.z,
+        -sine * equatorial.y + cosine * equatorial.z
+    };
+}
+
+//======================================================================================================================
+
+Kepler::StateVector Ephemeris::Evaluate(Series const series, double const julianDate)
+{
+    Cursor & cursor = mCursors[series];
+    if (julianDate < cursor.recordStart || julianDate > cursor.recordEnd)
+    {
+        if (julianDate < mStartDate || julianDate > mEndDate)
+        {
+            throw std::out_of_range("Ephemeris: date outside of the file's range");
+        }
+        size_t const index = std::min(static_cast<size_t>((julianDate - mStartDate) / mRecordSpan), mRecordCount - 1);
+        auto const * records = reinterpret_cast<double const *>(mFile.Data());
+        cursor.record = records + (index + 2) * mRecordSize;
+        cursor.recordStart = cursor.record[0];
+        cursor.recordEnd = cursor.record[1];
+    }
+
+    // Each record is split into equal subintervals with their own coefficients, mapped to [-1, 1]
+    SeriesLayout const & layout = mLayout[series];
+    double const subintervalSpan = mRecordSpan / layout.subintervalCount;
+    double const sinceStart = julianDate - cursor.recordStart;
+    uint32_t const subinterval = std::min(static_cast<uint32_t>(sinceStart / subintervalSpan), layout.subintervalCount - 1);
+    double const t = 2.0 * (sinceStart - subinterval * subintervalSpan) / subintervalSpan - 1.0;
+
+    // T_n and its derivative, shared by all three components
+    uint32_t const n = layout.coefficientCount;
+    double polynomial[MaxCoefficients];
+    double derivative[MaxCoefficients];
+    polynomial[0] = 1.0;
+    polynomial[1] = t;
+    derivative[0] = 0.0;
+    derivative[1] = 1.0;
+    for (uint32_t k = 2; k < n; ++k)
+    {
+        polynomial[k] = 2.0 * t * polynomial[k - 1] - polynomial[k - 2];
+        derivative[k] = 2.0 * t * derivative[k - 1] + 2.0 * polynomial[k - 1] - derivative[k - 2];
+    }
+
+    // Offsets in the file count from 1
+    double const * coefficients = cursor.record + (layout.offset - 1) + static_cast<size_t>(subinterval) * 3 * n;
+    double const velocityScale = 2.0 / subintervalSpan; // dt/d(julianDate)
+
+    Kepler::StateVector state{};
+    for (int component = 0; component < 3; ++component)
+    {
+        double position = 0.0;
+        double velocity = 0.0;
+        for (uint32_t k = 0; k < n; ++k)
+        {
+            position += coefficients[k] * polynomial[k];
+            velocity += coefficients[k] * derivative[k];
+        }
+        state.position[component] = position;
+        state.velocity[component] = velocity * velocityScale;
+        coefficients += n;
+    }
+    return state;
+}
+
+//======================================================================================================================
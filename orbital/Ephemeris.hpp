@@ -0,0 +1,125 @@
+#pragma once
+
+#include "Kepler.hpp"
+#include "MappedFile.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Planetary positions from a JPL DE binary ephemeris (DE405, DE430, DE440, ...).
+//
+// The file is memory mapped and only the header is looked at when it is opened. It is a sequence of
+// fixed size records, each covering the same span of days with a set of Chebyshev coefficients per
+// body, so the record for a date is found with a division and evaluated in place. Every body keeps
+// the record it used last, which makes a run of nearby queries skip even that.
+//
+// Only the classic binary layout written by JPL's asc2eph in the native (little endian) byte order is
+// understood, not the SPICE .bsp kernels.
+class Ephemeris
+{
+public:
+
+    enum class Body
+    {
+        MERCURY,
+        VENUS,
+        EARTH,
+        MARS,
+        JUPITER,
+        SATURN,
+        URANUS,
+        NEPTUNE,
+        PLUTO,
+        MOON,
+        SUN,
+        EARTH_MOON_BARYCENTER,
+        COUNT
+    };
+
+    // Julian date of 2000-01-01 12:00 TDB
+    inline static constexpr double J2000 = 2451545.0;
+
+    // Mean obliquity of the ecliptic at J2000 (IAU 2006), the tilt between the ephemeris frame and the ecliptic
+    inline static constexpr double ObliquityJ2000 = 0.40909260059599012; // 84381.406 arcseconds
+
+    // Throws std::runtime_error for files that can't be mapped or don't look like a DE ephemeris
+    explicit Ephemeris(std::string const & path);
+
+    // Position (km) and velocity (km/day) relative to the solar system barycenter, in the ICRF
+    // (equatorial) frame. julianDate is TDB and must be within [StartDate, EndDate], std::out_of_range otherwise.
+    [[nodiscard]]
+    Kepler::StateVector Barycentric(Body body, double julianDate);
+
+    // Same as Barycentric, relative to the given center (e.g. Body::SUN for heliocentric, Body::EARTH for geocentric)
+    [[nodiscard]]
+    Kepler::StateVector Relative(Body body, Body center, double julianDate);
+
+    // Rotates a vector from the equatorial frame of the ephemeris to the J2000 ecliptic, where the planets orbit close to xy
+    [[nodiscard]]
+    static glm::dvec3 EquatorialToEcliptic(glm::dvec3 const & equatorial);
+
+    [[nodiscard]]
+    int Version() const { return mVersion; }
+
+    [[nodiscard]]
+    double StartDate() const { return mStartDate; }
+
+    [[nodiscard]]
+    double EndDate() const { return mEndDate; }
+
+    // Astronomical unit in km as used by the file
+    [[nodiscard]]
+    double AstronomicalUnit() const { return mAstronomicalUnit; }
+
+private:
+
+    // Chebyshev series as numbered in the file (the Earth is derived from the barycenter and the Moon)
+    enum Series
+    {
+        MERCURY_SERIES,
+        VENUS_SERIES,
+        EARTH_MOON_SERIES,
+        MARS_SERIES,
+        JUPITER_SERIES,
+        SATURN_SERIES,
+        URANUS_SERIES,
+        NEPTUNE_SERIES,
+        PLUTO_SERIES,
+        GEOCENTRIC_MOON_SERIES,
+        SUN_SERIES,
+        SERIES_COUNT
+    };
+
+    struct SeriesLayout
+    {
+        uint32_t offset = 0;         // first coefficient, in doubles from the start of a record
+        uint32_t coefficientCount = 0;
+        uint32_t subintervalCount = 0;
+    };
+
+    // Where a series was evaluated last
+    struct Cursor
+    {
+        double recordStart = 0.0;
+        double recordEnd = -1.0;    // empty until the first query
+        double const * record = nullptr;
+    };
+
+    [[nodiscard]]
+    Kepler::StateVector Evaluate(Series series, double julianDate);
+
+    MappedFile mFile;
+
+    int mVersion = 0;
+    double mStartDate = 0.0;
+    double mEndDate = 0.0;
+    double mRecordSpan = 0.0;       // days per record
+    double mAstronomicalUnit = 0.0;
+    double mEarthMoonMassRatio = 0.0;
+    size_t mRecordSize = 0;         // doubles per record
+    size_t mRecordCount = 0;
+
+    std::array<SeriesLayout, SERIES_COUNT> mLayout{};
+    std::array<Cursor, SERIES_COUNT> mCursors{};
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+// Inputs and outputs shared by the force solvers (Barnes-Hut, direct summation)
+namespace Gravity
+{
+    // Read-only view of the bodies, all arrays have count entries
+    struct Bodies
+    {
+        double const * x = nullptr;
+        double const * y = nullptr;
+        double const * z = nullptr;
+        double const * mass = nullptr;
+        size_t count = 0;
+    };
+
+    // Per-body outputs, potential is per unit mass
+    struct Forces
+    {
+        double * ax = nullptr;
+        double * ay = nullptr;
+        double * az = nullptr;
+        double * potential = nullptr;
+    };
+}
@@ -0,0 +1,279 @@
+#include "Kepler.hpp"
+
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+namespace Kepler
+{
+
+    //==================================================================================================================
+
+    static constexpr int MaxIterations = 32;
+    static constexpr double Tolerance = 1.0e-15;
+
+    //==================================================================================================================
+
+    static StateVector ToReferenceFrame(PerifocalBasis const & basis, glm::dvec2 const & position, glm::dvec2 const & velocity)
+    {
+        return StateVector{
+            basis.p * position.x + basis.q * position.y,
+            basis.p * velocity.x + basis.q * velocity.y
+        };
+    }
+
+    //==================================================================================================================
+
+    // Stumpff functions C(z) and S(z), with a series expansion around zero where the closed forms cancel out
+    static void Stumpff(double const z, double & c, double & s)
+    {
+        if (std::abs(z) < 1.0e-3)
+        {
+            c = 1.0 / 2.0 - z * (1.0 / 24.0 - z * (1.0 / 720.0 - z / 40320.0));
+            s = 1.0 / 6.0 - z * (1.0 / 120.0 - z * (1.0 / 5040.0 - z / 362880.0));
+        }
+        else if (z > 0.0)
+        {
+            double const sqrtZ = std::sqrt(z);
+            c = (1.0 - std::cos(sqrtZ)) / z;
+            s = (sqrtZ - std::sin(sqrtZ)) / (z * sqrtZ);
+        }
+        else
+        {
+            double const sqrtZ = std::sqrt(-z);
+            c = (std::cosh(sqrtZ) - 1.0) / -z;
+            s = (std::sinh(sqrtZ) - sqrtZ) / (-z * sqrtZ);
+        }
+    }
+
+    //==================================================================================================================
+
+    OrbitalElements FromMeanMotion(
+        double const semiMajorAxis,
+        double const eccentricity,
+        double const meanMotion,
+        double const inclination,
+        double const longitudeOfAscendingNode,
+        double const argumentOfPeriapsis,
+        double const meanAnomalyAtEpoch,
+        double const epoch
+    )
+    {
+        double const absA = std::abs(semiMajorAxis);
+
+        OrbitalElements elements{};
+        elements.periapsisDistance = semiMajorAxis * (1.0 - eccentricity);
+        elements.eccentricity = eccentricity;
+        elements.inclination = inclination;
+        elements.longitudeOfAscendingNode = longitudeOfAscendingNode;
+        elements.argumentOfPeriapsis = argumentOfPeriapsis;
+        elements.periapsisTime = epoch - meanAnomalyAtEpoch / meanMotion;
+        elements.gravitationalParameter = meanMotion * meanMotion * absA * absA * absA; // Kepler's third law
+        return elements;
+    }
+
+    //==================================================================================================================
+
+    double SemiMajorAxis(OrbitalElements const & elements)
+    {
+        return elements.periapsisDistance / (1.0 - elements.eccentricity);
+    }
+
+    //==================================================================================================================
+
+    double MeanMotion(OrbitalElements const & elements)
+    {
+        if (elements.eccentricity == 1.0)
+        {
+            return 0.0;
+        }
+        double const absA = std::abs(SemiMajorAxis(elements));
+        return std::sqrt(elements.gravitationalParameter / (absA * absA * absA));
+    }
+
+    //==================================================================================================================
+
+    PerifocalBasis Basis(OrbitalElements const & elements)
+    {
+        double const cosO = std::cos(elements.longitudeOfAscendingNode);
+        double const sinO = std::sin(elements.longitudeOfAscendingNode);
+        double const cosW = std::cos(elements.argumentOfPeriapsis);
+        double const sinW = std::sin(elements.argumentOfPeriapsis);
+        double const cosI = std::cos(elements.inclination);
+        double const sinI = std::sin(elements.inclination);
+
+        PerifocalBasis basis{};
+        basis.p = glm::dvec3{cosO * cosW - sinO * sinW * cosI, sinO * cosW + cosO * sinW * cosI, sinW * sinI};
+        basis.q = glm::dvec3{-cosO * sinW - sinO * cosW * cosI, -sinO * sinW + cosO * cosW * cosI, cosW * sinI};
+        return basis;
+    }
+
+    //==================================================================================================================
+
+    double SolveEccentricAnomaly(double const meanAnomaly, double const eccentricity)
+    {
+        // Wrap into [-pi, pi] so the starter and the iteration count don't depend on how long we've been running
+        double const twoPi = glm::two_pi<double>();
+        double const m = meanAnomaly - twoPi * std::floor(meanAnomaly / twoPi + 0.5);
+
+        // Danby's starter converges for every e < 1
+        double anomaly = m + 0.85 * eccentricity * (std::sin(m) < 0.0 ? -1.0 : 1.0);
+
+        for (int i = 0; i < MaxIterations; ++i)
+        {
+            double const eSin = eccentricity * std::sin(anomaly);
+            double const eCos = eccentricity * std::cos(anomaly);
+            double const f = anomaly - eSin - m;
+            double const df = 1.0 - eCos;
+            double const delta = f / (df - 0.5 * f * eSin / df); // Halley step
+            anomaly -= delta;
+            if (std::abs(delta) <= Tolerance * (1.0 + std::abs(anomaly)))
+            {
+                break;
+            }
+        }
+
+        // Add back the whole revolutions we removed
+        return anomaly + (meanAnomaly - m);
+    }
+
+    //==================================================================================================================
+
+    double SolveHyperbolicAnomaly(double const meanAnomaly, double const eccentricity)
+    {
+        double const sign = meanAnomaly < 0.0 ? -1.0 : 1.0;
+        double anomaly = sign * std::log(2.0 * std::abs(meanAnomaly) / eccentricity + 1.8);
+
+        for (int i = 0; i < MaxIterations; ++i)
+        {
+            double const eSinh = eccentricity * std::sinh(anomaly);
+            double const eCosh = eccentricity * std::cosh(anomaly);
+            double const f = eSinh - anomaly - meanAnomaly;
+            double const df = eCosh - 1.0;
+            double const delta = f / (df - 0.5 * f * eSinh / df);
+            anomaly -= delta;
+            if (std::abs(delta) <= Tolerance * (1.0 + std::abs(anomaly)))
+            {
+                break;
+            }
+        }
+        return anomaly;
+    }
+
+    //==================================================================================================================
+
+    // Universal variable propagation starting from periapsis, where the radial velocity is zero.
+    // Well conditioned for every eccentricity, used where the anomaly based solvers lose precision.
+    static StateVector PropagateUniversal(OrbitalElements const & elements, double dt)
+    {
+        double const mu = elements.gravitationalParameter;
+        double const sqrtMu = std::sqrt(mu);
+        double const q = elements.periapsisDistance;
+        double const e = elements.eccentricity;
+        double const alpha = (1.0 - e) / q; // reciprocal of the semi-major axis
+
+        // Closed orbits repeat, keep the solver within a single revolution of periapsis
+        if (alpha > 0.0)
+        {
+            double const period = glm::two_pi<double>() / std::sqrt(mu * alpha * alpha * alpha);
+            dt -= period * std::floor(dt / period + 0.5);
+        }
+
+        double const target = sqrtMu * dt;
+
+        // Barker's equation (the exact parabolic answer) is an excellent starting point near e == 1
+        double chi = 0.0;
+        {
+            double const halfB = -3.0 * target;
+            double const root = std::sqrt(halfB * halfB + 8.0 * q * q * q);
+            chi = std::cbrt(-halfB + root) + std::cbrt(-halfB - root);
+        }
+
+        // Laguerre-Conway iterations, robust even from a poor guess
+        double c = 0.5;
+        double s = 1.0 / 6.0;
+        for (int i = 0; i < MaxIterations; ++i)
+        {
+            double const z = alpha * chi * chi;
+            Stumpff(z, c, s);
+
+            double const f = e * chi * chi * chi * s + q * chi - target;
+            double const df = e * chi * chi * c + q;
+            double const ddf = e * chi * (1.0 - z * s);
+
+            constexpr double n = 5.0;
+            double const radicand = std::abs((n - 1.0) * (n - 1.0) * df * df - n * (n - 1.0) * f * ddf);
+            double const delta = n * f / (df + (df < 0.0 ? -1.0 : 1.0) * std::sqrt(radicand));
+            chi -= delta;
+            if (std::abs(delta) <= Tolerance * (1.0 + std::abs(chi)))
+            {
+                break;
+            }
+        }
+
+        double const z = alpha * chi * chi;
+        Stumpff(z, c, s);
+        double const r = e * chi * chi * c + q;
+
+        double const chi2c = chi * chi * c;
+        double const lagrangeF = 1.0 - chi2c / q;
+        double const lagrangeG = dt - chi * chi * chi * s / sqrtMu;
+        double const lagrangeFDot = sqrtMu / (r * q) * chi * (z * s - 1.0);
+        double const lagrangeGDot = 1.0 - chi2c / r;
+
+        double const periapsisSpeed = std::sqrt(mu * (1.0 + e) / q);
+        glm::dvec2 const position{lagrangeF * q, lagrangeG * periapsisSpeed};
+        glm::dvec2 const velocity{lagrangeFDot * q, lagrangeGDot * periapsisSpeed};
+
+        return ToReferenceFrame(Basis(elements), position, velocity);
+    }
+
+    //==================================================================================================================
+
+    StateVector Propagate(OrbitalElements const & elements, double const time)
+    {
+        double const dt = time - elements.periapsisTime;
+        double const e = elements.eccentricity;
+
+        if (std::abs(e - 1.0) < NearParabolicTolerance)
+        {
+            return PropagateUniversal(elements, dt);
+        }
+
+        double const a = SemiMajorAxis(elements);
+        double const n = MeanMotion(elements);
+        double const meanAnomaly = n * dt;
+
+        glm::dvec2 position{};
+        glm::dvec2 velocity{};
+
+        if (e < 1.0)
+        {
+            double const anomaly = SolveEccentricAnomaly(meanAnomaly, e);
+            double const cosE = std::cos(anomaly);
+            double const sinE = std::sin(anomaly);
+            double const b = a * std::sqrt(1.0 - e * e);
+            double const anomalyRate = n / (1.0 - e * cosE);
+
+            position = glm::dvec2{a * (cosE - e), b * sinE};
+            velocity = glm::dvec2{-a * sinE * anomalyRate, b * cosE * anomalyRate};
+        }
+        else
+        {
+            double const anomaly = SolveHyperbolicAnomaly(meanAnomaly, e);
+            double const coshH = std::cosh(anomaly);
+            double const sinhH = std::sinh(anomaly);
+            double const absA = -a;
+            double const b = absA * std::sqrt(e * e - 1.0);
+            double const anomalyRate = n / (e * coshH - 1.0);
+
+            position = glm::dvec2{absA * (e - coshH), b * sinhH};
+            velocity = glm::dvec2{-absA * sinhH * anomalyRate, b * coshH * anomalyRate};
+        }
+
+        return ToReferenceFrame(Basis(elements), position, velocity);
+    }
+
+    //==================================================================================================================
+
+}
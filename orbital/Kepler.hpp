@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Closed-form two-body propagation.
+//
+// Positions are evaluated directly from the orbital elements and an absolute time, so sampling any
+// moment costs the same and nothing accumulates from one frame to the next. Elliptic and hyperbolic
+// orbits go through Kepler's equation (Halley iterations), near-parabolic ones through the universal
+// variable formulation.
+//
+// The reference frame is the usual right-handed one: the orbit plane of an uninclined body is xy and
+// +z is the orbit normal.
+namespace Kepler
+{
+    // Eccentricities closer than this to 1 use the universal variable solver
+    inline static constexpr double NearParabolicTolerance = 1.0e-2;
+
+    // The periapsis distance is stored instead of the semi-major axis so that parabolic orbits
+    // (e == 1, infinite semi-major axis) can be represented as well.
+    struct OrbitalElements
+    {
+        double periapsisDistance = 1.0;        // q
+        double eccentricity = 0.0;             // e
+        double inclination = 0.0;              // i (radians)
+        double longitudeOfAscendingNode = 0.0; // Omega (radians)
+        double argumentOfPeriapsis = 0.0;      // omega (radians)
+        double periapsisTime = 0.0;            // time of periapsis passage
+        double gravitationalParameter = 1.0;   // mu of the parent body
+    };
+
+    struct StateVector
+    {
+        glm::dvec3 position{};
+        glm::dvec3 velocity{};
+    };
+
+    // Unit vectors of the orbit plane: P points at periapsis, Q is 90 degrees ahead in the direction of motion
+    struct PerifocalBasis
+    {
+        glm::dvec3 p{};
+        glm::dvec3 q{};
+    };
+
+    // Builds elements from the way orbits are usually tabulated: semi-major axis, mean motion and the
+    // mean anomaly at a given epoch. Valid for elliptic (a > 0) and hyperbolic (a < 0) orbits.
+    [[nodiscard]]
+    OrbitalElements FromMeanMotion(
+        double semiMajorAxis,
+        double eccentricity,
+        double meanMotion,
+        double inclination,
+        double longitudeOfAscendingNode,
+        double argumentOfPeriapsis,
+        double meanAnomalyAtEpoch,
+        double epoch
+    );
+
+    [[nodiscard]]
+    double SemiMajorAxis(OrbitalElements const & elements);
+
+    // Radians per unit time, zero for parabolic orbits
+    [[nodiscard]]
+    double MeanMotion(OrbitalElements const & elements);
+
+    [[nodiscard]]
+    PerifocalBasis Basis(OrbitalElements const & elements);
+
+    // Solves M = E - e sin(E) for E, e < 1
+    [[nodiscard]]
+    double SolveEccentricAnomaly(double meanAnomaly, double eccentricity);
+
+    // Solves M = e sinh(H) - H for H, e > 1
+    [[nodiscard]]
+    double SolveHyperbolicAnomaly(double meanAnomaly, double eccentricity);
+
+    // Position and velocity relative to the parent body at the given absolute time
+    [[nodiscard]]
+    StateVector Propagate(OrbitalElements const & elements, double time);
+}
@@ -0,0 +1,168 @@
+#include "KeplerBatch.hpp"
+
+#include "AlignedAllocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+//======================================================================================================================
+
+namespace
+{
+    std::atomic<KeplerBatch::InstructionSet> & SelectedSet()
+    {
+        static std::atomic<KeplerBatch::InstructionSet> selected{CpuFeatures::Detect()};
+        return selected;
+    }
+
+    // Reference path, also what non-x86 builds run
+    void PropagateScalar(KeplerBatch::Columns const & columns, double const time)
+    {
+        double const twoPi = 6.28318530717958647693;
+        for (size_t i = 0; i < columns.count; ++i)
+        {
+            double const e = columns.eccentricity[i];
+            double const meanAnomaly = columns.meanMotion[i] * (time - columns.periapsisTime[i]);
+            double const m = meanAnomaly - twoPi * std::nearbyint(meanAnomaly / twoPi);
+
+            double anomaly = m + 0.85 * e * std::copysign(1.0, m);
+            for (int iteration = 0; iteration < KeplerBatch::FixedIterations; ++iteration)
+            {
+                double const eSin = e * std::sin(anomaly);
+                double const df = 1.0 - e * std::cos(anomaly);
+                double const f = anomaly - eSin - m;
+                anomaly -= f / (df - 0.5 * f * eSin / df);
+            }
+
+            double const x = columns.semiMajorAxis[i] * (std::cos(anomaly) - e);
+            double const y = columns.semiMinorAxis[i] * std::sin(anomaly);
+            columns.x[i] = x * columns.px[i] + y * columns.qx[i];
+            columns.y[i] = x * columns.py[i] + y * columns.qy[i];
+            columns.z[i] = x * columns.pz[i] + y * columns.qz[i];
+        }
+    }
+
+    // Owns a set of columns for the benchmark
+    struct SampleColumns
+    {
+        explicit SampleColumns(size_t const count)
+        {
+            size_t const padded = (count + KeplerBatch::LaneCount - 1) / KeplerBatch::LaneCount * KeplerBatch::LaneCount;
+            for (AlignedVector<double> * column : {&a, &b, &e, &n, &tp, &px, &py, &pz, &qx, &qy, &qz, &x, &y, &z})
+            {
+                column->resize(padded, 0.0);
+            }
+
+            // Deterministic spread over the whole batched range: e in [0, 0.99), every phase and orientation
+            double const twoPi = 6.28318530717958647693;
+            for (size_t i = 0; i < count; ++i)
+            {
+                double const t = (static_cast<double>(i) + 0.5) / static_cast<double>(count);
+                double const inclination = std::fmod(i * 0.618033988749895, 1.0) * 3.14159265358979323846;
+                double const node = std::fmod(i * 0.754877666246693, 1.0) * twoPi;
+                double const argument = std::fmod(i * 0.569840290998053, 1.0) * twoPi;
+
+                e[i] = std::min(std::fmod(i * 0.381966011250105, 1.0), 0.989);
+                a[i] = 0.5 + 30.0 * t;
+                b[i] = a[i] * std::sqrt(1.0 - e[i] * e[i]);
+                n[i] = 1.0 / std::sqrt(a[i] * a[i] * a[i]);
+                tp[i] = std::fmod(i * 0.7548776662, 1.0) * 100.0 - 50.0;
+
+                double const cn = std::cos(node), sn = std::sin(node);
+                double const ci = std::cos(inclination), si = std::sin(inclination);
+                double const cw = std::cos(argument), sw = std::sin(argument);
+                px[i] = cn * cw - sn * sw * ci;
+                py[i] = sn * cw + cn * sw * ci;
+                pz[i] = sw * si;
+                qx[i] = -cn * sw - sn * cw * ci;
+                qy[i] = -sn * sw + cn * cw * ci;
+                qz[i] = cw * si;
+            }
+        }
+
+        [[nodiscard]]
+        KeplerBatch::Columns View()
+        {
+            return KeplerBatch::Columns{
+                a.data(), b.data(), e.data(), n.data(), tp.data(),
+                px.data(), py.data(), pz.data(), qx.data(), qy.data(), qz.data(),
+                x.data(), y.data(), z.data(), x.size()
+            };
+        }
+
+        AlignedVector<double> a, b, e, n, tp, px, py, pz, qx, qy, qz, x, y, z;
+    };
+}
+
+//======================================================================================================================
+
+void KeplerBatch::Propagate(Columns const & columns, double const time)
+{
+    Propagate(columns, time, Selected());
+}
+
+//======================================================================================================================
+
+void KeplerBatch::Select(InstructionSet const instructionSet)
+{
+    SelectedSet().store(std::min(instructionSet, CpuFeatures::Detect()), std::memory_order_relaxed);
+}
+
+//======================================================================================================================
+
+KeplerBatch::InstructionSet KeplerBatch::Selected()
+{
+    return SelectedSet().load(std::memory_order_relaxed);
+}
+
+//======================================================================================================================
+
+void KeplerBatch::Propagate(Columns const & columns, double const time, InstructionSet const instructionSet)
+{
+    switch (instructionSet)
+    {
+#if defined(ORBITAL_X86_SIMD)
+    case InstructionSet::AVX2:
+        Detail::PropagateAVX2(columns, time);
+        return;
+    case InstructionSet::SSE42:
+        Detail::PropagateSSE42(columns, time);
+        return;
+#endif
+    default:
+        PropagateScalar(columns, time);
+        return;
+    }
+}
+
+//======================================================================================================================
+
+double KeplerBatch::Benchmark(InstructionSet const instructionSet, size_t const bodyCount)
+{
+    if (CpuFeatures::IsSupported(instructionSet) == false || bodyCount == 0)
+    {
+        return 0.0;
+    }
+
+    SampleColumns sample{bodyCount};
+    Columns const columns = sample.View();
+
+    // Best of a few runs of roughly 10M body updates each, the first one also warms the caches
+    size_t const repeats = std::max<size_t>(1, 10'000'000 / bodyCount);
+    double bestSeconds = 0.0;
+    for (int run = 0; run < 3; ++run)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < repeats; ++i)
+        {
+            Propagate(columns, static_cast<double>(i), instructionSet);
+        }
+        double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        bestSeconds = run == 0 ? seconds : std::min(bestSeconds, seconds);
+    }
+    return static_cast<double>(bodyCount * repeats) / std::max(bestSeconds, 1e-9);
+}
+
+//======================================================================================================================
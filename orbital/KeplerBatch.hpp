@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CpuFeatures.hpp"
+
+#include <cstddef>
+
+// Batched elliptic Kepler solver.
+//
+// Works on structure-of-arrays columns, eight bodies per step, with a fixed number of Halley iterations
+// so every lane does the same work and there is nothing to branch on. The instruction set is picked at
+// runtime: AVX2+FMA, then SSE4.2, then plain scalar code.
+namespace KeplerBatch
+{
+    // Bodies handled per step, every column must be padded to a multiple of it
+    inline constexpr size_t LaneCount = 8;
+
+    // Enough to reach double precision from Danby's starter for every e < 0.99
+    inline constexpr int FixedIterations = 5;
+
+    using InstructionSet = CpuFeatures::InstructionSet;
+
+    // Inputs are the usual elements plus the perifocal basis (P, Q) and the semi-minor axis,
+    // outputs are positions relative to the parent
+    struct Columns
+    {
+        double const * semiMajorAxis = nullptr;
+        double const * semiMinorAxis = nullptr;
+        double const * eccentricity = nullptr;
+        double const * meanMotion = nullptr;
+        double const * periapsisTime = nullptr;
+        double const * px = nullptr;
+        double const * py = nullptr;
+        double const * pz = nullptr;
+        double const * qx = nullptr;
+        double const * qy = nullptr;
+        double const * qz = nullptr;
+        double * x = nullptr;
+        double * y = nullptr;
+        double * z = nullptr;
+        size_t count = 0; // multiple of LaneCount
+    };
+
+    // Uses the selected instruction set
+    void Propagate(Columns const & columns, double time);
+
+    void Propagate(Columns const & columns, double time, InstructionSet instructionSet);
+
+    // Instruction set the two-argument Propagate runs, the best supported one until Select is called.
+    // Requests the CPU can't run are clamped to what it can, so Select(Scalar) always sticks.
+    void Select(InstructionSet instructionSet);
+
+    [[nodiscard]]
+    InstructionSet Selected();
+
+    // Bodies per second for a table of the given size
+    [[nodiscard]]
+    double Benchmark(InstructionSet instructionSet, size_t bodyCount);
+
+    namespace Detail
+    {
+        // One per instruction set, each compiled in its own translation unit with matching flags (x86 only)
+        void PropagateAVX2(Columns const & columns, double time);
+        void PropagateSSE42(Columns const & columns, double time);
+    }
+}
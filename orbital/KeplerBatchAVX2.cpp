@@ -0,0 +1,48 @@
+// Compiled with AVX2 + FMA enabled, only ever called after CpuFeatures::Detect has checked for them
+#include "KeplerBatch.hpp"
+
+#include <immintrin.h>
+
+namespace
+{
+    struct Ops
+    {
+        using Vec = __m256d;
+        using Mask = __m256d;
+
+        static constexpr size_t Width = 4;
+
+        static Vec Load(double const * pointer) { return _mm256_loadu_pd(pointer); }
+        static void Store(double * pointer, Vec const value) { _mm256_storeu_pd(pointer, value); }
+        static Vec Set(double const value) { return _mm256_set1_pd(value); }
+
+        static Vec Add(Vec const a, Vec const b) { return _mm256_add_pd(a, b); }
+        static Vec Sub(Vec const a, Vec const b) { return _mm256_sub_pd(a, b); }
+        static Vec Mul(Vec const a, Vec const b) { return _mm256_mul_pd(a, b); }
+        static Vec Div(Vec const a, Vec const b) { return _mm256_div_pd(a, b); }
+        static Vec MulAdd(Vec const a, Vec const b, Vec const c) { return _mm256_fmadd_pd(a, b, c); }
+        static Vec Negate(Vec const a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+
+        static Vec Round(Vec const a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static Vec Floor(Vec const a) { return _mm256_floor_pd(a); }
+
+        static Mask Equal(Vec const a, Vec const b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+        static Mask Less(Vec const a, Vec const b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+        static Mask GreaterEqual(Vec const a, Vec const b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+        static Mask Or(Mask const a, Mask const b) { return _mm256_or_pd(a, b); }
+
+        // mask ? a : b
+        static Vec Select(Mask const mask, Vec const a, Vec const b) { return _mm256_blendv_pd(b, a, mask); }
+    };
+}
+
+#include "KeplerBatchKernel.inl"
+
+//======================================================================================================================
+
+void KeplerBatch::Detail::PropagateAVX2(Columns const & columns, double const time)
+{
+    PropagateColumns(columns, time);
+}
+
+//======================================================================================================================
@@ -0,0 +1,97 @@
+// Shared body of the SIMD Kepler kernels. Included by one translation unit per instruction set, each of
+// which defines an `Ops` struct wrapping its intrinsics before including this file. Nothing here may use
+// the standard library: inline functions from it would be compiled with the wider instruction set and
+// could end up being picked by the linker for the scalar path too.
+
+namespace
+{
+    // Cody-Waite split of pi/2, the first part has enough trailing zeros to be multiplied exactly
+    constexpr double PiOver2Hi = 1.57079632673412561417e+00;
+    constexpr double PiOver2Lo = 6.07710050650619224932e-11;
+    constexpr double TwoOverPi = 6.36619772367581382433e-01;
+    constexpr double TwoPi = 6.28318530717958647693e+00;
+    constexpr double InvTwoPi = 1.59154943091895335769e-01;
+
+    // sin and cos of the same argument, minimax polynomials on [-pi/4, pi/4] (Cephes coefficients)
+    inline void SinCos(Ops::Vec const x, Ops::Vec & sinOut, Ops::Vec & cosOut)
+    {
+        Ops::Vec const quadrant = Ops::Round(Ops::Mul(x, Ops::Set(TwoOverPi)));
+        Ops::Vec r = Ops::Sub(x, Ops::Mul(quadrant, Ops::Set(PiOver2Hi)));
+        r = Ops::Sub(r, Ops::Mul(quadrant, Ops::Set(PiOver2Lo)));
+        Ops::Vec const r2 = Ops::Mul(r, r);
+
+        Ops::Vec s = Ops::Set(1.58962301576546568060e-10);
+        s = Ops::MulAdd(s, r2, Ops::Set(-2.50507477628578072866e-8));
+        s = Ops::MulAdd(s, r2, Ops::Set(2.75573136213857245213e-6));
+        s = Ops::MulAdd(s, r2, Ops::Set(-1.98412698295895385996e-4));
+        s = Ops::MulAdd(s, r2, Ops::Set(8.33333333332211858878e-3));
+        s = Ops::MulAdd(s, r2, Ops::Set(-1.66666666666666307295e-1));
+        s = Ops::MulAdd(Ops::Mul(s, r2), r, r);
+
+        Ops::Vec c = Ops::Set(-1.13585365213876817300e-11);
+        c = Ops::MulAdd(c, r2, Ops::Set(2.08757008419747316778e-9));
+        c = Ops::MulAdd(c, r2, Ops::Set(-2.75573141792967388112e-7));
+        c = Ops::MulAdd(c, r2, Ops::Set(2.48015872888517045348e-5));
+        c = Ops::MulAdd(c, r2, Ops::Set(-1.38888888888730564116e-3));
+        c = Ops::MulAdd(c, r2, Ops::Set(4.16666666666665929218e-2));
+        c = Ops::Add(Ops::Mul(c, Ops::Mul(r2, r2)), Ops::Sub(Ops::Set(1.0), Ops::Mul(r2, Ops::Set(0.5))));
+
+        // Quadrant (0..3) picks which polynomial and which sign each output gets
+        Ops::Vec const q = Ops::Sub(quadrant, Ops::Mul(Ops::Floor(Ops::Mul(quadrant, Ops::Set(0.25))), Ops::Set(4.0)));
+        Ops::Mask const odd = Ops::Or(Ops::Equal(q, Ops::Set(1.0)), Ops::Equal(q, Ops::Set(3.0)));
+        Ops::Mask const sinNegative = Ops::GreaterEqual(q, Ops::Set(2.0));
+        Ops::Mask const cosNegative = Ops::Or(Ops::Equal(q, Ops::Set(1.0)), Ops::Equal(q, Ops::Set(2.0)));
+
+        Ops::Vec const sinValue = Ops::Select(odd, c, s);
+        Ops::Vec const cosValue = Ops::Select(odd, s, c);
+        sinOut = Ops::Select(sinNegative, Ops::Negate(sinValue), sinValue);
+        cosOut = Ops::Select(cosNegative, Ops::Negate(cosValue), cosValue);
+    }
+
+    inline void PropagateVector(KeplerBatch::Columns const & columns, size_t const i, Ops::Vec const time)
+    {
+        Ops::Vec const e = Ops::Load(columns.eccentricity + i);
+        Ops::Vec const meanAnomaly = Ops::Mul(Ops::Load(columns.meanMotion + i), Ops::Sub(time, Ops::Load(columns.periapsisTime + i)));
+
+        // Wrap into [-pi, pi]
+        Ops::Vec const m = Ops::Sub(meanAnomaly, Ops::Mul(Ops::Round(Ops::Mul(meanAnomaly, Ops::Set(InvTwoPi))), Ops::Set(TwoPi)));
+
+        // Danby's starter, sin(m) has the sign of m on [-pi, pi]
+        Ops::Vec const sign = Ops::Select(Ops::Less(m, Ops::Set(0.0)), Ops::Set(-1.0), Ops::Set(1.0));
+        Ops::Vec anomaly = Ops::MulAdd(Ops::Mul(Ops::Set(0.85), e), sign, m);
+
+        Ops::Vec sinE{};
+        Ops::Vec cosE{};
+        for (int iteration = 0; iteration < KeplerBatch::FixedIterations; ++iteration)
+        {
+            SinCos(anomaly, sinE, cosE);
+            Ops::Vec const eSin = Ops::Mul(e, sinE);
+            Ops::Vec const f = Ops::Sub(Ops::Sub(anomaly, eSin), m);
+            Ops::Vec const df = Ops::Sub(Ops::Set(1.0), Ops::Mul(e, cosE));
+            Ops::Vec const halley = Ops::Sub(df, Ops::Div(Ops::Mul(Ops::Mul(Ops::Set(0.5), f), eSin), df));
+            anomaly = Ops::Sub(anomaly, Ops::Div(f, halley));
+        }
+        SinCos(anomaly, sinE, cosE);
+
+        Ops::Vec const x = Ops::Mul(Ops::Load(columns.semiMajorAxis + i), Ops::Sub(cosE, e));
+        Ops::Vec const y = Ops::Mul(Ops::Load(columns.semiMinorAxis + i), sinE);
+
+        Ops::Store(columns.x + i, Ops::MulAdd(x, Ops::Load(columns.px + i), Ops::Mul(y, Ops::Load(columns.qx + i))));
+        Ops::Store(columns.y + i, Ops::MulAdd(x, Ops::Load(columns.py + i), Ops::Mul(y, Ops::Load(columns.qy + i))));
+        Ops::Store(columns.z + i, Ops::MulAdd(x, Ops::Load(columns.pz + i), Ops::Mul(y, Ops::Load(columns.qz + i))));
+    }
+
+    inline void PropagateColumns(KeplerBatch::Columns const & columns, double const time)
+    {
+        Ops::Vec const timeVec = Ops::Set(time);
+
+        // LaneCount bodies per step, unrolled over as many vectors as it takes to cover them
+        for (size_t i = 0; i < columns.count; i += KeplerBatch::LaneCount)
+        {
+            for (size_t lane = 0; lane < KeplerBatch::LaneCount; lane += Ops::Width)
+            {
+                PropagateVector(columns, i + lane, timeVec);
+            }
+        }
+    }
+}
@@ -0,0 +1,48 @@
+// Compiled with SSE4.2 enabled, only ever called after CpuFeatures::Detect has checked for it
+#include "KeplerBatch.hpp"
+
+#include <nmmintrin.h>
+
+namespace
+{
+    struct Ops
+    {
+        using Vec = __m128d;
+        using Mask = __m128d;
+
+        static constexpr size_t Width = 2;
+
+        static Vec Load(double const * pointer) { return _mm_loadu_pd(pointer); }
+        static void Store(double * pointer, Vec const value) { _mm_storeu_pd(pointer, value); }
+        static Vec Set(double const value) { return _mm_set1_pd(value); }
+
+        static Vec Add(Vec const a, Vec const b) { return _mm_add_pd(a, b); }
+        static Vec Sub(Vec const a, Vec const b) { return _mm_sub_pd(a, b); }
+        static Vec Mul(Vec const a, Vec const b) { return _mm_mul_pd(a, b); }
+        static Vec Div(Vec const a, Vec const b) { return _mm_div_pd(a, b); }
+        static Vec MulAdd(Vec const a, Vec const b, Vec const c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+        static Vec Negate(Vec const a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+
+        static Vec Round(Vec const a) { return _mm_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static Vec Floor(Vec const a) { return _mm_floor_pd(a); }
+
+        static Mask Equal(Vec const a, Vec const b) { return _mm_cmpeq_pd(a, b); }
+        static Mask Less(Vec const a, Vec const b) { return _mm_cmplt_pd(a, b); }
+        static Mask GreaterEqual(Vec const a, Vec const b) { return _mm_cmpge_pd(a, b); }
+        static Mask Or(Mask const a, Mask const b) { return _mm_or_pd(a, b); }
+
+        // mask ? a : b
+        static Vec Select(Mask const mask, Vec const a, Vec const b) { return _mm_blendv_pd(b, a, mask); }
+    };
+}
+
+#include "KeplerBatchKernel.inl"
+
+//======================================================================================================================
+
+void KeplerBatch::Detail::PropagateSSE42(Columns const & columns, double const time)
+{
+    PropagateColumns(columns, time);
+}
+
+//======================================================================================================================
@@ -0,0 +1,150 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//======================================================================================================================
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(std::string const & path)
+{
+    HANDLE const file = CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    mFile = file;
+
+    LARGE_INTEGER size{};
+    if (GetFileSizeEx(file, &size) == FALSE || size.QuadPart == 0)
+    {
+        Unmap();
+        throw std::runtime_error("Failed to map " + path + " (empty or unreadable)");
+    }
+    mSize = static_cast<size_t>(size.QuadPart);
+
+    mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mMapping == nullptr)
+    {
+        Unmap();
+        throw std::runtime_error("Failed to map " + path);
+    }
+    mData = static_cast<std::byte const *>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if (mData == nullptr)
+    {
+        Unmap();
+        throw std::runtime_error("Failed to map " + path);
+    }
+}
+
+//======================================================================================================================
+
+void MappedFile::Unmap()
+{
+    if (mData != nullptr)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping != nullptr)
+    {
+        CloseHandle(mMapping);
+    }
+    if (mFile != nullptr)
+    {
+        CloseHandle(mFile);
+    }
+    mData = nullptr;
+    mMapping = nullptr;
+    mFile = nullptr;
+    mSize = 0;
+}
+
+#else
+
+MappedFile::MappedFile(std::string const & path)
+{
+    int const file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    struct stat status{};
+    if (fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        close(file);
+        throw std::runtime_error("Failed to map " + path + " (empty or unreadable)");
+    }
+
+    // The mapping keeps its own reference to the file, the descriptor isn't needed afterwards
+    void * const data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map " + path);
+    }
+    mData = static_cast<std::byte const *>(data);
+    mSize = static_cast<size_t>(status.st_size);
+}
+
+//======================================================================================================================
+
+void MappedFile::Unmap()
+{
+    if (mData != nullptr)
+    {
+        munmap(const_cast<std::byte *>(mData), mSize);
+    }
+    mData = nullptr;
+    mSize = 0;
+}
+
+#endif
+
+//======================================================================================================================
+
+MappedFile::~MappedFile()
+{
+    Unmap();
+}
+
+//======================================================================================================================
+
+MappedFile::MappedFile(MappedFile && other) noexcept
+{
+    *this = std::move(other);
+}
+
+//======================================================================================================================
+
+MappedFile & MappedFile::operator=(MappedFile && other) noexcept
+{
+    if (this != &other)
+    {
+        Unmap();
+        std::swap(mData, other.mData);
+        std::swap(mSize, other.mSize);
+#if defined(_WIN32)
+        std::swap(mFile, other.mFile);
+        std::swap(mMapping, other.mMapping);
+#endif
+    }
+    return *this;
+}
+
+//======================================================================================================================
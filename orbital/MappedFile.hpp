@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file through the virtual memory system.
+//
+// Nothing is read when the file is opened, the OS pages data in the first time it is touched and can
+// drop it again under memory pressure. The mapping stays valid until the object is destroyed.
+class MappedFile
+{
+public:
+
+    // Throws std::runtime_error when the file can't be opened or mapped
+    explicit MappedFile(std::string const & path);
+    ~MappedFile();
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile & operator=(MappedFile const &) = delete;
+    MappedFile(MappedFile && other) noexcept;
+    MappedFile & operator=(MappedFile && other) noexcept;
+
+    [[nodiscard]]
+    std::byte const * Data() const { return mData; }
+
+    [[nodiscard]]
+    size_t Size() const { return mSize; }
+
+private:
+
+    void Unmap();
+
+    std::byte const * mData = nullptr;
+    size_t mSize = 0;
+
+#if defined(_WIN32)
+    void * mFile = nullptr;    // HANDLE
+    void * mMapping = nullptr; // HANDLE
+#endif
+};
@@ -0,0 +1,330 @@
+#include "MinorPlanetCatalog.hpp"
+
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// Fields as [first, last) byte columns of a line
+struct Field
+{
+    size_t begin, end;
+};
+static constexpr Field MagnitudeField{8, 13};
+static constexpr Field EpochField{20, 25};
+static constexpr Field MeanAnomalyField{26, 35};
+static constexpr Field PeriapsisField{37, 46};
+static constexpr Field NodeField{48, 57};
+static constexpr Field InclinationField{59, 68};
+static constexpr Field EccentricityField{70, 79};
+static constexpr Field MeanMotionField{80, 91};
+static constexpr Field SemiMajorAxisField{92, 103};
+
+// Shorter lines can't hold all of the fields above
+static constexpr size_t MinLineLength = SemiMajorAxisField.end;
+
+// Enough chunks per thread that an uneven split doesn't leave anyone idle for long
+static constexpr size_t ChunksPerThread = 4;
+
+static constexpr double DegreesToRadians = 0.017453292519943295;
+
+//======================================================================================================================
+
+// Plain decimal with optional sign and padding spaces, which is all the catalog uses. Digits go into an
+// integer and get divided by an exact power of ten once, so the result is correctly rounded for up to
+// 15 significant digits. Returns false for blank or malformed fields.
+static bool ParseFixed(char const * text, size_t const length, double & value)
+{
+    static constexpr double PowersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+    };
+
+    char const * p = text;
+    char const * const end = text + length;
+    while (p < end && *p == ' ')
+    {
+        ++p;
+    }
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int fractionDigits = 0;
+    bool fraction = false;
+    for (; p < end && *p != ' '; ++p)
+    {
+        if (*p == '.' && fraction == false)
+        {
+            fraction = true;
+            continue;
+        }
+        unsigned const digit = static_cast<unsigned>(*p - '0');
+        if (digit > 9 || digits == 18)
+        {
+            return false;
+        }
+        mantissa = mantissa * 10 + digit;
+        ++digits;
+        fractionDigits += fraction ? 1 : 0;
+    }
+    for (; p < end; ++p)
+    {
+        if (*p != ' ')
+        {
+            return false;
+        }
+    }
+    if (digits == 0)
+    {
+        return false;
+    }
+
+    value = static_cast<double>(mantissa) / PowersOfTen[fractionDigits];
+    value = negative ? -value : value;
+    return true;
+}
+
+//======================================================================================================================
+
+// 1-9 then A-V, used for months and days in packed dates
+static int UnpackDigit(char const c)
+{
+    if (c >= '1' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'V')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+//======================================================================================================================
+
+// Packed epoch (e.g. K24AH = 2024-10-17) to the Julian date at 0h
+static bool ParseEpoch(char const * text, double & julianDate)
+{
+    if (text[0] < 'I' || text[0] > 'L' || text[1] < '0' || text[1] > '9' || text[2] < '0' || text[2] > '9')
+    {
+        return false;
+    }
+    int const year = (text[0] - 'I' + 18) * 100 + (text[1] - '0') * 10 + (text[2] - '0');
+    int const month = UnpackDigit(text[3]);
+    int const day = UnpackDigit(text[4]);
+    if (month < 1 || month > 12 || day < 1 || day > 31)
+    {
+        return false;
+    }
+
+    // Fliegel & Van Flandern, gives the day number at noon
+    int const a = (month - 14) / 12;
+    long const dayNumber = (1461L * (year + 4800 + a)) / 4 + (367L * (month - 2 - 12 * a)) / 12 -
+        (3L * ((year + 4900 + a) / 100)) / 4 + day - 32075;
+    julianDate = static_cast<double>(dayNumber) - 0.5;
+    return true;
+}
+
+//======================================================================================================================
+
+MinorPlanetCatalog MinorPlanetCatalog::Load(std::string const & path, ThreadPool & pool)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    MappedFile const file(path);
+    char const * const begin = reinterpret_cast<char const *>(file.Data());
+    char const * const end = begin + file.Size();
+
+    // The header ends with a line of dashes, files cut down to just the orbits have none
+    char const * dataBegin = begin;
+    for (char const * line = begin; line < end && line - begin < 64 * 1024;)
+    {
+        char const * const lineEnd = static_cast<char const *>(std::memchr(line, '\n', end - line));
+        if (lineEnd == nullptr)
+        {
+            break;
+        }
+        if (lineEnd - line >= 5 && std::memcmp(line, "-----", 5) == 0)
+        {
+            dataBegin = lineEnd + 1;
+            break;
+        }
+        line = lineEnd + 1;
+    }
+
+    // Cut points are nudged forward to the next line start, so no line is split
+    size_t const dataSize = static_cast<size_t>(end - dataBegin);
+    size_t const chunkCount = std::max<size_t>(1, std::min(pool.ThreadCount() * ChunksPerThread, dataSize / (1 << 20)));
+    std::vector<char const *> cuts(chunkCount + 1, end);
+    cuts[0] = dataBegin;
+    for (size_t i = 1; i < chunkCount; ++i)
+    {
+        char const * cut = std::max(cuts[i - 1], dataBegin + dataSize / chunkCount * i);
+        char const * const newline = static_cast<char const *>(std::memchr(cut, '\n', end - cut));
+        cuts[i] = newline == nullptr ? end : newline + 1;
+    }
+
+    // First pass: lines per chunk, which tells every chunk where its first row goes
+    std::vector<size_t> firstRow(chunkCount + 1, 0);
+    pool.ParallelFor(chunkCount, [&](size_t const chunk) -> void
+    {
+        size_t lines = 0;
+        for (char const * p = cuts[chunk]; p < cuts[chunk + 1]; ++lines)
+        {
+            char const * const newline = static_cast<char const *>(std::memchr(p, '\n', cuts[chunk + 1] - p));
+            p = newline == nullptr ? cuts[chunk + 1] : newline + 1;
+        }
+        firstRow[chunk + 1] = lines;
+    });
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        firstRow[i + 1] += firstRow[i];
+    }
+
+    // Second pass: parse in place, rejected lines leave a gap at the end of their chunk's rows
+    MinorPlanetCatalog catalog{};
+    catalog.Resize(firstRow[chunkCount]);
+    std::vector<size_t> parsedRows(chunkCount, 0);
+    pool.ParallelFor(chunkCount, [&](size_t const chunk) -> void
+    {
+        size_t row = firstRow[chunk];
+        for (char const * line = cuts[chunk]; line < cuts[chunk + 1];)
+        {
+            char const * newline = static_cast<char const *>(std::memchr(line, '\n', cuts[chunk + 1] - line));
+            char const * const next = newline == nullptr ? cuts[chunk + 1] : newline + 1;
+            if (catalog.ParseLine(line, newline == nullptr ? cuts[chunk + 1] : newline, row))
+            {
+                ++row;
+            }
+            line = next;
+        }
+        parsedRows[chunk] = row - firstRow[chunk];
+    });
+
+    size_t size = 0;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        catalog.MoveRows(size, firstRow[i], parsedRows[i]);
+        size += parsedRows[i];
+    }
+    catalog.mRejectedLines = firstRow[chunkCount] - size;
+    catalog.Resize(size);
+    if (size == 0)
+    {
+        throw std::runtime_error(path + " has no orbits in MPCORB format");
+    }
+
+    catalog.mLoadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return catalog;
+}
+
+//======================================================================================================================
+
+MinorPlanetCatalog::Orbit MinorPlanetCatalog::Get(size_t const index) const
+{
+    Orbit orbit{};
+    orbit.semiMajorAxis = mSemiMajorAxis[index];
+    orbit.eccentricity = mEccentricity[index];
+    orbit.inclination = mInclination[index];
+    orbit.longitudeOfAscendingNode = mLongitudeOfAscendingNode[index];
+    orbit.argumentOfPeriapsis = mArgumentOfPeriapsis[index];
+    orbit.meanAnomaly = mMeanAnomaly[index];
+    orbit.meanMotion = mMeanMotion[index];
+    orbit.epoch = mEpoch[index];
+    orbit.absoluteMagnitude = mAbsoluteMagnitude[index];
+    return orbit;
+}
+
+//======================================================================================================================
+
+bool MinorPlanetCatalog::ParseLine(char const * const line, char const * end, size_t const row)
+{
+    if (end > line && end[-1] == '\r')
+    {
+        --end;
+    }
+    if (static_cast<size_t>(end - line) < MinLineLength)
+    {
+        return false;
+    }
+
+    auto const parse = [line](Field const field, double & value) -> bool
+    {
+        return ParseFixed(line + field.begin, field.end - field.begin, value);
+    };
+
+    double semiMajorAxis, eccentricity, inclination, node, periapsis, meanAnomaly, meanMotion, epoch;
+    bool const valid = parse(SemiMajorAxisField, semiMajorAxis) &&
+        parse(EccentricityField, eccentricity) &&
+        parse(InclinationField, inclination) &&
+        parse(NodeField, node) &&
+        parse(PeriapsisField, periapsis) &&
+        parse(MeanAnomalyField, meanAnomaly) &&
+        parse(MeanMotionField, meanMotion) &&
+        ParseEpoch(line + EpochField.begin, epoch);
+    if (valid == false || semiMajorAxis <= 0.0 || eccentricity < 0.0 || eccentricity >= 1.0)
+    {
+        return false;
+    }
+
+    // Plenty of faint objects have no magnitude yet
+    double magnitude = 0.0;
+    bool const hasMagnitude = parse(MagnitudeField, magnitude);
+
+    mSemiMajorAxis[row] = semiMajorAxis;
+    mEccentricity[row] = eccentricity;
+    mInclination[row] = inclination * DegreesToRadians;
+    mLongitudeOfAscendingNode[row] = node * DegreesToRadians;
+    mArgumentOfPeriapsis[row] = periapsis * DegreesToRadians;
+    mMeanAnomaly[row] = meanAnomaly * DegreesToRadians;
+    mMeanMotion[row] = meanMotion * DegreesToRadians;
+    mEpoch[row] = epoch;
+    mAbsoluteMagnitude[row] = hasMagnitude ? static_cast<float>(magnitude) : std::numeric_limits<float>::quiet_NaN();
+    return true;
+}
+
+//======================================================================================================================
+
+void MinorPlanetCatalog::Resize(size_t const size)
+{
+    for (AlignedVector<double> * column : {
+        &mSemiMajorAxis, &mEccentricity, &mInclination, &mLongitudeOfAscendingNode,
+        &mArgumentOfPeriapsis, &mMeanAnomaly, &mMeanMotion, &mEpoch
+    })
+    {
+        column->resize(size);
+    }
+    mAbsoluteMagnitude.resize(size);
+}
+
+//======================================================================================================================
+
+void MinorPlanetCatalog::MoveRows(size_t const destination, size_t const source, size_t const count)
+{
+    if (destination == source || count == 0)
+    {
+        return;
+    }
+    for (AlignedVector<double> * column : {
+        &mSemiMajorAxis, &mEccentricity, &mInclination, &mLongitudeOfAscendingNode,
+        &mArgumentOfPeriapsis, &mMeanAnomaly, &mMeanMotion, &mEpoch
+    })
+    {
+        std::copy_n(column->begin() + source, count, column->begin() + destination);
+    }
+    std::copy_n(mAbsoluteMagnitude.begin() + source, count, mAbsoluteMagnitude.begin() + destination);
+}
+
+//======================================================================================================================
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "ThreadPool.hpp"
+
+#include <string>
+
+// Orbits of the numbered and unnumbered minor planets, read from the Minor Planet Center's MPCORB.DAT.
+//
+// The file is fixed-width text, one orbit per line. It is memory mapped and cut into line aligned
+// chunks that are parsed in parallel: one pass counts the lines of every chunk so each one knows
+// where its rows go, the second parses straight into the columns. Lines that don't parse (blank
+// separators, truncated records) are dropped and squeezed out at the end.
+//
+// Elements are heliocentric, J2000 ecliptic, osculating at each orbit's own epoch.
+class MinorPlanetCatalog
+{
+public:
+
+    struct Orbit
+    {
+        double semiMajorAxis = 0.0;            // AU
+        double eccentricity = 0.0;
+        double inclination = 0.0;              // radians
+        double longitudeOfAscendingNode = 0.0; // radians
+        double argumentOfPeriapsis = 0.0;      // radians
+        double meanAnomaly = 0.0;              // radians, at the epoch
+        double meanMotion = 0.0;               // radians per day
+        double epoch = 0.0;                    // Julian date (TT)
+        float absoluteMagnitude = 0.0f;        // H, NaN when the catalog has none
+    };
+
+    // Throws std::runtime_error when the file can't be mapped or has no orbits in it
+    [[nodiscard]]
+    static MinorPlanetCatalog Load(std::string const & path, ThreadPool & pool);
+
+    [[nodiscard]]
+    size_t Size() const { return mSemiMajorAxis.size(); }
+
+    [[nodiscard]]
+    Orbit Get(size_t index) const;
+
+    // Lines after the header that weren't orbits
+    [[nodiscard]]
+    size_t RejectedLines() const { return mRejectedLines; }
+
+    // Wall time of the last Load, mapping included
+    [[nodiscard]]
+    double LoadSeconds() const { return mLoadSeconds; }
+
+    [[nodiscard]] double const * SemiMajorAxis() const { return mSemiMajorAxis.data(); }
+    [[nodiscard]] double const * Eccentricity() const { return mEccentricity.data(); }
+
+private:
+
+    // Parses one line into row, false if it isn't an orbit
+    bool ParseLine(char const * line, char const * end, size_t row);
+
+    void Resize(size_t size);
+
+    // Moves count rows from source down to destination (destination <= source)
+    void MoveRows(size_t destination, size_t source, size_t count);
+
+    AlignedVector<double> mSemiMajorAxis{};
+    AlignedVector<double> mEccentricity{};
+    AlignedVector<double> mInclination{};
+    AlignedVector<double> mLongitudeOfAscendingNode{};
+    AlignedVector<double> mArgumentOfPeriapsis{};
+    AlignedVector<double> mMeanAnomaly{};
+    AlignedVector<double> mMeanMotion{};
+    AlignedVector<double> mEpoch{};
+    AlignedVector<float> mAbsoluteMagnitude{};
+
+    size_t mRejectedLines = 0;
+    double mLoadSeconds = 0.0;
+};
@@ -0,0 +1,172 @@
+#include "NBodySystem.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+//======================================================================================================================
+
+NBodySystem::NBodySystem(std::shared_ptr<ThreadPool> pool)
+    : mPool(std::move(pool))
+{
+}
+
+//======================================================================================================================
+
+void NBodySystem::Reserve(size_t const count)
+{
+    for (AlignedVector<double> * column : {&mX, &mY, &mZ, &mVx, &mVy, &mVz, &mAx, &mAy, &mAz, &mPotential, &mMass})
+    {
+        column->reserve(count);
+    }
+}
+
+//======================================================================================================================
+
+void NBodySystem::Clear()
+{
+    for (AlignedVector<double> * column : {&mX, &mY, &mZ, &mVx, &mVy, &mVz, &mAx, &mAy, &mAz, &mPotential, &mMass})
+    {
+        column->clear();
+    }
+    mForcesValid = false;
+    mEnergy = 0.0;
+    mInitialEnergy = 0.0;
+}
+
+//======================================================================================================================
+
+size_t NBodySystem::Add(glm::dvec3 const & position, glm::dvec3 const & velocity, double const mass)
+{
+    mX.push_back(position.x);
+    mY.push_back(position.y);
+    mZ.push_back(position.z);
+    mVx.push_back(velocity.x);
+    mVy.push_back(velocity.y);
+    mVz.push_back(velocity.z);
+    mAx.push_back(0.0);
+    mAy.push_back(0.0);
+    mAz.push_back(0.0);
+    mPotential.push_back(0.0);
+    mMass.push_back(mass);
+    mForcesValid = false;
+    return mMass.size() - 1;
+}
+
+//======================================================================================================================
+
+size_t NBodySystem::AddCentralSystem(
+    double const centralMass,
+    std::vector<Kepler::OrbitalElements> const & orbits,
+    std::vector<double> const & masses,
+    double const time
+)
+{
+    assert(orbits.size() == masses.size());
+
+    std::vector<Kepler::StateVector> states(orbits.size());
+    glm::dvec3 momentum{0.0};
+    for (size_t i = 0; i < orbits.size(); ++i)
+    {
+        assert(std::abs(orbits[i].gravitationalParameter - mSettings.gravitationalConstant * centralMass) <=
+            1e-9 * orbits[i].gravitationalParameter);
+        states[i] = Kepler::Propagate(orbits[i], time);
+        momentum += masses[i] * states[i].velocity;
+    }
+
+    Reserve(Size() + 1 + orbits.size());
+    size_t const centralIndex = Add(glm::dvec3{0.0}, -momentum / centralMass, centralMass);
+    for (size_t i = 0; i < orbits.size(); ++i)
+    {
+        Add(states[i].position, states[i].velocity, masses[i]);
+    }
+    return centralIndex;
+}
+
+//======================================================================================================================
+
+void NBodySystem::Step(double const deltaTime)
+{
+    // The first step needs accelerations at the starting positions, which also fixes the reference energy
+    if (mForcesValid == false)
+    {
+        ComputeForces();
+        UpdateEnergy();
+        mInitialEnergy = mEnergy;
+        mForcesValid = true;
+    }
+
+    size_t const count = Size();
+    double const halfStep = 0.5 * deltaTime;
+
+    // Kick + drift
+    for (size_t i = 0; i < count; ++i)
+    {
+        mVx[i] += halfStep * mAx[i];
+        mVy[i] += halfStep * mAy[i];
+        mVz[i] += halfStep * mAz[i];
+        mX[i] += deltaTime * mVx[i];
+        mY[i] += deltaTime * mVy[i];
+        mZ[i] += deltaTime * mVz[i];
+    }
+
+    ComputeForces();
+
+    // Kick, velocities are back in sync with positions
+    for (size_t i = 0; i < count; ++i)
+    {
+        mVx[i] += halfStep * mAx[i];
+        mVy[i] += halfStep * mAy[i];
+        mVz[i] += halfStep * mAz[i];
+    }
+
+    UpdateEnergy();
+}
+
+//======================================================================================================================
+
+double NBodySystem::EnergyDrift() const
+{
+    if (mInitialEnergy == 0.0)
+    {
+        return 0.0;
+    }
+    return (mEnergy - mInitialEnergy) / std::abs(mInitialEnergy);
+}
+
+//======================================================================================================================
+
+void NBodySystem::ComputeForces()
+{
+    Gravity::Bodies const bodies{mX.data(), mY.data(), mZ.data(), mMass.data(), Size()};
+    Gravity::Forces const forces{mAx.data(), mAy.data(), mAz.data(), mPotential.data()};
+
+    switch (mSettings.solver)
+    {
+    case ForceSolver::BARNES_HUT:
+        mTree.Build(bodies, mSettings.openingAngle, *mPool);
+        mTree.Evaluate(bodies, mSettings.gravitationalConstant, mSettings.softening, forces, *mPool);
+        break;
+
+    case ForceSolver::DIRECT:
+        mDirect.Evaluate(bodies, mSettings.gravitationalConstant, mSettings.softening, forces, *mPool);
+        break;
+    }
+}
+
+//======================================================================================================================
+
+void NBodySystem::UpdateEnergy()
+{
+    // Every pair shows up in both bodies' potentials, hence the half
+    double kinetic = 0.0;
+    double potential = 0.0;
+    for (size_t i = 0; i < Size(); ++i)
+    {
+        kinetic += 0.5 * mMass[i] * (mVx[i] * mVx[i] + mVy[i] * mVy[i] + mVz[i] * mVz[i]);
+        potential += 0.5 * mMass[i] * mPotential[i];
+    }
+    mEnergy = kinetic + potential;
+}
+
+//======================================================================================================================
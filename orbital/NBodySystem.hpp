@@ -0,0 +1,107 @@
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "BarnesHut.hpp"
+#include "DirectSummation.hpp"
+#include "Kepler.hpp"
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+// Bodies that all attract each other, integrated with kick-drift-kick leapfrog.
+//
+// Leapfrog is symplectic, so with a fixed step the energy error stays bounded instead of growing, and
+// the drift readout is a direct measure of how good the step size and force approximation are.
+class NBodySystem
+{
+public:
+
+    enum class ForceSolver
+    {
+        BARNES_HUT, // O(N log N), approximate
+        DIRECT      // O(N^2), exact, only sensible up to DirectSummation::MaxBodies
+    };
+
+    struct Settings
+    {
+        double gravitationalConstant = 1.0;
+        double softening = 1e-3;    // keeps close encounters finite
+        double openingAngle = 0.5;  // Barnes-Hut theta
+        ForceSolver solver = ForceSolver::BARNES_HUT;
+    };
+
+    explicit NBodySystem(std::shared_ptr<ThreadPool> pool = ThreadPool::Instance());
+
+    void Reserve(size_t count);
+
+    void Clear();
+
+    // Returns the body's index, which never changes until Clear
+    size_t Add(glm::dvec3 const & position, glm::dvec3 const & velocity, double mass);
+
+    // Adds a central body at the origin and one body per orbit, placed where its elements put it at
+    // time. Each orbit must have been built with G * centralMass as its gravitational parameter or the
+    // seeded speeds don't match the force the system applies. The central body gets the opposite of
+    // the others' momentum so the system doesn't drift. Returns the central body's index, orbit i
+    // lands right after it at index + 1 + i.
+    size_t AddCentralSystem(
+        double centralMass,
+        std::vector<Kepler::OrbitalElements> const & orbits,
+        std::vector<double> const & masses,
+        double time
+    );
+
+    // Advances every body by one fixed step
+    void Step(double deltaTime);
+
+    [[nodiscard]]
+    size_t Size() const { return mMass.size(); }
+
+    [[nodiscard]]
+    glm::dvec3 Position(size_t index) const { return glm::dvec3{mX[index], mY[index], mZ[index]}; }
+
+    [[nodiscard]]
+    glm::dvec3 Velocity(size_t index) const { return glm::dvec3{mVx[index], mVy[index], mVz[index]}; }
+
+    [[nodiscard]] double const * X() const { return mX.data(); }
+    [[nodiscard]] double const * Y() const { return mY.data(); }
+    [[nodiscard]] double const * Z() const { return mZ.data(); }
+
+    [[nodiscard]]
+    Settings & GetSettings() { return mSettings; }
+
+    // Kinetic + potential energy as of the last step (or the initial state)
+    [[nodiscard]]
+    double TotalEnergy() const { return mEnergy; }
+
+    // (E - E0) / |E0| since the first force evaluation after the last Add
+    [[nodiscard]]
+    double EnergyDrift() const;
+
+    [[nodiscard]]
+    size_t TreeNodeCount() const { return mTree.NodeCount(); }
+
+private:
+
+    void ComputeForces();
+
+    void UpdateEnergy();
+
+    std::shared_ptr<ThreadPool> mPool{};
+    Settings mSettings{};
+    BarnesHut mTree{};
+    DirectSummation mDirect{};
+
+    AlignedVector<double> mX{}, mY{}, mZ{};
+    AlignedVector<double> mVx{}, mVy{}, mVz{};
+    AlignedVector<double> mAx{}, mAy{}, mAz{};
+    AlignedVector<double> mPotential{};
+    AlignedVector<double> mMass{};
+
+    bool mForcesValid = false;
+    double mEnergy = 0.0;
+    double mInitialEnergy = 0.0;
+};
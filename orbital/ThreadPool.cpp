@@ -0,0 +1,128 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+//======================================================================================================================
+
+std::shared_ptr<ThreadPool> ThreadPool::Instance()
+{
+    std::shared_ptr<ThreadPool> sharedPtr = _instance.lock();
+    if (sharedPtr == nullptr)
+    {
+        sharedPtr = std::make_shared<ThreadPool>();
+        _instance = sharedPtr;
+    }
+    return sharedPtr;
+}
+
+//======================================================================================================================
+
+ThreadPool::ThreadPool(size_t const threadCount)
+{
+    // hardware_concurrency may report 0 when it can't tell
+    size_t const workerCount = std::max<size_t>(threadCount, 1) - 1;
+    mWorkers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        mWorkers.emplace_back([this, i]() -> void { WorkerLoop(i); });
+    }
+}
+
+//======================================================================================================================
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_all();
+    for (std::thread & worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+//======================================================================================================================
+
+void ThreadPool::ParallelFor(size_t const taskCount, std::function<void(size_t)> const & task, size_t const maxThreads)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> loopLock(mLoopMutex);
+
+    size_t const threads = maxThreads == 0 ? ThreadCount() : std::min(maxThreads, ThreadCount());
+    size_t const participants = std::min(threads, taskCount) - 1;
+    if (participants == 0)
+    {
+        for (size_t i = 0; i < taskCount; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &task;
+        mTaskCount = taskCount;
+        mNextTask.store(0, std::memory_order_relaxed);
+        mParticipants = participants;
+        mBusyWorkers = participants;
+        ++mGeneration;
+    }
+    mWake.notify_all();
+
+    RunTasks();
+
+    // Workers may still be finishing the last tasks they grabbed
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this]() -> bool { return mBusyWorkers == 0; });
+    mTask = nullptr;
+}
+
+//======================================================================================================================
+
+void ThreadPool::WorkerLoop(size_t const workerIndex)
+{
+    size_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [&]() -> bool
+            {
+                return mStopping || (mGeneration != seenGeneration && workerIndex < mParticipants);
+            });
+            if (mStopping)
+            {
+                return;
+            }
+            seenGeneration = mGeneration;
+        }
+
+        RunTasks();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (--mBusyWorkers == 0)
+        {
+            mDone.notify_one();
+        }
+    }
+}
+
+//======================================================================================================================
+
+void ThreadPool::RunTasks()
+{
+    for (size_t i = mNextTask.fetch_add(1, std::memory_order_relaxed); i < mTaskCount;
+         i = mNextTask.fetch_add(1, std::memory_order_relaxed))
+    {
+        (*mTask)(i);
+    }
+}
+
+//======================================================================================================================
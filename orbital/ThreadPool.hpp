@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data parallel loops.
+//
+// One loop runs at a time. The calling thread takes part in it, so a pool of N threads keeps N cores
+// busy and ParallelFor never returns before every task has finished.
+class ThreadPool
+{
+public:
+
+    // Shared pool sized to the machine
+    static std::shared_ptr<ThreadPool> Instance();
+
+    // threadCount includes the calling thread
+    explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool & operator=(ThreadPool const &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+    ThreadPool & operator=(ThreadPool &&) = delete;
+
+    [[nodiscard]]
+    size_t ThreadCount() const { return mWorkers.size() + 1; }
+
+    // Calls task(i) for every i in [0, taskCount), spread over at most maxThreads threads (0 = all)
+    void ParallelFor(size_t taskCount, std::function<void(size_t)> const & task, size_t maxThreads = 0);
+
+private:
+
+    void WorkerLoop(size_t workerIndex);
+
+    void RunTasks();
+
+    inline static std::weak_ptr<ThreadPool> _instance{};
+
+    std::vector<std::thread> mWorkers{};
+
+    std::mutex mLoopMutex{}; // one ParallelFor at a time
+
+    std::mutex mMutex{};
+    std::condition_variable mWake{};
+    std::condition_variable mDone{};
+    size_t mGeneration = 0;
+    size_t mParticipants = 0; // workers allowed into the current loop
+    size_t mBusyWorkers = 0;
+    bool mStopping = false;
+
+    std::function<void(size_t)> const * mTask = nullptr;
+    size_t mTaskCount = 0;
+    std::atomic<size_t> mNextTask{0};
+};
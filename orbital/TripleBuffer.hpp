@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands whole values from one writer thread to one reader thread without locks or waiting.
+//
+// Three slots: the writer fills one, the reader holds one, and the third is the most recently
+// published value. Publishing and picking up are a single atomic exchange with that middle slot, so
+// neither side ever blocks the other and the reader always gets the newest complete value. Values
+// the reader never picked up are simply overwritten.
+//
+// A slot handed back to the writer holds an old value, the writer must fill in every field.
+template <typename T>
+class TripleBuffer
+{
+public:
+
+    // Writer side, the slot being filled
+    [[nodiscard]]
+    T & WriteBuffer() { return mSlots[mWriteIndex].value; }
+
+    // Writer side, makes the write buffer the latest value and starts on another slot
+    void Publish()
+    {
+        uint8_t const middle = mMiddle.exchange(mWriteIndex | FreshBit, std::memory_order_acq_rel);
+        mWriteIndex = middle & IndexMask;
+    }
+
+    // Reader side, switches to the latest value if there is a newer one than the current. True if it did.
+    bool Acquire()
+    {
+        if ((mMiddle.load(std::memory_order_relaxed) & FreshBit) == 0)
+        {
+            return false;
+        }
+        uint8_t const middle = mMiddle.exchange(mReadIndex, std::memory_order_acq_rel);
+        mReadIndex = middle & IndexMask;
+        return true;
+    }
+
+    // Reader side, stays valid and unchanged until the next Acquire
+    [[nodiscard]]
+    T const & ReadBuffer() const { return mSlots[mReadIndex].value; }
+
+private:
+
+    static constexpr uint8_t IndexMask = 0x3;
+    static constexpr uint8_t FreshBit = 0x4; // set while the middle slot hasn't been picked up
+
+    // Own cache lines, so the two threads don't fight over them
+    struct alignas(64) Slot
+    {
+        T value{};
+    };
+
+    std::array<Slot, 3> mSlots{};
+    uint8_t mWriteIndex = 0;
+    alignas(64) uint8_t mReadIndex = 1;
+    alignas(64) std::atomic<uint8_t> mMiddle{2};
+};
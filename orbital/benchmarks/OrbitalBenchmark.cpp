@@ -0,0 +1,43 @@
+// Throughput of the orbital kernels on this machine. Kept out of the app so nothing else competes
+// for the cores and the render loop never stalls on a measurement.
+
+#include "DirectSummation.hpp"
+#include "KeplerBatch.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstdio>
+#include <initializer_list>
+
+//======================================================================================================================
+
+int main()
+{
+    using InstructionSet = CpuFeatures::InstructionSet;
+
+    std::printf("Kepler solver, 100k bodies (selected: %s)\n", CpuFeatures::Name(KeplerBatch::Selected()));
+    for (InstructionSet const instructionSet : {InstructionSet::Scalar, InstructionSet::SSE42, InstructionSet::AVX2})
+    {
+        if (CpuFeatures::IsSupported(instructionSet) == false)
+        {
+            std::printf("  %s: not supported\n", CpuFeatures::Name(instructionSet));
+            continue;
+        }
+        double const bodiesPerSecond = KeplerBatch::Benchmark(instructionSet, 100'000);
+        std::printf("  %s: %.1f M bodies/s\n", CpuFeatures::Name(instructionSet), bodiesPerSecond * 1e-6);
+    }
+
+    // Direct summation at 1, 2, 4, ... threads, on a pool nothing else is using
+    ThreadPool pool{};
+    std::printf("Direct summation, 16k bodies (%s)\n", CpuFeatures::IsSupported(InstructionSet::AVX2) ? "AVX2" : "scalar");
+    for (DirectSummation::BenchmarkResult const & result : DirectSummation::Benchmark(16'384, pool))
+    {
+        std::printf(
+            "  %zu thread(s): %.1f GFLOP/s, %.0f M interactions/s\n",
+            result.threads, result.gflops, result.interactionsPerSecond * 1e-6
+        );
+    }
+
+    return 0;
+}
+
+//======================================================================================================================
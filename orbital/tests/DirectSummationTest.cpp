@@ -0,0 +1,152 @@
+// Checks the AVX2 direct summation kernel against the scalar one, and that it stays finite where its
+// single precision seed runs out of range.
+
+#include "Tests.hpp"
+
+#include "DirectSummation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//======================================================================================================================
+
+namespace
+{
+    using InstructionSet = CpuFeatures::InstructionSet;
+
+    struct Cluster
+    {
+        std::vector<double> x, y, z, mass;
+        std::vector<double> ax, ay, az, potential;
+
+        void Resize()
+        {
+            for (std::vector<double> * column : {&ax, &ay, &az, &potential})
+            {
+                column->assign(x.size(), 0.0);
+            }
+        }
+
+        [[nodiscard]]
+        Gravity::Bodies View() const { return Gravity::Bodies{x.data(), y.data(), z.data(), mass.data(), x.size()}; }
+
+        [[nodiscard]]
+        Gravity::Forces Output() { return Gravity::Forces{ax.data(), ay.data(), az.data(), potential.data()}; }
+    };
+
+    // Uniform ball with masses over two orders of magnitude
+    Cluster RandomCluster(size_t const count)
+    {
+        std::mt19937 generator(453);
+        std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+        std::uniform_real_distribution<double> mass(0.01, 1.0);
+        Cluster cluster{};
+        while (cluster.x.size() < count)
+        {
+            double const px = coordinate(generator), py = coordinate(generator), pz = coordinate(generator);
+            if (px * px + py * py + pz * pz <= 1.0)
+            {
+                cluster.x.push_back(px);
+                cluster.y.push_back(py);
+                cluster.z.push_back(pz);
+                cluster.mass.push_back(mass(generator));
+            }
+        }
+        cluster.Resize();
+        return cluster;
+    }
+
+    // Largest difference relative to the sum of the magnitudes of every pair's contribution. The net
+    // acceleration can cancel down to nothing, that sum can't, and each kernel's rounding is relative to it.
+    double MaxRelativeError(Cluster const & reference, Cluster const & candidate, double const softening)
+    {
+        double maxError = 0.0;
+        for (size_t i = 0; i < reference.x.size(); ++i)
+        {
+            double accelerationScale = 0.0;
+            for (size_t j = 0; j < reference.x.size(); ++j)
+            {
+                double const dx = reference.x[j] - reference.x[i];
+                double const dy = reference.y[j] - reference.y[i];
+                double const dz = reference.z[j] - reference.z[i];
+                double const distanceSquared = dx * dx + dy * dy + dz * dz + softening * softening;
+                if (i != j)
+                {
+                    accelerationScale += reference.mass[j] * std::sqrt(dx * dx + dy * dy + dz * dz) / (distanceSquared * std::sqrt(distanceSquared));
+                }
+            }
+            maxError = std::max({
+                maxError,
+                std::abs(reference.ax[i] - candidate.ax[i]) / accelerationScale,
+                std::abs(reference.ay[i] - candidate.ay[i]) / accelerationScale,
+                std::abs(reference.az[i] - candidate.az[i]) / accelerationScale,
+                std::abs(reference.potential[i] - candidate.potential[i]) / std::abs(reference.potential[i])
+            });
+        }
+        return maxError;
+    }
+
+    bool AllFinite(Cluster const & cluster)
+    {
+        for (std::vector<double> const * column : {&cluster.ax, &cluster.ay, &cluster.az, &cluster.potential})
+        {
+            if (std::any_of(column->begin(), column->end(), [](double const value) { return std::isfinite(value) == false; }))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+//======================================================================================================================
+
+bool Tests::DirectSummation()
+{
+    if (CpuFeatures::IsSupported(InstructionSet::AVX2) == false)
+    {
+        std::printf("SKIP AVX2: not supported\n");
+        return true;
+    }
+
+    bool passed = true;
+    ThreadPool pool{};
+    ::DirectSummation solver{};
+
+    // Each 1/r is good to ~1e-13 after the Newton steps, the rest is FMA and summation order rounding
+    // on the order of 1e-16 per pair; both cases measure ~1e-14. 1e-12 keeps an order of magnitude over
+    // the 1/r bound, while a kernel that drops a source or a Newton step is off by 1e-8 or more.
+    constexpr size_t BodyCount = 2'000 + 3; // not a multiple of the vector width or a tile
+    for (double const softening : {1e-3, 0.0})
+    {
+        Cluster reference = RandomCluster(BodyCount);
+        Cluster candidate = RandomCluster(BodyCount);
+        solver.Evaluate(reference.View(), 1.0, softening, reference.Output(), pool, 0, InstructionSet::Scalar);
+        solver.Evaluate(candidate.View(), 1.0, softening, candidate.Output(), pool, 0, InstructionSet::AVX2);
+        passed &= Check(softening > 0.0 ? "AVX2 vs scalar, softened" : "AVX2 vs scalar, unsoftened", MaxRelativeError(reference, candidate, softening), 1e-12);
+    }
+
+    // An unsoftened pair 1e-21 apart, its squared distance is below the smallest normal float. The seed
+    // is clamped, so this must come out finite instead of NaN. Far pairs (1e25) only ever round to zero.
+    {
+        Cluster extremes = RandomCluster(8);
+        extremes.x[0] = 0.0;
+        extremes.y[0] = 0.0;
+        extremes.z[0] = 0.0;
+        extremes.x[1] = 1e-21;
+        extremes.y[1] = 0.0;
+        extremes.z[1] = 0.0;
+        extremes.x[7] = 1e25;
+        solver.Evaluate(extremes.View(), 1.0, 0.0, extremes.Output(), pool, 0, InstructionSet::AVX2);
+        bool const finite = AllFinite(extremes);
+        std::printf("%s AVX2 outside the float range\n", finite ? "PASS" : "FAIL");
+        passed &= finite;
+    }
+
+    return passed;
+}
+
+//======================================================================================================================
@@ -0,0 +1,174 @@
+// Checks every batched Kepler path against the scalar one and the scalar one against Kepler::Propagate.
+
+#include "Tests.hpp"
+
+#include "AlignedAllocator.hpp"
+#include "Kepler.hpp"
+#include "KeplerBatch.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//======================================================================================================================
+
+namespace
+{
+    using InstructionSet = CpuFeatures::InstructionSet;
+
+    // Random elliptic orbits over the whole batched range, padded to the lane count with circular ones
+    struct Orbits
+    {
+        explicit Orbits(size_t const count)
+        {
+            size_t const padded = (count + KeplerBatch::LaneCount - 1) / KeplerBatch::LaneCount * KeplerBatch::LaneCount;
+            for (AlignedVector<double> * column : {&a, &b, &e, &n, &tp, &px, &py, &pz, &qx, &qy, &qz, &x, &y, &z})
+            {
+                column->resize(padded, 0.0);
+            }
+            elements.resize(padded);
+
+            std::mt19937 generator(453);
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            double const twoPi = 6.28318530717958647693;
+            for (size_t i = 0; i < padded; ++i)
+            {
+                double const eccentricity = i < count ? 0.98 * unit(generator) : 0.0;
+                elements[i] = Kepler::FromMeanMotion(
+                    0.3 + 40.0 * unit(generator),
+                    eccentricity,
+                    0.01 + 2.0 * unit(generator),
+                    3.14159265358979323846 * unit(generator),
+                    twoPi * unit(generator),
+                    twoPi * unit(generator),
+                    twoPi * unit(generator),
+                    0.0
+                );
+
+                Kepler::PerifocalBasis const basis = Kepler::Basis(elements[i]);
+                e[i] = eccentricity;
+                a[i] = Kepler::SemiMajorAxis(elements[i]);
+                b[i] = a[i] * std::sqrt(1.0 - eccentricity * eccentricity);
+                n[i] = Kepler::MeanMotion(elements[i]);
+                tp[i] = elements[i].periapsisTime;
+                px[i] = basis.p.x;
+                py[i] = basis.p.y;
+                pz[i] = basis.p.z;
+                qx[i] = basis.q.x;
+                qy[i] = basis.q.y;
+                qz[i] = basis.q.z;
+            }
+        }
+
+        [[nodiscard]]
+        KeplerBatch::Columns View()
+        {
+            return KeplerBatch::Columns{
+                a.data(), b.data(), e.data(), n.data(), tp.data(),
+                px.data(), py.data(), pz.data(), qx.data(), qy.data(), qz.data(),
+                x.data(), y.data(), z.data(), x.size()
+            };
+        }
+
+        std::vector<Kepler::OrbitalElements> elements{};
+        AlignedVector<double> a, b, e, n, tp, px, py, pz, qx, qy, qz, x, y, z;
+    };
+
+    // The SIMD paths round differently from the scalar one (polynomial sin/cos, fused multiply-adds),
+    // starting with a few ulp of the unwrapped mean anomaly. Kepler's equation amplifies an error in
+    // the anomaly by up to 1 / (1 - e) near periapsis. Both kernels measure under one ulp of that here,
+    // so eight leaves a wide margin while a wrong coefficient or lane mix-up still lands far above it.
+    constexpr double UlpBudget = 8.0;
+
+    // Largest position difference relative to the orbit size, as a fraction of what rounding explains
+    double MaxErrorRatio(Orbits const & reference, Orbits const & candidate, double const time)
+    {
+        double const twoPi = 6.28318530717958647693;
+        double maxRatio = 0.0;
+        for (size_t i = 0; i < reference.x.size(); ++i)
+        {
+            double const meanAnomaly = std::abs(reference.n[i] * (time - reference.tp[i])) + twoPi;
+            double const allowed = UlpBudget * DBL_EPSILON * meanAnomaly / (1.0 - reference.e[i]);
+            double const scale = std::max(reference.a[i], 1.0);
+            double const error = std::max({
+                std::abs(reference.x[i] - candidate.x[i]),
+                std::abs(reference.y[i] - candidate.y[i]),
+                std::abs(reference.z[i] - candidate.z[i])
+            }) / scale;
+            maxRatio = std::max(maxRatio, error / allowed);
+        }
+        return maxRatio;
+    }
+
+}
+
+//======================================================================================================================
+
+bool Tests::KeplerBatch()
+{
+    constexpr size_t BodyCount = 10'000 + 3; // not a lane multiple, the padding must not matter
+    // Mean anomalies stay within a few thousand radians, much past that one ulp of it is already above the tolerance
+    constexpr double Times[] = {0.0, 1.0, -3.7, 1234.5};
+
+    // The SIMD budget grows with the mean anomaly, so these can go much further out
+    constexpr double SimdTimes[] = {0.0, 1.0, -3.7, 1234.5, 1.0e6};
+
+    bool passed = true;
+
+    // Scalar batch against the general closed-form solver
+    {
+        Orbits batch{BodyCount};
+        double error = 0.0;
+        for (double const time : Times)
+        {
+            KeplerBatch::Propagate(batch.View(), time, InstructionSet::Scalar);
+            for (size_t i = 0; i < BodyCount; ++i)
+            {
+                glm::dvec3 const expected = Kepler::Propagate(batch.elements[i], time).position;
+                double const scale = std::max(batch.a[i], 1.0);
+                error = std::max(error, std::abs(expected.x - batch.x[i]) / scale);
+                error = std::max(error, std::abs(expected.y - batch.y[i]) / scale);
+                error = std::max(error, std::abs(expected.z - batch.z[i]) / scale);
+            }
+        }
+        passed &= Check("Scalar vs Kepler::Propagate", error, 1e-11);
+    }
+
+    // Every SIMD path this CPU runs against the scalar one
+    for (InstructionSet const instructionSet : {InstructionSet::SSE42, InstructionSet::AVX2})
+    {
+        if (CpuFeatures::IsSupported(instructionSet) == false)
+        {
+            std::printf("SKIP %s: not supported\n", CpuFeatures::Name(instructionSet));
+            continue;
+        }
+
+        Orbits reference{BodyCount};
+        Orbits candidate{BodyCount};
+        double ratio = 0.0;
+        for (double const time : SimdTimes)
+        {
+            KeplerBatch::Propagate(reference.View(), time, InstructionSet::Scalar);
+            KeplerBatch::Propagate(candidate.View(), time, instructionSet);
+            ratio = std::max(ratio, MaxErrorRatio(reference, candidate, time));
+        }
+        passed &= Check(CpuFeatures::Name(instructionSet), ratio, 1.0); // in units of the rounding budget
+    }
+
+    // Falling back to scalar must stick and must be what the default overload runs
+    {
+        KeplerBatch::Select(InstructionSet::Scalar);
+        bool const selected = KeplerBatch::Selected() == InstructionSet::Scalar;
+        KeplerBatch::Select(InstructionSet::AVX2);
+        bool const clamped = KeplerBatch::Selected() == CpuFeatures::Detect();
+        std::printf("%s Select\n", selected && clamped ? "PASS" : "FAIL");
+        passed &= selected && clamped;
+    }
+
+    return passed;
+}
+
+//======================================================================================================================
@@ -0,0 +1,116 @@
+// Seeds a scene-like planetary system with NBodySystem::AddCentralSystem and integrates it for a few
+// orbits of the outermost planet. If the seeded speeds don't match the central mass, planets leave
+// their Kepler orbits within the first revolution and the central body drifts away.
+
+#include "Tests.hpp"
+
+#include "Kepler.hpp"
+#include "NBodySystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+
+//======================================================================================================================
+
+namespace
+{
+    // Same layout as the app: G = 1, the Sun's mass is Earth's n^2 a^3, real planet to Sun mass ratios
+    constexpr double SunMass = 0.2 * 0.2 * 5.0 * 5.0 * 5.0;
+    constexpr double SemiMajorAxes[] = {3.0, 4.0, 5.0, 6.0, 8.0, 10.0, 12.0, 14.0};
+    constexpr double Eccentricities[] = {0.2, 0.01, 0.0, 0.09, 0.05, 0.06, 0.05, 0.01};
+    constexpr double MassRatios[] = {1.66e-7, 2.45e-6, 3.00e-6, 3.23e-7, 9.55e-4, 2.86e-4, 4.37e-5, 5.15e-5};
+    constexpr size_t PlanetCount = std::size(SemiMajorAxes);
+    constexpr double TimeStep = 0.01;
+
+    struct Drift
+    {
+        double excursion = 0.0; // furthest any planet got outside [periapsis, apoapsis], relative to it
+        double sunOffset = 0.0; // furthest the Sun got from the barycentre, over sum(m a (1 + e)) / M
+        double energy = 0.0;    // relative, since the first step
+    };
+
+    Drift Integrate(double const massScale)
+    {
+        double const twoPi = 6.28318530717958647693;
+
+        std::vector<Kepler::OrbitalElements> orbits(PlanetCount);
+        std::vector<double> masses(PlanetCount);
+        double wobble = 0.0;
+        for (size_t i = 0; i < PlanetCount; ++i)
+        {
+            double const a = SemiMajorAxes[i];
+            double const spread = static_cast<double>(i);
+            orbits[i] = Kepler::FromMeanMotion(
+                a, Eccentricities[i], std::sqrt(SunMass / (a * a * a)), 0.05 * spread, 4.7, 1.6, 0.7 * spread, 0.0
+            );
+            masses[i] = SunMass * MassRatios[i] * massScale;
+            wobble += MassRatios[i] * massScale * a * (1.0 + Eccentricities[i]);
+        }
+
+        NBodySystem system{};
+        system.GetSettings().solver = NBodySystem::ForceSolver::DIRECT;
+        size_t const sun = system.AddCentralSystem(SunMass, orbits, masses, 0.0);
+
+        // Total momentum is zero, so the barycentre stays where it starts
+        glm::dvec3 barycentre{0.0};
+        double totalMass = SunMass;
+        for (size_t i = 0; i < PlanetCount; ++i)
+        {
+            barycentre += masses[i] * system.Position(sun + 1 + i);
+            totalMass += masses[i];
+        }
+        barycentre /= totalMass;
+
+        // Three revolutions of the outermost planet
+        double const duration = 3.0 * twoPi / Kepler::MeanMotion(orbits.back());
+        size_t const steps = static_cast<size_t>(duration / TimeStep);
+
+        Drift drift{};
+        for (size_t step = 0; step < steps; ++step)
+        {
+            system.Step(TimeStep);
+            glm::dvec3 const sunPosition = system.Position(sun);
+            drift.sunOffset = std::max(drift.sunOffset, glm::length(sunPosition - barycentre) / wobble);
+            for (size_t i = 0; i < PlanetCount; ++i)
+            {
+                double const radius = glm::length(system.Position(sun + 1 + i) - sunPosition);
+                double const periapsis = SemiMajorAxes[i] * (1.0 - Eccentricities[i]);
+                double const apoapsis = SemiMajorAxes[i] * (1.0 + Eccentricities[i]);
+                drift.excursion = std::max({drift.excursion, 1.0 - radius / periapsis, radius / apoapsis - 1.0});
+            }
+        }
+        drift.energy = std::abs(system.EnergyDrift());
+        return drift;
+    }
+}
+
+//======================================================================================================================
+
+bool Tests::NBody()
+{
+    bool passed = true;
+
+    // Near-massless planets follow their Kepler orbits up to the integrator's error (a few 1e-5 at this
+    // step). A seeding speed off by even one percent moves the radius by a few percent.
+    {
+        Drift const drift = Integrate(1e-6);
+        passed &= Check("Test particles outside their Kepler orbits", drift.excursion, 1e-3);
+    }
+
+    // With real masses the scene's Jupiter sits close enough to pull its neighbours a few percent off
+    // their starting orbits, but nothing escapes or falls in. The Sun stays within sum(m r) / M of the
+    // barycentre, r being allowed the same excursion; without the recoil it would drift ~30 times further.
+    {
+        Drift const drift = Integrate(1.0);
+        passed &= Check("Planets outside their Kepler orbits", drift.excursion, 0.15);
+        passed &= Check("Sun offset from the barycentre over its wobble", drift.sunOffset, 1.15);
+        passed &= Check("Planets energy drift", drift.energy, 1e-5);
+    }
+
+    return passed;
+}
+
+//======================================================================================================================
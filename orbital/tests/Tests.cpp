@@ -0,0 +1,52 @@
+// Runs every check, or only the one named on the command line so ctest can list them separately.
+// Exits non-zero if any comparison fails.
+
+#include "Tests.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+//======================================================================================================================
+
+bool Tests::Check(char const * what, double const error, double const tolerance)
+{
+    bool const passed = error <= tolerance;
+    std::printf("%s %s: max error %.3e (tolerance %.3g)\n", passed ? "PASS" : "FAIL", what, error, tolerance);
+    return passed;
+}
+
+//======================================================================================================================
+
+int main(int const argc, char ** argv)
+{
+    struct Entry
+    {
+        char const * name;
+        bool (*run)();
+    };
+    static constexpr Entry Entries[] = {
+        {"DirectSummation", &Tests::DirectSummation},
+        {"KeplerBatch", &Tests::KeplerBatch},
+        {"NBody", &Tests::NBody},
+    };
+
+    bool passed = true;
+    bool ran = false;
+    for (Entry const & entry : Entries)
+    {
+        if (argc < 2 || std::strcmp(argv[1], entry.name) == 0)
+        {
+            std::printf("== %s\n", entry.name);
+            passed &= entry.run();
+            ran = true;
+        }
+    }
+    if (ran == false)
+    {
+        std::printf("No check named %s\n", argv[1]);
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
+
+//======================================================================================================================
@@ -0,0 +1,12 @@
+#pragma once
+
+// Every check in orbital-tests. Each prints a PASS/FAIL line per comparison and returns whether all passed.
+namespace Tests
+{
+    bool DirectSummation();
+    bool KeplerBatch();
+    bool NBody();
+
+    // Prints the comparison and returns error <= tolerance
+    bool Check(char const * what, double error, double tolerance);
+}